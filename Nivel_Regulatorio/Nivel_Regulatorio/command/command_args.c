@@ -0,0 +1,151 @@
+#include "command_args.h"
+#include <avr/pgmspace.h>
+
+void args_init(cmd_args_t* a, const char* cmd, const char* params) {
+	a->start = cmd;
+	a->p = params;
+	a->error_pos = ARGS_NO_ERROR;
+	a->dry_run = false;
+}
+
+static bool fail(cmd_args_t* a, const char* at) {
+	if (a->error_pos == ARGS_NO_ERROR) {
+		uint16_t pos = (uint16_t)(at - a->start);
+		a->error_pos = (pos < ARGS_NO_ERROR) ? (uint8_t)pos : ARGS_NO_ERROR - 1;
+	}
+	return false;
+}
+
+// Fin de token: ',' (se consume) o fin de comando
+static bool end_token(cmd_args_t* a, const char* q) {
+	if (*q == ',') {
+		a->p = q + 1;
+		return true;
+	}
+	if (args_at_end(*q)) {
+		a->p = q;
+		return true;
+	}
+	return fail(a, q);
+}
+
+// Acumula un dígito rechazando el desborde de uint32
+static bool push_digit(uint32_t* magnitude, char c) {
+	uint8_t d = (uint8_t)(c - '0');
+	if (*magnitude > 429496729UL || (*magnitude == 429496729UL && d > 5)) return false;
+	*magnitude = *magnitude * 10 + d;
+	return true;
+}
+
+// Número con signo opcional escalado a 10^decimals; con fraction=false un '.'
+// es un carácter inválido. Devuelve magnitud y signo por separado
+static bool parse_number(cmd_args_t* a, uint8_t decimals, bool fraction, bool* negative, uint32_t* magnitude) {
+	if (!args_ok(a)) return false;
+
+	const char* q = a->p;
+	*negative = false;
+	if (*q == '-' || *q == '+') {
+		*negative = (*q == '-');
+		q++;
+	}
+
+	*magnitude = 0;
+	uint8_t digits = 0;
+	while (*q >= '0' && *q <= '9') {
+		if (!push_digit(magnitude, *q)) return fail(a, q);
+		digits++;
+		q++;
+	}
+
+	uint8_t frac_digits = 0;
+	if (fraction && *q == '.') {
+		q++;
+		while (*q >= '0' && *q <= '9') {
+			if (frac_digits < decimals) {
+				if (!push_digit(magnitude, *q)) return fail(a, q);
+				frac_digits++;
+			}
+			digits++;
+			q++;
+		}
+	}
+	if (digits == 0) return fail(a, q);
+
+	// Completar la escala si vinieron menos decimales de los pedidos
+	while (frac_digits < decimals) {
+		if (!push_digit(magnitude, '0')) return fail(a, q);
+		frac_digits++;
+	}
+
+	return end_token(a, q);
+}
+
+static bool to_int32(cmd_args_t* a, const char* token, bool negative, uint32_t magnitude, int32_t* value) {
+	if (magnitude > (negative ? 2147483648UL : 2147483647UL)) return fail(a, token);
+	*value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+	return true;
+}
+
+bool args_int(cmd_args_t* a, int32_t* value) {
+	const char* token = a->p;
+	bool negative;
+	uint32_t magnitude;
+	if (!parse_number(a, 0, false, &negative, &magnitude)) return false;
+	return to_int32(a, token, negative, magnitude, value);
+}
+
+bool args_uint(cmd_args_t* a, uint32_t* value) {
+	const char* token = a->p;
+	bool negative;
+	uint32_t magnitude;
+	if (!parse_number(a, 0, false, &negative, &magnitude)) return false;
+	if (negative && magnitude != 0) return fail(a, token);
+	*value = magnitude;
+	return true;
+}
+
+bool args_fixed(cmd_args_t* a, uint8_t decimals, int32_t* value) {
+	const char* token = a->p;
+	bool negative;
+	uint32_t magnitude;
+	if (!parse_number(a, decimals, true, &negative, &magnitude)) return false;
+	return to_int32(a, token, negative, magnitude, value);
+}
+
+bool args_int_range(cmd_args_t* a, int32_t min, int32_t max, int32_t* value) {
+	const char* token = a->p;
+	int32_t v;
+	if (!args_int(a, &v)) return false;
+	if (v < min || v > max) return fail(a, token);
+	*value = v;
+	return true;
+}
+
+bool args_word(cmd_args_t* a, const char** word, uint8_t* len) {
+	if (!args_ok(a)) return false;
+
+	const char* q = a->p;
+	while (!args_at_end(*q) && *q != ',') q++;
+	if (q == a->p) return fail(a, q);
+	*word = a->p;
+	*len = (uint8_t)(q - a->p);
+	return end_token(a, q);
+}
+
+bool args_match_P(cmd_args_t* a, const char* word_P) {
+	if (!args_ok(a)) return false;
+
+	const char* q = a->p;
+	char c;
+	while ((c = pgm_read_byte(word_P++)) != '\0') {
+		if (*q++ != c) return false;
+	}
+	if (*q != ',' && !args_at_end(*q)) return false;
+	return end_token(a, q);
+}
+
+bool args_end(cmd_args_t* a) {
+	if (!args_ok(a)) return false;
+	if (!args_at_end(*a->p)) return fail(a, a->p);
+	return true;
+}
@@ -0,0 +1,59 @@
+#ifndef COMMAND_ARGS_H
+#define COMMAND_ARGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Lectura de parámetros "a,b,c" en una sola pasada sobre el buffer del frame,
+// sin copias ni atoi. Cada lectura consume un token y la coma que lo sigue.
+// El primer error queda registrado con su posición (índice dentro del
+// comando) y las lecturas posteriores fallan sin avanzar. Un ';' termina el
+// comando igual que '\0' (subcomandos de un frame batch).
+
+#define ARGS_NO_ERROR 0xFF
+
+typedef struct {
+	const char* start;      // Inicio del comando (referencia de las posiciones)
+	const char* p;          // Cursor
+	uint8_t error_pos;      // ARGS_NO_ERROR si no hubo errores
+	bool dry_run;           // Batch: validar parámetros sin ejecutar
+} cmd_args_t;
+
+void args_init(cmd_args_t* a, const char* cmd, const char* params);
+
+// Entero con signo de 32 bits (rechaza desbordes y tokens vacíos)
+bool args_int(cmd_args_t* a, int32_t* value);
+
+// Entero sin signo de 32 bits (tiempos en us)
+bool args_uint(cmd_args_t* a, uint32_t* value);
+
+// Entero acotado a [min, max]
+bool args_int_range(cmd_args_t* a, int32_t min, int32_t max, int32_t* value);
+
+// Decimal con signo escalado a 10^decimals ("12.5" con 2 -> 1250). Los
+// decimales sobrantes se truncan hacia cero
+bool args_fixed(cmd_args_t* a, uint8_t decimals, int32_t* value);
+
+// Token de texto sin copiar: *word apunta al buffer, *len hasta ',' o fin
+bool args_word(cmd_args_t* a, const char** word, uint8_t* len);
+
+// true (y consume el token) si el siguiente es exactamente word_P (flash)
+bool args_match_P(cmd_args_t* a, const char* word_P);
+
+// true si no quedan parámetros; si quedan, registra error en el cursor
+bool args_end(cmd_args_t* a);
+
+static inline bool args_at_end(char c) {
+	return c == '\0' || c == ';';
+}
+
+static inline bool args_ok(const cmd_args_t* a) {
+	return a->error_pos == ARGS_NO_ERROR;
+}
+
+// Resto sin consumir (p.ej. para devolver el token de TP:)
+static inline const char* args_rest(const cmd_args_t* a) {
+	return a->p;
+}
+
+#endif // COMMAND_ARGS_H
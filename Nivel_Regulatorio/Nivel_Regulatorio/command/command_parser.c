@@ -1,270 +1,1300 @@
 #include "command_parser.h"
+#include "command_args.h"
+#include "command_seq.h"
 #include "../drivers/uart_driver.h"
 #include "../drivers/stepper_driver.h"
 #include "../config/system_config.h"
 #include "../config/command_protocol.h"
+#include "../config/parameters.h"
 #include "../drivers/servo_driver.h"
 #include "../limits/limit_switch.h"
 #include "../drivers/gripper_driver.h"
+#include "../moves/position_correction.h"
+#include "../drivers/position_trigger.h"
+#include "../moves/position_history.h"
+#include "../moves/macro_engine.h"
+#include "../moves/units.h"
+#include "../moves/motion_preset.h"
+#include "../drivers/system_clock.h"
+#include "../drivers/step_queue.h"
+#include "telemetry.h"
+#include "event_log.h"
+#include "format_benchmark.h"
+#include "gcode_interpreter.h"
+#include "message_catalog.h"
 #include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
+#include <avr/pgmspace.h>
 
-// Parser manual simple para dos n�meros
-static bool parse_two_integers(const char* str, int* x, int* y) {
-	char temp_str[32];
-	char* comma_pos;
+// Cada comando es un handler que lee sus parámetros con command_args y
+// escribe la respuesta en r. Si r queda vacío no se envía nada (el handler
+// ya respondió por su cuenta o el comando es silencioso).
+typedef void (*command_handler_t)(cmd_args_t* a, response_t* r);
+
+typedef struct {
+	char opcode[4];             // Texto hasta ':' (máx. 3 caracteres)
+	command_handler_t handler;
+	uint8_t flags;
+} command_entry_t;
+
+// Admitido dentro de un frame batch: el handler respeta a->dry_run
+#define CMD_BATCH 0x01
+
+// Error de parámetros con la posición del primer carácter inválido
+static void resp_param_error(response_t* r, msg_id_t id, const cmd_args_t* a) {
+	resp_msg(r, id);
+	resp_str_P(r, PSTR(":AT="));
+	resp_uint(r, a->error_pos);
+}
+
+void command_format_system_state(response_t* r, int32_t h_pos, int32_t v_pos,
+	uint8_t servo1_pos, uint8_t servo2_pos, gripper_state_t gripper_state, int16_t gripper_pos) {
+	resp_msg(r, MSG_SYSTEM_STATE);
+	resp_str_P(r, PSTR(":H="));
+	resp_int(r, h_pos);
+	resp_str_P(r, PSTR(",V="));
+	resp_int(r, v_pos);
+	resp_str_P(r, PSTR(",S1="));
+	resp_uint(r, servo1_pos);
+	resp_str_P(r, PSTR(",S2="));
+	resp_uint(r, servo2_pos);
+	resp_str_P(r, PSTR(",G="));
+	resp_str_P(r, gripper_state_name(gripper_state));
+	resp_str_P(r, PSTR(",GP="));
+	resp_int(r, gripper_pos);
+}
+
+// ========== MOVIMIENTO ==========
+
+// Campos opcionales ",v[,a]" de M y MA: velocidad (pasos/s) y aceleración
+// (pasos/s²) solo para este movimiento, para ambos ejes; 0 o ausente = los del eje
+static bool args_move_limits(cmd_args_t* a, move_limits_t* limits) {
+	int32_t speed = 0, accel = 0;
+	if (!args_at_end(*args_rest(a))) {
+		args_int_range(a, 0, MAX_STEP_RATE, &speed);
+		if (args_ok(a) && !args_at_end(*args_rest(a))) {
+			args_int_range(a, 0, UINT16_MAX, &accel);
+		}
+	}
+	limits->h_speed = limits->v_speed = (uint16_t)speed;
+	limits->h_accel = limits->v_accel = (uint16_t)accel;
+	return args_end(a);
+}
+
+// ",V=<v>,A=<a>" con los campos que se dieron
+static void resp_move_limits(response_t* r, const move_limits_t* limits) {
+	if (limits->h_speed) {
+		resp_str_P(r, PSTR(",V="));
+		resp_uint(r, limits->h_speed);
+	}
+	if (limits->h_accel) {
+		resp_str_P(r, PSTR(",A="));
+		resp_uint(r, limits->h_accel);
+	}
+}
+
+static void cmd_move_xy(cmd_args_t* a, response_t* r) {  // M:x,y[,v[,a]] (mm con hasta 2 decimales, relativo)
+	// Centésimas de mm: los decimales sobrantes se truncan
+	int32_t x, y;
+	move_limits_t limits;
+	if (args_fixed(a, 2, &x) && args_fixed(a, 2, &y) && args_move_limits(a, &limits)) {
+		if (step_queue_is_active()) {
+			resp_msg(r, MSG_ERR_STEP_QUEUE_BUSY);
+			return;
+		}
+		if (a->dry_run) return;
+		
+		// Convertir a pasos arrastrando la fracción de paso del movimiento anterior
+		int32_t h_steps_relative = units_relative_steps(UNITS_AXIS_H, x);
+		int32_t v_steps_relative = units_relative_steps(UNITS_AXIS_V, y);
+		
+		// Usar movimiento RELATIVO
+		command_seq_bind(SEQ_MOTION);
+		stepper_move_relative_limited(h_steps_relative, v_steps_relative, &limits);
+		
+		resp_msg(r, MSG_OK_MOVE_XY);
+		resp_char(r, ':');
+		units_resp_mm_pair(r, x, y);
+		resp_move_limits(r, &limits);
+	} else {
+		resp_msg(r, MSG_ERR_INVALID_PARAMS_MOVE_XY);
+		resp_str_P(r, PSTR(":<"));
+		resp_str(r, a->start + 2);
+		resp_str_P(r, PSTR(">:AT="));
+		resp_uint(r, a->error_pos);
+	}
+}
+
+static void cmd_move_abs(cmd_args_t* a, response_t* r) {  // MA:x,y[,v[,a]] (mm con hasta 2 decimales desde el origen)
+	int32_t x, y;
+	move_limits_t limits;
+	if (!args_fixed(a, 2, &x) || !args_fixed(a, 2, &y) || !args_move_limits(a, &limits)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_MOVE_ABS, a);
+		return;
+	}
+	if (step_queue_is_active()) {
+		resp_msg(r, MSG_ERR_STEP_QUEUE_BUSY);
+		return;
+	}
+	if (a->dry_run) return;
 	
-	// Copiar string para modificarlo
-	strncpy(temp_str, str, sizeof(temp_str) - 1);
-	temp_str[sizeof(temp_str) - 1] = '\0';
+	command_seq_bind(SEQ_MOTION);
+	stepper_move_absolute_limited(units_absolute_steps(UNITS_AXIS_H, x), units_absolute_steps(UNITS_AXIS_V, y), &limits);
 	
-	// Buscar la coma
-	comma_pos = strchr(temp_str, ',');
-	if (!comma_pos) return false;
+	resp_msg(r, MSG_OK_MOVE_ABS);
+	resp_char(r, ':');
+	units_resp_mm_pair(r, x, y);
+	resp_move_limits(r, &limits);
+}
+
+static void cmd_decel_stop(cmd_args_t* a, response_t* r) {  // SD - Stop con deceleración del perfil
+	resp_msg(r, stepper_decel_stop() ? MSG_OK_DECEL_STOP : MSG_ERR_NOT_MOVING);
+}
+
+static void cmd_stop(cmd_args_t* a, response_t* r) {  // S - Parada inmediata
+	macro_abort();
+	gcode_abort();
+	step_queue_clear();
+	stepper_stop_all();
+	resp_msg(r, MSG_OK_STOP);
+}
+
+static void cmd_soft_limits(cmd_args_t* a, response_t* r) {  // SL:h_min,h_max,v_min,v_max (mm, 2 decimales) | SL:OFF
+	int32_t values[4];
+	if (args_match_P(a, PSTR("OFF")) && args_end(a)) {
+		stepper_set_soft_limits(false, 0, 0, 0, 0);
+		resp_msg(r, MSG_OK_SOFT_LIMITS);
+		resp_str_P(r, PSTR(":OFF"));
+		return;
+	}
+	for (uint8_t i = 0; i < 4; i++) {
+		args_fixed(a, 2, &values[i]);
+	}
+	if (args_end(a)) {
+		stepper_set_soft_limits(true,
+			units_centi_to_steps(UNITS_AXIS_H, values[0]), units_centi_to_steps(UNITS_AXIS_H, values[1]),
+			units_centi_to_steps(UNITS_AXIS_V, values[2]), units_centi_to_steps(UNITS_AXIS_V, values[3]));
+		resp_msg(r, MSG_OK_SOFT_LIMITS);
+		resp_char(r, ':');
+		units_resp_mm_pair(r, values[0], values[1]);
+		resp_char(r, ',');
+		units_resp_mm_pair(r, values[2], values[3]);
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_SOFT_LIMITS, a);
+	}
+}
+
+static void cmd_jog(cmd_args_t* a, response_t* r) {  // J:h_vel,v_vel - Jog a velocidad constante (pasos/s con signo)
+	int32_t h_vel, v_vel;
+	if (args_int_range(a, INT16_MIN, INT16_MAX, &h_vel) && args_int_range(a, INT16_MIN, INT16_MAX, &v_vel) && args_end(a)) {
+		if (step_queue_is_active()) {
+			resp_msg(r, MSG_ERR_STEP_QUEUE_BUSY);
+			return;
+		}
+		command_seq_bind(SEQ_MOTION);
+		if (stepper_jog((int16_t)h_vel, (int16_t)v_vel)) {
+			resp_msg(r, MSG_OK_JOG);
+			resp_char(r, ':');
+			resp_int_pair(r, h_vel, v_vel);
+		} else {
+			resp_msg(r, MSG_ERR_JOG_NOT_ACTIVE);
+		}
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_JOG, a);
+	}
+}
+
+static void cmd_feed_hold(cmd_args_t* a, response_t* r) {  // FH - Feed hold (frenar y conservar destino)
+	resp_msg(r, stepper_feed_hold() ? MSG_OK_FEED_HOLD : MSG_ERR_FEED_HOLD_NOT_MOVING);
+}
+
+static void cmd_feed_resume(cmd_args_t* a, response_t* r) {  // FR - Reanudar movimiento tras feed hold
+	resp_msg(r, stepper_feed_resume() ? MSG_OK_FEED_RESUME : MSG_ERR_FEED_NOT_HELD);
+}
+
+static void cmd_feed_override(cmd_args_t* a, response_t* r) {  // FO:<pct> - Override de avance (10-200%)
+	int32_t percent;
+	if (args_int_range(a, 1, UINT16_MAX, &percent) && args_end(a)) {
+		uint16_t applied = stepper_set_feed_override((uint16_t)percent);
+		resp_msg(r, MSG_OK_FEED_OVERRIDE);
+		resp_char(r, ':');
+		resp_uint(r, applied);
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_FEED_OVERRIDE, a);
+	}
+}
+
+static void cmd_speeds(cmd_args_t* a, response_t* r) {  // V:h,v - Velocidad máxima (pasos/s, fuera de 1-15000 se ignora)
+	int32_t h_speed, v_speed;
+	if (args_int(a, &h_speed) && args_int(a, &v_speed) && args_end(a)) {
+		if (h_speed > 0 && h_speed <= 15000) {
+			horizontal_axis.max_speed = h_speed;
+		}
+		if (v_speed > 0 && v_speed <= 15000) {
+			vertical_axis.max_speed = v_speed;
+		}
+		resp_msg(r, MSG_OK_VELOCIDADES);
+		resp_char(r, ':');
+		resp_int_pair(r, horizontal_axis.max_speed, vertical_axis.max_speed);
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_VELOCIDADES, a);
+	}
+}
+
+// <nombre>=<valor>
+static void resp_param(response_t* r, param_id_t id) {
+	resp_str_P(r, param_name(id));
+	resp_char(r, '=');
+	resp_uint(r, param_get(id));
+}
+
+static void resp_param_result(response_t* r, param_result_t result, param_id_t id) {
+	switch (result) {
+		case PARAM_RANGE:
+			resp_msg(r, MSG_ERR_PARAM_RANGE);
+			resp_char(r, ':');
+			resp_uint(r, param_min(id));
+			resp_char(r, '-');
+			resp_uint(r, param_max(id));
+			break;
+		case PARAM_BUSY: resp_msg(r, MSG_ERR_PARAM_BUSY); break;
+		case PARAM_EMPTY: resp_msg(r, MSG_ERR_PARAM_EMPTY); break;
+		default: resp_msg(r, MSG_ERR_PARAM_UNKNOWN); break;
+	}
+}
+
+// Nombre del parámetro como primer token; PARAM_COUNT (ya respondido) si no existe
+static param_id_t args_param(cmd_args_t* a, response_t* r) {
+	const char* name;
+	uint8_t len = 0;
+	if (!args_word(a, &name, &len)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PARAM, a);
+		return PARAM_COUNT;
+	}
+	param_id_t id = param_find(name, len);
+	if (id == PARAM_COUNT) resp_msg(r, MSG_ERR_PARAM_UNKNOWN);
+	return id;
+}
+
+static void cmd_param_get(cmd_args_t* a, response_t* r) {  // PG:<nombre> - Valor actual
+	param_id_t id = args_param(a, r);
+	if (id == PARAM_COUNT) return;
+	if (!args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PARAM, a);
+		return;
+	}
+	resp_msg(r, MSG_PARAM);
+	resp_char(r, ':');
+	resp_param(r, id);
+}
+
+static void cmd_param_set(cmd_args_t* a, response_t* r) {  // PS:<nombre>,<valor> - Cambiar en RAM (PW para guardar)
+	param_id_t id = args_param(a, r);
+	if (id == PARAM_COUNT) return;
+	int32_t value;
+	if (!args_int_range(a, 0, UINT16_MAX, &value) || !args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PARAM, a);
+		return;
+	}
+	param_result_t result = param_set(id, (uint16_t)value);
+	if (result != PARAM_OK) {
+		resp_param_result(r, result, id);
+		return;
+	}
+	resp_msg(r, MSG_OK_PARAM);
+	resp_char(r, ':');
+	resp_param(r, id);
+}
+
+static void cmd_param_list(cmd_args_t* a, response_t* r) {  // PL? - Una línea por parámetro: nombre=valor,min,max,default
+	char line[48];
+	response_t l;
+	for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+		resp_init(&l, line, sizeof(line));
+		resp_msg(&l, MSG_PARAM);
+		resp_char(&l, ':');
+		resp_param(&l, (param_id_t)i);
+		resp_char(&l, ',');
+		resp_uint(&l, param_min((param_id_t)i));
+		resp_char(&l, ',');
+		resp_uint(&l, param_max((param_id_t)i));
+		resp_char(&l, ',');
+		resp_uint(&l, param_default((param_id_t)i));
+		uart_send_response(line);
+	}
+	resp_msg(r, MSG_OK_PARAMS);
+	resp_char(r, ':');
+	resp_uint(r, PARAM_COUNT);
+}
+
+static void cmd_param_save(cmd_args_t* a, response_t* r) {  // PW - Guardar en EEPROM
+	if (!param_save()) {
+		resp_msg(r, MSG_ERR_PARAM_BUSY);
+		return;
+	}
+	resp_msg(r, MSG_OK_PARAM_SAVE);
+}
+
+static void cmd_param_load(cmd_args_t* a, response_t* r) {  // PR | PR:DEF - Recargar de EEPROM o valores de fábrica
+	bool defaults = args_match_P(a, PSTR("DEF"));
+	if (!args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PARAM, a);
+		return;
+	}
+	param_result_t result = defaults ? param_load_defaults() : param_load();
+	if (result != PARAM_OK) {
+		resp_param_result(r, result, PARAM_COUNT);
+		return;
+	}
+	resp_msg(r, MSG_OK_PARAM_LOAD);
+	resp_str_P(r, defaults ? PSTR(":DEFAULTS") : PSTR(":EEPROM"));
+}
+
+// <nombre>=vh,vv,ah,av,servo_ms,gripper_ms
+static void resp_preset(response_t* r, preset_id_t id) {
+	const motion_preset_t* p = motion_preset_get(id);
+	resp_str_P(r, motion_preset_name(id));
+	resp_char(r, '=');
+	resp_int_pair(r, p->speed_h, p->speed_v);
+	resp_char(r, ',');
+	resp_int_pair(r, p->accel_h, p->accel_v);
+	resp_char(r, ',');
+	resp_int_pair(r, p->servo_ms_per_deg, p->gripper_delay_ms);
+}
+
+static void cmd_preset(cmd_args_t* a, response_t* r) {  // MP:<nombre>|AUTO | MP:<nombre>,vh,vv,ah,av,servo_ms,gripper_ms
+	if (args_match_P(a, PSTR("AUTO"))) {
+		if (!args_end(a)) {
+			resp_param_error(r, MSG_ERR_INVALID_PARAMS_PRESET, a);
+			return;
+		}
+		motion_preset_set_auto(true);
+		resp_msg(r, MSG_OK_PRESET);
+		resp_str_P(r, PSTR(":AUTO"));
+		return;
+	}
+	
+	const char* name;
+	uint8_t len = 0;
+	if (!args_word(a, &name, &len)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PRESET, a);
+		return;
+	}
+	preset_id_t id = motion_preset_find(name, len);
+	if (id == PRESET_COUNT) {
+		resp_msg(r, MSG_ERR_PRESET_UNKNOWN);
+		return;
+	}
 	
-	// Dividir en dos strings
-	*comma_pos = '\0';  // Terminar primer n�mero
+	if (args_at_end(*args_rest(a))) {
+		motion_preset_select(id);
+		resp_msg(r, MSG_OK_PRESET);
+		resp_char(r, ':');
+		resp_str_P(r, motion_preset_name(id));
+		return;
+	}
 	
-	// Convertir usando atoi
-	*x = atoi(temp_str);
-	*y = atoi(comma_pos + 1);
+	// Definir valores: velocidades y aceleraciones 0 = las de los parámetros
+	int32_t speed_h, speed_v, accel_h, accel_v, servo_ms, gripper_ms;
+	if (!args_int_range(a, 0, MAX_STEP_RATE, &speed_h) || !args_int_range(a, 0, MAX_STEP_RATE, &speed_v) ||
+		!args_int_range(a, 0, UINT16_MAX, &accel_h) || !args_int_range(a, 0, UINT16_MAX, &accel_v) ||
+		!args_int_range(a, 0, UINT8_MAX, &servo_ms) ||
+		!args_int_range(a, GRIPPER_MIN_DELAY / 1000, GRIPPER_MAX_DELAY / 1000, &gripper_ms) || !args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_PRESET, a);
+		return;
+	}
+	motion_preset_t preset = {
+		(uint16_t)speed_h, (uint16_t)speed_v, (uint16_t)accel_h, (uint16_t)accel_v,
+		(uint8_t)servo_ms, (uint8_t)gripper_ms
+	};
+	motion_preset_set(id, &preset);
+	resp_msg(r, MSG_OK_PRESET_SET);
+	resp_char(r, ':');
+	resp_preset(r, id);
+}
+
+static void cmd_preset_status(cmd_args_t* a, response_t* r) {  // MP? - Activo, modo y valores de cada preset
+	resp_msg(r, MSG_PRESET);
+	resp_char(r, ':');
+	resp_str_P(r, motion_preset_name(motion_preset_active()));
+	resp_str_P(r, PSTR(",AUTO="));
+	resp_uint(r, motion_preset_is_auto() ? 1 : 0);
+	for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+		resp_char(r, ';');
+		resp_preset(r, (preset_id_t)i);
+	}
+}
+
+static void cmd_position(cmd_args_t* a, response_t* r) {  // XY? - Posición actual en pasos y milímetros
+	int32_t h_pos_steps = 0;
+	int32_t v_pos_steps = 0;
+	stepper_get_position(&h_pos_steps, &v_pos_steps);
 	
-	return true;
+	resp_msg(r, MSG_OK_XY);
+	resp_str_P(r, PSTR(":STEPS:"));
+	resp_int_pair(r, h_pos_steps, v_pos_steps);
+	resp_str_P(r, PSTR(",MM:"));
+	units_resp_mm_pair(r, units_steps_to_centi(UNITS_AXIS_H, h_pos_steps), units_steps_to_centi(UNITS_AXIS_V, v_pos_steps));
 }
 
-void uart_parse_command(const char* cmd) {
-	char response[128];
+static void cmd_calibration_start(cmd_args_t* a, response_t* r) {  // CS - Calibration Start
+	stepper_start_calibration();
+	resp_msg(r, MSG_OK_CALIBRATION_STARTED);
+}
+
+static void cmd_calibration_end(cmd_args_t* a, response_t* r) {  // CE - Calibration End
+	stepper_stop_calibration();
+	resp_msg(r, MSG_OK_CALIBRATION_ENDED);
+}
+
+static void cmd_snapshot(cmd_args_t* a, response_t* r) {  // RP - Take Progress Snapshot
+	// Tomar snapshot del progreso actual SILENCIOSAMENTE (no enviar nada durante movimiento)
+	extern uint8_t snapshot_count;
+	extern progress_snapshot_t snapshots[];
+	
+	bool is_moving = stepper_is_moving();
+	
+	if (is_moving && snapshot_count < MAX_SNAPSHOTS) {
+		snapshots[snapshot_count].h_centi = units_steps_to_centi(UNITS_AXIS_H, relative_h_counter);
+		snapshots[snapshot_count].v_centi = units_steps_to_centi(UNITS_AXIS_V, relative_v_counter);
+		snapshots[snapshot_count].h_steps = relative_h_counter;
+		snapshots[snapshot_count].v_steps = relative_v_counter;
+		
+		snapshot_count++;
+		
+		// NO RESPONDER NADA durante el movimiento - evita interrupciones
+		return;
+	}
 	
-	if (cmd[0] == CMD_MOVE_XY && cmd[1] == ':') {
-		int x, y;
-		if (parse_two_integers(cmd + 2, &x, &y)) {
-			// Convertir mm a pasos (RELATIVO)
-			int32_t h_steps_relative = (int32_t)(x * STEPS_PER_MM_H);
-			int32_t v_steps_relative = (int32_t)(y * STEPS_PER_MM_V);
-			
-			// Usar movimiento RELATIVO
-			stepper_move_relative(h_steps_relative, v_steps_relative);
-			
-			snprintf(response, sizeof(response), "OK:MOVE_XY:%d,%d", x, y);
-			} else {
-			snprintf(response, sizeof(response), "ERR:INVALID_PARAMS_MOVE_XY:<%s>", cmd + 2);
+	// Solo responder errores cuando no se está moviendo
+	resp_msg(r, is_moving ? MSG_SNAPSHOT_ERROR_MAX_REACHED : MSG_SNAPSHOT_ERROR_NOT_MOVING);
+}
+
+// ========== CORRECCIÓN Y DISPAROS ==========
+
+static void cmd_position_error(cmd_args_t* a, response_t* r) {  // E:h_err,v_err - Error de posición medido (pasos)
+	int32_t h_err, v_err;
+	if (args_int(a, &h_err) && args_int(a, &v_err) && args_end(a)) {
+		position_correction_set_error(h_err, v_err);
+		resp_msg(r, MSG_OK_E);
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_ERROR, a);
+	}
+}
+
+static void cmd_correction_stop(cmd_args_t* a, response_t* r) {  // EX - Salir del lazo de corrección
+	position_correction_stop();
+	resp_msg(r, MSG_OK_CORRECTION_STOP);
+}
+
+static void cmd_correction_gains(cmd_args_t* a, response_t* r) {  // KG:kp,ki,vmax - Ganancias (centésimas)
+	int32_t kp, ki, vmax;
+	if (args_int_range(a, 0, UINT16_MAX, &kp) && args_int_range(a, 0, UINT16_MAX, &ki) &&
+		args_int_range(a, 1, UINT16_MAX, &vmax) && args_end(a)) {
+		position_correction_set_gains((uint16_t)kp, (uint16_t)ki, (uint16_t)vmax);
+		uint16_t g_kp, g_ki, g_vmax;
+		position_correction_get_gains(&g_kp, &g_ki, &g_vmax);
+		resp_msg(r, MSG_OK_CORRECTION_GAINS);
+		resp_char(r, ':');
+		resp_uint(r, g_kp);
+		resp_char(r, ',');
+		resp_uint(r, g_ki);
+		resp_char(r, ',');
+		resp_uint(r, g_vmax);
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_GAINS, a);
+	}
+}
+
+static void cmd_trigger_add(cmd_args_t* a, response_t* r) {  // TA:H|V,p1,p2,... - Agregar disparos (pasos absolutos)
+	trigger_axis_t axis;
+	char axis_char;
+	if (args_match_P(a, PSTR("H"))) {
+		axis = TRIGGER_AXIS_H;
+		axis_char = 'H';
+	} else if (args_match_P(a, PSTR("V"))) {
+		axis = TRIGGER_AXIS_V;
+		axis_char = 'V';
+	} else {
+		resp_msg(r, MSG_ERR_INVALID_PARAMS_TRIGGER);
+		return;
+	}
+	
+	// La ISR recorre la lista durante el movimiento y solo se arma al arrancar
+	if (stepper_is_moving() || step_queue_is_active()) {
+		resp_msg(r, MSG_ERR_TRIGGER_BUSY);
+		return;
+	}
+	
+	bool full = false;
+	while (!args_at_end(*args_rest(a))) {
+		int32_t position;
+		if (!args_int(a, &position)) {
+			resp_param_error(r, MSG_ERR_INVALID_PARAMS_TRIGGER, a);
+			return;
+		}
+		if (!position_trigger_add(axis, position)) {
+			full = true;
+			break;
 		}
 	}
 	
-	else if (cmd[0] == 'S') {  // CMD_STOP
-		stepper_stop_all();
-		snprintf(response, sizeof(response), "OK:STOP");
+	resp_msg(r, full ? MSG_ERR_TRIGGER_LIST_FULL : MSG_OK_TRIGGERS);
+	resp_char(r, ':');
+	resp_char(r, axis_char);
+	resp_char(r, ',');
+	resp_uint(r, position_trigger_count(axis));
+}
+
+static void cmd_trigger_clear(cmd_args_t* a, response_t* r) {  // TC - Borrar listas de disparo
+	position_trigger_clear();
+	resp_msg(r, MSG_OK_TRIGGERS_CLEARED);
+}
+
+static void cmd_trigger_mode(cmd_args_t* a, response_t* r) {  // TM:<bits> - 1=pin, 2=evento, 3=ambos
+	int32_t mode;
+	if (args_int_range(a, 0, UINT8_MAX, &mode) && args_end(a)) {
+		position_trigger_set_mode((uint8_t)mode);
+	}
+	resp_msg(r, MSG_OK_TRIGGER_MODE);
+	resp_char(r, ':');
+	resp_uint(r, position_trigger_get_mode());
+}
+
+static void cmd_trigger_status(cmd_args_t* a, response_t* r) {  // T? - Estado de disparos
+	resp_msg(r, MSG_TRIGGERS);
+	resp_str_P(r, PSTR(":H="));
+	resp_uint(r, position_trigger_count(TRIGGER_AXIS_H));
+	resp_str_P(r, PSTR(",V="));
+	resp_uint(r, position_trigger_count(TRIGGER_AXIS_V));
+	resp_str_P(r, PSTR(",MODE="));
+	resp_uint(r, position_trigger_get_mode());
+	resp_str_P(r, PSTR(",DROPPED="));
+	resp_uint(r, position_trigger_get_dropped());
+}
+
+// ========== RELOJ E HISTORIAL ==========
+
+static void cmd_clock(cmd_args_t* a, response_t* r) {  // CK? - Reloj del firmware (us)
+	resp_msg(r, MSG_CLOCK);
+	resp_char(r, ':');
+	resp_uint(r, system_clock_micros());
+}
+
+static void cmd_ping(cmd_args_t* a, response_t* r) {  // TP:<token> - Ping de sincronización (t_rx del frame, t_tx)
+	resp_msg(r, MSG_PONG);
+	resp_char(r, ':');
+	resp_str(r, args_rest(a));
+	resp_char(r, ',');
+	resp_uint(r, uart_get_frame_timestamp());
+	resp_char(r, ',');
+	resp_uint(r, system_clock_micros());
+}
+
+static void cmd_history_period(cmd_args_t* a, response_t* r) {  // PH:<ticks> - Periodo de muestreo del historial (0=off)
+	int32_t ticks;
+	if (args_int_range(a, 0, UINT8_MAX, &ticks) && args_end(a)) {
+		position_history_set_period((uint8_t)ticks);
+		resp_msg(r, MSG_OK_HISTORY_PERIOD);
+		resp_char(r, ':');
+		resp_uint(r, position_history_get_period());
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_HISTORY, a);
+	}
+}
+
+static void cmd_history_lookup(cmd_args_t* a, response_t* r) {  // PT:<us> - Posición interpolada en un instante
+	uint32_t timestamp;
+	if (!args_uint(a, &timestamp) || !args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_HISTORY, a);
+		return;
 	}
 	
-	else if (cmd[0] == 'A' && cmd[1] == ':') {  // ARM smooth movement
-		// Formato: A:angle1,angle2,time_ms
-		// Ejemplo: A:45,90,2000 (mover servo1 a 45�, servo2 a 90� en 2 segundos)
+	int32_t h_pos, v_pos;
+	if (position_history_lookup(timestamp, &h_pos, &v_pos)) {
+		resp_msg(r, MSG_POS_AT);
+		resp_str_P(r, PSTR(":T="));
+		resp_uint(r, timestamp);
+		resp_str_P(r, PSTR(",H="));
+		resp_int(r, h_pos);
+		resp_str_P(r, PSTR(",V="));
+		resp_int(r, v_pos);
+	} else {
+		resp_msg(r, MSG_ERR_HISTORY_OUT_OF_RANGE);
+		resp_char(r, ':');
+		resp_uint(r, timestamp);
+	}
+}
+
+static void cmd_history_dump(cmd_args_t* a, response_t* r) {  // PD:<from_us>,<to_us> - Volcado binario
+	uint32_t from_us, to_us;
+	if (args_uint(a, &from_us) && args_uint(a, &to_us) && args_end(a)) {
+		position_history_dump(from_us, to_us);
+		return;  // La cabecera HISTORY_BIN y los registros ya son la respuesta
+	}
+	resp_param_error(r, MSG_ERR_INVALID_PARAMS_HISTORY_DUMP, a);
+}
+
+// ========== SERVOS Y GRIPPER ==========
+
+static void cmd_arm(cmd_args_t* a, response_t* r) {  // ARM smooth movement
+	// Formato: A:angle1,angle2,time_ms
+	// Ejemplo: A:45,90,2000 (mover servo1 a 45�, servo2 a 90� en 2 segundos)
+	int32_t angle1, angle2, time_ms;
+	if (args_int_range(a, 0, UINT8_MAX, &angle1) && args_int_range(a, 0, UINT8_MAX, &angle2) &&
+		args_int_range(a, 0, UINT16_MAX, &time_ms) && args_end(a)) {
+		if (a->dry_run) return;
 		
-		int values[3];
-		int count = 0;
-		char* ptr = (char*)(cmd + 2);
+		// Validar tiempo
+		if (time_ms > SERVO_MAX_MOVE_TIME) time_ms = SERVO_MAX_MOVE_TIME;
 		
-		// Parser simple para 3 valores
-		while (*ptr && count < 3) {
-			values[count] = atoi(ptr);
-			count++;
-			// Buscar siguiente n�mero
-			while (*ptr && *ptr != ',' && *ptr != '\0') ptr++;
-			if (*ptr == ',') ptr++;
-		}
+		command_seq_bind(SEQ_SERVO);
+		servo_move_to((uint8_t)angle1, (uint8_t)angle2, (uint16_t)time_ms);
 		
-		if (count == 3) {
-			uint8_t angle1 = (uint8_t)values[0];
-			uint8_t angle2 = (uint8_t)values[1];
-			uint16_t time_ms = (uint16_t)values[2];
-			
-			// Validar tiempo
-			if (time_ms > SERVO_MAX_MOVE_TIME) time_ms = SERVO_MAX_MOVE_TIME;
-			
-			servo_move_to(angle1, angle2, time_ms);
-			
-			if (time_ms == 0) {
-				snprintf(response, sizeof(response), "OK:ARM_INSTANT:%d,%d", angle1, angle2);
-				} else {
-				snprintf(response, sizeof(response), "OK:ARM_SMOOTH:%d,%d,%d", angle1, angle2, time_ms);
-			}
-			} else {
-			snprintf(response, sizeof(response), "ERR:INVALID_ARM_PARAMS");
+		resp_msg(r, (time_ms == 0) ? MSG_OK_ARM_INSTANT : MSG_OK_ARM_SMOOTH);
+		resp_char(r, ':');
+		resp_int_pair(r, angle1, angle2);
+		if (time_ms != 0) {
+			resp_char(r, ',');
+			resp_uint(r, time_ms);
 		}
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_ARM_PARAMS, a);
 	}
-	
-	else if (cmd[0] == 'R' && cmd[1] == 'A') {  // Reset Arms
-		// Resetear brazos a posici�n por defecto (90�)
-		servo_set_position(1, 90);
-		servo_set_position(2, 90);
-		snprintf(response, sizeof(response), "OK:ARMS_RESET");
+}
+
+static void cmd_arms_reset(cmd_args_t* a, response_t* r) {  // Reset Arms
+	if (a->dry_run) return;
+	// Resetear brazos a posici�n por defecto (90�)
+	command_seq_bind(SEQ_SERVO);
+	servo_set_position(1, 90);
+	servo_set_position(2, 90);
+	resp_msg(r, MSG_OK_ARMS_RESET);
+}
+
+static void cmd_servo_position(cmd_args_t* a, response_t* r) {  // Position servo individual
+	// Formato: P:servo_num,angle
+	// Ejemplo: P:1,45 (servo 1 a 45 grados)
+	int32_t servo_num, angle;
+	if (args_int(a, &servo_num) && args_int_range(a, 0, UINT8_MAX, &angle) && args_end(a)) {
+		if (servo_num == 1 || servo_num == 2) {
+			if (a->dry_run) return;
+			command_seq_bind(SEQ_SERVO);
+			servo_set_position((uint8_t)servo_num, (uint8_t)angle);
+			resp_msg(r, (servo_num == 1) ? MSG_OK_SERVO1_POS : MSG_OK_SERVO2_POS);
+			resp_char(r, ':');
+			resp_int(r, angle);
+		} else {
+			resp_msg(r, MSG_ERR_INVALID_SERVO_NUM);
+		}
+	} else {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_POS, a);
+	}
+}
+
+static void cmd_servo_query(cmd_args_t* a, response_t* r) {  // Query - consultar estado actual
+	resp_msg(r, MSG_SERVO_POS);
+	resp_char(r, ':');
+	resp_int_pair(r, servo_get_current_position(1), servo_get_current_position(2));
+}
+
+static void cmd_gripper_toggle(cmd_args_t* a, response_t* r) {  // GT - Toggle Gripper
+	gripper_state_t state = gripper_get_state();
+	bool busy = (state == GRIPPER_OPENING || state == GRIPPER_CLOSING);
+	if (a->dry_run) {
+		if (busy) resp_msg(r, MSG_GRIPPER_BUSY);
+		return;
+	}
+	if (!busy) {
+		command_seq_bind(SEQ_GRIPPER);
+	}
+	gripper_toggle();
+	resp_msg(r, MSG_OK_GRIPPER_TOGGLE);
+}
+
+static void cmd_gripper_status(cmd_args_t* a, response_t* r) {  // G? - Estado del gripper
+	resp_msg(r, MSG_GRIPPER_STATUS);
+	resp_char(r, ':');
+	resp_str_P(r, gripper_state_name(gripper_get_state()));
+	resp_char(r, ',');
+	resp_int(r, gripper_get_position());
+}
+
+// ========== MACROS ==========
+
+static int8_t hex_value(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+static void cmd_macro_upload(cmd_args_t* a, response_t* r) {  // MU:slot,offset,<hex> - Trozo de programa
+	int32_t slot, offset;
+	const char* hex;
+	uint8_t hex_len = 0;
+	if (!args_int_range(a, 0, MACRO_SLOT_COUNT - 1, &slot) || !args_int_range(a, 0, MACRO_SLOT_SIZE - 1, &offset)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_MACRO, a);
+		return;
+	}
+	const char* data_start = args_rest(a);
+	if (!args_word(a, &hex, &hex_len) || !args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_MACRO, a);
+		return;
 	}
 	
-	else if (cmd[0] == 'P' && cmd[1] == ':') {  // Position servo individual
-		// Formato: P:servo_num,angle
-		// Ejemplo: P:1,45 (servo 1 a 45 grados)
-		int servo_num, angle;
-		if (parse_two_integers(cmd + 2, &servo_num, &angle)) {
-			if (servo_num == 1 || servo_num == 2) {
-				servo_set_position(servo_num, angle);
-				snprintf(response, sizeof(response), "OK:SERVO%d_POS:%d", servo_num, angle);
-				} else {
-				snprintf(response, sizeof(response), "ERR:INVALID_SERVO_NUM");
-			}
-			} else {
-			snprintf(response, sizeof(response), "ERR:INVALID_PARAMS_POS");
+	uint8_t data[UART_BUFFER_SIZE / 2];
+	uint8_t len = hex_len / 2;
+	for (uint8_t i = 0; i < hex_len; i += 2) {
+		int8_t hi = hex_value(hex[i]);
+		int8_t lo = (i + 1 < hex_len) ? hex_value(hex[i + 1]) : -1;
+		if (hi < 0 || lo < 0 || offset + len > MACRO_SLOT_SIZE) {
+			resp_msg(r, MSG_ERR_INVALID_PARAMS_MACRO);
+			resp_str_P(r, PSTR(":AT="));
+			resp_uint(r, (uint16_t)(data_start - a->start) + i);
+			return;
 		}
+		data[i / 2] = (uint8_t)((hi << 4) | lo);
 	}
 	
-	else if (cmd[0] == 'G' && cmd[1] == 'T') {  // GT - Toggle Gripper
-		gripper_toggle();
-		snprintf(response, sizeof(response), "OK:GRIPPER_TOGGLE");
+	if (!macro_write((uint8_t)slot, (uint8_t)offset, data, len)) {
+		resp_msg(r, MSG_ERR_MACRO_BUSY);
+		return;
+	}
+	resp_msg(r, MSG_OK_MACRO_UPLOAD);
+	resp_char(r, ':');
+	resp_uint(r, slot);
+	resp_char(r, ',');
+	resp_uint(r, offset);
+	resp_char(r, ',');
+	resp_uint(r, len);
+}
+
+static void cmd_macro_run(cmd_args_t* a, response_t* r) {  // MR:slot - Validar y ejecutar
+	int32_t slot;
+	if (!args_int_range(a, 0, MACRO_SLOT_COUNT - 1, &slot) || !args_end(a)) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_MACRO, a);
+		return;
+	}
+	if (macro_is_running()) {
+		resp_msg(r, MSG_ERR_MACRO_BUSY);
+		return;
+	}
+	uint8_t error_pc;
+	if (!macro_run((uint8_t)slot, &error_pc)) {
+		resp_msg(r, MSG_ERR_MACRO_INVALID);
+		resp_char(r, ':');
+		resp_uint(r, slot);
+		resp_str_P(r, PSTR(",PC="));
+		resp_uint(r, error_pc);
+		return;
+	}
+	resp_msg(r, MSG_OK_MACRO_RUN);
+	resp_char(r, ':');
+	resp_uint(r, slot);
+}
+
+static void cmd_macro_abort(cmd_args_t* a, response_t* r) {  // MX - Cancelar el programa en curso
+	macro_abort();
+	resp_msg(r, MSG_OK_MACRO_ABORT);
+}
+
+static void cmd_macro_status(cmd_args_t* a, response_t* r) {  // MS? - Estado del intérprete
+	resp_msg(r, MSG_MACRO_STATUS);
+	resp_str_P(r, PSTR(":STATE="));
+	resp_str_P(r, macro_state_name(macro_get_state()));
+	resp_str_P(r, PSTR(",SLOT="));
+	resp_uint(r, macro_get_slot());
+	resp_str_P(r, PSTR(",PC="));
+	resp_uint(r, macro_get_pc());
+}
+
+// ========== COLA DE PASOS ==========
+
+static void cmd_step_queue_add(cmd_args_t* a, response_t* r) {  // QA:H|V,interval,count,add[,...] - Segmentos de pasos (us)
+	step_queue_axis_t axis;
+	char axis_char;
+	if (args_match_P(a, PSTR("H"))) {
+		axis = STEP_QUEUE_AXIS_H;
+		axis_char = 'H';
+	} else if (args_match_P(a, PSTR("V"))) {
+		axis = STEP_QUEUE_AXIS_V;
+		axis_char = 'V';
+	} else {
+		resp_msg(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE);
+		return;
 	}
 	
-	else if (cmd[0] == 'V' && cmd[1] == ':') {
-		int h_speed, v_speed;
-		if (parse_two_integers(cmd + 2, &h_speed, &v_speed)) {
-			if (h_speed > 0 && h_speed <= 15000) {
-				horizontal_axis.max_speed = h_speed;
-			}
-			if (v_speed > 0 && v_speed <= 15000) {
-				vertical_axis.max_speed = v_speed;
-			}
-			snprintf(response, sizeof(response), "OK:VELOCIDADES:%d,%d",
-			horizontal_axis.max_speed, vertical_axis.max_speed);
-			} else {
-			snprintf(response, sizeof(response), "ERR:INVALID_PARAMS_VELOCIDADES");
+	step_segment_t segs[STEP_QUEUE_MAX_PER_FRAME];
+	uint8_t n = 0;
+	while (!args_at_end(*args_rest(a))) {
+		const char* seg_start = args_rest(a);
+		int32_t interval, count, add;
+		if (!args_int_range(a, 0, UINT16_MAX, &interval) ||
+			!args_int_range(a, -INT16_MAX, INT16_MAX, &count) ||
+			!args_int_range(a, INT16_MIN, INT16_MAX, &add)) {
+			resp_param_error(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE, a);
+			return;
 		}
+		step_segment_t seg = { (uint16_t)interval, (int16_t)count, (int16_t)add };
+		if (n == STEP_QUEUE_MAX_PER_FRAME || !step_queue_segment_valid(&seg)) {
+			// Intervalo fuera de rango en algún paso: señalar el segmento
+			resp_msg(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE);
+			resp_str_P(r, PSTR(":AT="));
+			resp_uint(r, (uint16_t)(seg_start - a->start));
+			return;
+		}
+		segs[n++] = seg;
 	}
-	
-	else if (cmd[0] == 'L') {
-		limit_status_t status = limit_switch_get_status();
-		snprintf(response, sizeof(response), "LIMITS:H_L=%d,H_R=%d,V_U=%d,V_D=%d",
-		status.h_left_triggered ? 1 : 0,
-		status.h_right_triggered ? 1 : 0,
-		status.v_up_triggered ? 1 : 0,
-		status.v_down_triggered ? 1 : 0);
+	if (n == 0) {
+		resp_msg(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE);
+		return;
 	}
 	
-	else if (cmd[0] == 'H' && cmd[1] == 'B' && cmd[2] == ':') {  // HB:<0|1> - Heartbeat LIMIT_STATUS enable/disable
-		int enable = atoi(cmd + 3);
-		limit_switch_set_heartbeat(enable ? 1 : 0);
-		snprintf(response, sizeof(response), "OK:HB:%d", enable ? 1 : 0);
+	step_queue_result_t result = step_queue_push(axis, segs, n);
+	if (result == STEP_QUEUE_BUSY) {
+		resp_msg(r, MSG_ERR_STEP_QUEUE_BUSY);
+		return;
 	}
-	
-	else if (cmd[0] == 'Q') {  // Query - consultar estado actual
-		// Obtener posiciones actuales de los servos
-		uint8_t servo1_pos = servo_get_current_position(1);
-		uint8_t servo2_pos = servo_get_current_position(2);
-		
-		snprintf(response, sizeof(response), "SERVO_POS:%d,%d", servo1_pos, servo2_pos);
+	// FREE permite al host regular el envío sin consultar QS?
+	resp_msg(r, (result == STEP_QUEUE_OK) ? MSG_OK_STEP_QUEUE : MSG_ERR_STEP_QUEUE_FULL);
+	resp_char(r, ':');
+	resp_char(r, axis_char);
+	resp_char(r, ',');
+	resp_uint(r, (result == STEP_QUEUE_OK) ? n : 0);
+	resp_str_P(r, PSTR(",FREE="));
+	resp_uint(r, step_queue_free(axis));
+}
+
+static void cmd_step_queue_go(cmd_args_t* a, response_t* r) {  // QG[:<start_us>] - Arrancar la cola (reloj del firmware)
+	uint32_t now = system_clock_micros();
+	uint32_t start = now;
+	if (!args_at_end(*args_rest(a)) && (!args_uint(a, &start) || !args_end(a))) {
+		resp_param_error(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE, a);
+		return;
+	}
+	// Un instante pasado arranca en el acto (se reporta como LATE)
+	if ((int32_t)(start - now) > (int32_t)STEP_QUEUE_MAX_LEAD_US) {
+		resp_msg(r, MSG_ERR_INVALID_PARAMS_STEP_QUEUE);
+		return;
+	}
+	if (step_queue_is_active() || stepper_is_moving() || macro_is_running() || gcode_is_busy()) {
+		resp_msg(r, MSG_ERR_STEP_QUEUE_BUSY);
+		return;
+	}
+	if (!step_queue_start(start)) {
+		resp_msg(r, MSG_ERR_STEP_QUEUE_EMPTY);
+		return;
+	}
+	resp_msg(r, MSG_OK_STEP_QUEUE_START);
+	resp_char(r, ':');
+	resp_uint(r, start);
+}
+
+static void cmd_step_queue_end(cmd_args_t* a, response_t* r) {  // QE - No llegan más segmentos
+	step_queue_end();
+	resp_msg(r, MSG_OK_STEP_QUEUE_END);
+}
+
+static void cmd_step_queue_clear(cmd_args_t* a, response_t* r) {  // QX - Descartar la cola y parar sus ejes
+	bool active = step_queue_is_active();
+	step_queue_clear();
+	if (active) {
+		stepper_stop_all();
+	}
+	resp_msg(r, MSG_OK_STEP_QUEUE_CLEAR);
+}
+
+static void cmd_step_queue_status(cmd_args_t* a, response_t* r) {  // QS? - Estado de la cola de pasos
+	resp_msg(r, MSG_STEP_QUEUE_STATUS);
+	resp_str_P(r, PSTR(":STATE="));
+	resp_str_P(r, step_queue_state_name(step_queue_get_state()));
+	resp_str_P(r, PSTR(",H="));
+	resp_uint(r, step_queue_count(STEP_QUEUE_AXIS_H));
+	resp_str_P(r, PSTR(",V="));
+	resp_uint(r, step_queue_count(STEP_QUEUE_AXIS_V));
+	resp_str_P(r, PSTR(",FREE="));
+	resp_int_pair(r, step_queue_free(STEP_QUEUE_AXIS_H), step_queue_free(STEP_QUEUE_AXIS_V));
+	resp_str_P(r, PSTR(",UNDERRUNS="));
+	resp_uint(r, step_queue_get_underruns());
+}
+
+// ========== ESTADO, TELEMETRÍA Y LOG ==========
+
+static void cmd_system_state(cmd_args_t* a, response_t* r) {  // S? - Status query completo
+	int32_t h_pos, v_pos;
+	stepper_get_position(&h_pos, &v_pos);
+	command_format_system_state(r, h_pos, v_pos,
+		servo_get_current_position(1), servo_get_current_position(2),
+		gripper_get_state(), gripper_get_position());
+}
+
+static void cmd_limits(cmd_args_t* a, response_t* r) {  // L - Estado de finales de carrera
+	limit_status_t status = limit_switch_get_status();
+	resp_msg(r, MSG_LIMITS);
+	resp_str_P(r, PSTR(":H_L="));
+	resp_char(r, status.h_left_triggered ? '1' : '0');
+	resp_str_P(r, PSTR(",H_R="));
+	resp_char(r, status.h_right_triggered ? '1' : '0');
+	resp_str_P(r, PSTR(",V_U="));
+	resp_char(r, status.v_up_triggered ? '1' : '0');
+	resp_str_P(r, PSTR(",V_D="));
+	resp_char(r, status.v_down_triggered ? '1' : '0');
+}
+
+static void cmd_heartbeat(cmd_args_t* a, response_t* r) {  // HB:<0|1> - Heartbeat LIMIT_STATUS enable/disable
+	int32_t enable = 0;
+	args_int(a, &enable);
+	limit_switch_set_heartbeat(enable ? 1 : 0);
+	resp_msg(r, MSG_OK_HB);
+	resp_char(r, ':');
+	resp_char(r, enable ? '1' : '0');
+}
+
+static void cmd_telemetry_status(cmd_args_t* a, response_t* r) {  // TS? - Suscripciones de telemetría (periodo en ms)
+	resp_msg(r, MSG_TELEMETRY);
+	for (uint8_t i = 0; i < TELEMETRY_TOPIC_COUNT; i++) {
+		resp_char(r, i ? ',' : ':');
+		resp_str(r, telemetry_topic_name((telemetry_topic_t)i));
+		resp_char(r, '=');
+		resp_uint(r, telemetry_get_period((telemetry_topic_t)i));
+	}
+}
+
+static void cmd_telemetry_subscribe(cmd_args_t* a, response_t* r) {  // TS:<topic>,<ms> | TS:OFF - Suscribir tópico binario
+	if (args_match_P(a, PSTR("OFF"))) {
+		telemetry_unsubscribe_all();
+		resp_msg(r, MSG_OK_TELEMETRY_OFF);
+		return;
 	}
 	
-	else if (cmd[0] == 'G' && cmd[1] == '?') {
-		gripper_state_t state = gripper_get_state();
-		int16_t position = gripper_get_position();
-	
-		const char* state_str;
-		switch(state) {
-			case GRIPPER_OPEN: state_str = "OPEN"; break;
-			case GRIPPER_CLOSED: state_str = "CLOSED"; break;
-			case GRIPPER_OPENING: state_str = "OPENING"; break;
-			case GRIPPER_CLOSING: state_str = "CLOSING"; break;
-			default: state_str = "IDLE"; break;
+	const char* name;
+	uint8_t len;
+	int32_t period_ms;
+	telemetry_topic_t topic = TELEMETRY_TOPIC_COUNT;
+	if (args_word(a, &name, &len) && len == 3) {
+		topic = telemetry_topic_from_name(name);
+	}
+	if (topic < TELEMETRY_TOPIC_COUNT && args_int_range(a, 0, UINT16_MAX, &period_ms) && args_end(a)) {
+		uint16_t period = telemetry_subscribe(topic, (uint16_t)period_ms);
+		resp_msg(r, MSG_OK_TELEMETRY);
+		resp_char(r, ':');
+		resp_str(r, telemetry_topic_name(topic));
+		resp_char(r, '=');
+		resp_uint(r, period);
+	} else {
+		resp_msg(r, MSG_ERR_INVALID_TOPIC);
+	}
+}
+
+static void cmd_log_status(cmd_args_t* a, response_t* r) {  // VL? - Nivel y tasa por categoría (nivel/ms)
+	resp_msg(r, MSG_LOG);
+	for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) {
+		resp_char(r, i ? ',' : ':');
+		resp_str(r, event_log_category_name((log_category_t)i));
+		resp_char(r, '=');
+		resp_uint(r, event_log_get_level((log_category_t)i));
+		resp_char(r, '/');
+		resp_uint(r, event_log_get_rate((log_category_t)i));
+	}
+}
+
+// VL:<cat|ALL>,<0-3> | VR:<cat|ALL>,<ms>
+static void set_log_config(cmd_args_t* a, response_t* r, bool level) {
+	bool all = args_match_P(a, PSTR("ALL"));
+	log_category_t cat = LOG_CAT_COUNT;
+	if (!all) {
+		const char* name;
+		uint8_t len;
+		if (args_word(a, &name, &len) && len == 3) {
+			cat = event_log_category_from_name(name);
 		}
-	
-		snprintf(response, sizeof(response), "GRIPPER_STATUS:%s,%d", state_str, position);
 	}
 	
-	// XY? - Consultar posición actual de los steppers en pasos y milímetros
-	else if (cmd[0] == 'X' && cmd[1] == 'Y' && cmd[2] == '?') {
-		int32_t h_pos_steps = 0;
-		int32_t v_pos_steps = 0;
-		stepper_get_position(&h_pos_steps, &v_pos_steps);
-		
-		// Convertir a mm con redondeo simétrico (igual que en otros mensajes)
-		int32_t h_mm = (h_pos_steps >= 0) ?
-			(h_pos_steps + STEPS_PER_MM_H/2) / STEPS_PER_MM_H :
-			(h_pos_steps - STEPS_PER_MM_H/2) / STEPS_PER_MM_H;
-		int32_t v_mm = (v_pos_steps >= 0) ?
-			(v_pos_steps + STEPS_PER_MM_V/2) / STEPS_PER_MM_V :
-			(v_pos_steps - STEPS_PER_MM_V/2) / STEPS_PER_MM_V;
-		
-		snprintf(response, sizeof(response), "OK:XY:STEPS:%ld,%ld,MM:%ld,%ld",
-			(long)h_pos_steps, (long)v_pos_steps, (long)h_mm, (long)v_mm);
+	int32_t value;
+	if (!(all || cat < LOG_CAT_COUNT) || !args_int_range(a, 0, UINT16_MAX, &value) || !args_end(a)) {
+		resp_msg(r, MSG_ERR_INVALID_LOG_CATEGORY);
+		return;
 	}
 	
-	else if (cmd[0] == 'C' && cmd[1] == 'S') {  // CS - Calibration Start
-		stepper_start_calibration();
-		snprintf(response, sizeof(response), "OK:CALIBRATION_STARTED");
+	if (level && value > LOG_TRACE) value = LOG_TRACE;
+	for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) {
+		if (!all && i != cat) continue;
+		if (level) {
+			event_log_set_level((log_category_t)i, (log_level_t)value);
+		} else {
+			event_log_set_rate((log_category_t)i, (uint16_t)value);
+		}
+	}
+	resp_msg(r, level ? MSG_OK_LOG_LEVEL : MSG_OK_LOG_RATE);
+	resp_char(r, ':');
+	if (all) {
+		resp_str_P(r, PSTR("ALL"));
+	} else {
+		resp_str(r, event_log_category_name(cat));
 	}
+	resp_char(r, '=');
+	resp_uint(r, value);
+}
+
+static void cmd_log_level(cmd_args_t* a, response_t* r) {
+	set_log_config(a, r, true);
+}
+
+static void cmd_log_rate(cmd_args_t* a, response_t* r) {
+	set_log_config(a, r, false);
+}
+
+static void cmd_message_ids(cmd_args_t* a, response_t* r) {  // MI:<0|1> - Cabeceras como #id (catálogo de mensajes)
+	int32_t enable = 0;
+	args_int(a, &enable);
+	message_catalog_set_id_mode(enable != 0);
+	resp_msg(r, MSG_OK_MSG_IDS);
+	resp_char(r, ':');
+	resp_char(r, enable ? '1' : '0');
+}
 
-	else if (cmd[0] == 'C' && cmd[1] == 'E') {  // CE - Calibration End
-		stepper_stop_calibration();
-		snprintf(response, sizeof(response), "OK:CALIBRATION_ENDED");
+static void cmd_message_catalog(cmd_args_t* a, response_t* r) {  // MC? - Tabla id -> texto del catálogo
+	message_catalog_dump();  // Las líneas MSG: y OK:CATALOG ya son la respuesta
+}
+
+static void cmd_rx_stats(cmd_args_t* a, response_t* r) {  // RX? - Contadores de recepción de frames
+	uart_rx_stats_t stats;
+	uart_get_rx_stats(&stats);
+	resp_msg(r, MSG_RX_STATS);
+	resp_str_P(r, PSTR(":SLOTS="));
+	resp_uint(r, UART_FRAME_SLOTS);
+	resp_str_P(r, PSTR(",FRAMES="));
+	resp_uint(r, stats.frames);
+	resp_str_P(r, PSTR(",PENDING="));
+	resp_uint(r, stats.pending);
+	resp_str_P(r, PSTR(",MAX_PENDING="));
+	resp_uint(r, stats.max_pending);
+	resp_str_P(r, PSTR(",DROPPED="));
+	resp_uint(r, stats.dropped);
+	resp_str_P(r, PSTR(",OVERFLOW="));
+	resp_uint(r, stats.overflows);
+	resp_str_P(r, PSTR(",OVERRUN="));
+	resp_uint(r, stats.hw_overruns);
+	resp_str_P(r, PSTR(",FAST_STOPS="));
+	resp_uint(r, stats.fast_stops);
+}
+
+static void cmd_benchmark(cmd_args_t* a, response_t* r) {  // BM[:<n>] - Benchmark de formateo (resultado en BENCH:)
+	int32_t runs = 0;
+	if (!args_at_end(*args_rest(a))) {
+		args_int_range(a, 0, UINT16_MAX, &runs);
 	}
-	
-	else if (cmd[0] == 'R' && cmd[1] == 'P') {  // RP - Take Progress Snapshot
-		// Tomar snapshot del progreso actual SILENCIOSAMENTE (no enviar nada durante movimiento)
-		extern uint8_t snapshot_count;
-		extern progress_snapshot_t snapshots[];
-		
-		bool is_moving = stepper_is_moving();
-		
-		if (is_moving && snapshot_count < MAX_SNAPSHOTS) {
-			// Convertir pasos a milímetros con redondeo preciso
-			snapshots[snapshot_count].h_mm = (relative_h_counter >= 0) ? 
-				(relative_h_counter + STEPS_PER_MM_H/2) / STEPS_PER_MM_H : 
-				(relative_h_counter - STEPS_PER_MM_H/2) / STEPS_PER_MM_H;
-			snapshots[snapshot_count].v_mm = (relative_v_counter >= 0) ? 
-				(relative_v_counter + STEPS_PER_MM_V/2) / STEPS_PER_MM_V : 
-				(relative_v_counter - STEPS_PER_MM_V/2) / STEPS_PER_MM_V;
-			snapshots[snapshot_count].h_steps = relative_h_counter;
-			snapshots[snapshot_count].v_steps = relative_v_counter;
-			
-			snapshot_count++;
-			
-			// NO RESPONDER NADA durante el movimiento - evita interrupciones
-			return;  // Salir sin enviar respuesta
+	resp_msg(r, format_benchmark_request((uint16_t)runs) ? MSG_OK_BENCH : MSG_ERR_BENCH_BUSY);
+}
+
+// Ordenada por opcode (strcmp, '?' < 'A'): se busca por bisección.
+// Al agregar un comando mantener el orden.
+static const command_entry_t command_table[] PROGMEM = {
+	{ "A",   cmd_arm,                 CMD_BATCH },
+	{ "BM",  cmd_benchmark,           0 },
+	{ "CE",  cmd_calibration_end,     0 },
+	{ "CK?", cmd_clock,               0 },
+	{ "CS",  cmd_calibration_start,   0 },
+	{ "E",   cmd_position_error,      0 },
+	{ "EX",  cmd_correction_stop,     0 },
+	{ "FH",  cmd_feed_hold,           0 },
+	{ "FO",  cmd_feed_override,       0 },
+	{ "FR",  cmd_feed_resume,         0 },
+	{ "G?",  cmd_gripper_status,      0 },
+	{ "GT",  cmd_gripper_toggle,      CMD_BATCH },
+	{ "HB",  cmd_heartbeat,           0 },
+	{ "J",   cmd_jog,                 0 },
+	{ "KG",  cmd_correction_gains,    0 },
+	{ "L",   cmd_limits,              0 },
+	{ "M",   cmd_move_xy,             CMD_BATCH },
+	{ "MA",  cmd_move_abs,            CMD_BATCH },
+	{ "MC?", cmd_message_catalog,     0 },
+	{ "MI",  cmd_message_ids,         0 },
+	{ "MP",  cmd_preset,              0 },
+	{ "MP?", cmd_preset_status,       0 },
+	{ "MR",  cmd_macro_run,           0 },
+	{ "MS?", cmd_macro_status,        0 },
+	{ "MU",  cmd_macro_upload,        0 },
+	{ "MX",  cmd_macro_abort,         0 },
+	{ "P",   cmd_servo_position,      CMD_BATCH },
+	{ "PD",  cmd_history_dump,        0 },
+	{ "PG",  cmd_param_get,           0 },
+	{ "PH",  cmd_history_period,      0 },
+	{ "PL?", cmd_param_list,          0 },
+	{ "PR",  cmd_param_load,          0 },
+	{ "PS",  cmd_param_set,           0 },
+	{ "PT",  cmd_history_lookup,      0 },
+	{ "PW",  cmd_param_save,          0 },
+	{ "Q",   cmd_servo_query,         0 },
+	{ "QA",  cmd_step_queue_add,      0 },
+	{ "QE",  cmd_step_queue_end,      0 },
+	{ "QG",  cmd_step_queue_go,       0 },
+	{ "QS?", cmd_step_queue_status,   0 },
+	{ "QX",  cmd_step_queue_clear,    0 },
+	{ "RA",  cmd_arms_reset,          CMD_BATCH },
+	{ "RP",  cmd_snapshot,            0 },
+	{ "RX?", cmd_rx_stats,            0 },
+	{ "S",   cmd_stop,                0 },
+	{ "S?",  cmd_system_state,        0 },
+	{ "SD",  cmd_decel_stop,          0 },
+	{ "SL",  cmd_soft_limits,         0 },
+	{ "T?",  cmd_trigger_status,      0 },
+	{ "TA",  cmd_trigger_add,         0 },
+	{ "TC",  cmd_trigger_clear,       0 },
+	{ "TM",  cmd_trigger_mode,        0 },
+	{ "TP",  cmd_ping,                0 },
+	{ "TS",  cmd_telemetry_subscribe, 0 },
+	{ "TS?", cmd_telemetry_status,    0 },
+	{ "V",   cmd_speeds,              0 },
+	{ "VL",  cmd_log_level,           0 },
+	{ "VL?", cmd_log_status,          0 },
+	{ "VR",  cmd_log_rate,            0 },
+	{ "XY?", cmd_position,            0 },
+};
+
+#define COMMAND_COUNT (sizeof(command_table) / sizeof(command_table[0]))
+
+static const command_entry_t* find_command(const char* opcode) {
+	uint8_t low = 0;
+	uint8_t high = COMMAND_COUNT;
+	while (low < high) {
+		uint8_t mid = (low + high) / 2;
+		int cmp = strcmp_P(opcode, command_table[mid].opcode);
+		if (cmp == 0) {
+			return &command_table[mid];
+		}
+		if (cmp < 0) {
+			high = mid;
 		} else {
-			// Solo responder errores cuando no se está moviendo
-			if (!is_moving) {
-				snprintf(response, sizeof(response), "SNAPSHOT_ERROR:NOT_MOVING");
-			} else {
-				snprintf(response, sizeof(response), "SNAPSHOT_ERROR:MAX_REACHED");
-			}
+			low = mid + 1;
 		}
 	}
+	return NULL;
+}
 
-	else if (cmd[0] == 'S' && cmd[1] == '?') {  // S? - Status query completo
-		// Enviar estado completo del sistema
-		int32_t h_pos, v_pos;
-		stepper_get_position(&h_pos, &v_pos);
-		
-		uint8_t servo1_pos = servo_get_current_position(1);
-		uint8_t servo2_pos = servo_get_current_position(2);
-		
-		gripper_state_t gripper_state = gripper_get_state();
-		int16_t gripper_pos = gripper_get_position();
-		
-		const char* gripper_str;
-		switch(gripper_state) {
-			case GRIPPER_OPEN: gripper_str = "OPEN"; break;
-			case GRIPPER_CLOSED: gripper_str = "CLOSED"; break;
-			case GRIPPER_OPENING: gripper_str = "OPENING"; break;
-			case GRIPPER_CLOSING: gripper_str = "CLOSING"; break;
-			default: gripper_str = "IDLE"; break;
+// Opcode: texto hasta ':' o fin de comando; los parámetros se leen sobre el
+// mismo buffer. Devuelve la entrada (en flash) o NULL si no existe
+static const command_entry_t* lookup_command(const char* cmd, cmd_args_t* args) {
+	char opcode[sizeof(((command_entry_t*)0)->opcode)];
+	uint8_t len = 0;
+	while (cmd[len] != ':' && !args_at_end(cmd[len]) && len < sizeof(opcode) - 1) {
+		opcode[len] = cmd[len];
+		len++;
+	}
+	opcode[len] = '\0';
+	if (cmd[len] != ':' && !args_at_end(cmd[len])) return NULL;
+	
+	const command_entry_t* entry = find_command(opcode);
+	if (entry) {
+		args_init(args, cmd, (cmd[len] == ':') ? cmd + len + 1 : cmd + len);
+	}
+	return entry;
+}
+
+static void run_command(const command_entry_t* entry, cmd_args_t* args, response_t* r) {
+	command_handler_t handler = (command_handler_t)pgm_read_ptr(&entry->handler);
+	handler(args, r);
+}
+
+// <M:10,20;A:45,90,500;GT> - Los subcomandos se validan todos antes de
+// ejecutar ninguno y arrancan en la misma pasada; los mensajes que generan
+// se envían al final para no separar los arranques. Un solo ACK OK:BATCH:<n>
+// o ERR:BATCH:<índice>:<error del subcomando>
+static void run_batch(const char* cmd, response_t* r) {
+	char sub_response[64];
+	response_t sub;
+	cmd_args_t args;
+	uint8_t count = 0;
+	
+	for (const char* p = cmd; p; count++) {
+		resp_init(&sub, sub_response, sizeof(sub_response));
+		const command_entry_t* entry = lookup_command(p, &args);
+		if (!entry) {
+			resp_msg(&sub, MSG_ERR_UNKNOWN_CMD);
+		} else if (!(pgm_read_byte(&entry->flags) & CMD_BATCH)) {
+			resp_msg(&sub, MSG_ERR_NOT_BATCHABLE);
+		} else {
+			args.dry_run = true;
+			run_command(entry, &args, &sub);
 		}
-		
-		snprintf(response, sizeof(response),
-		"SYSTEM_STATE:H=%ld,V=%ld,S1=%d,S2=%d,G=%s,GP=%d",
-		h_pos, v_pos, servo1_pos, servo2_pos, gripper_str, gripper_pos);
+		if (sub.len > 0) {
+			resp_msg(r, MSG_ERR_BATCH);
+			resp_char(r, ':');
+			resp_uint(r, count);
+			resp_char(r, ':');
+			resp_str(r, sub_response);
+			return;
+		}
+		p = strchr(p, ';');
+		if (p) p++;
 	}
 	
-	else {
-		snprintf(response, sizeof(response), "ERR:UNKNOWN_CMD:%s", cmd);
+	uart_begin_deferred();
+	for (const char* p = cmd; p; ) {
+		resp_init(&sub, sub_response, sizeof(sub_response));
+		run_command(lookup_command(p, &args), &args, &sub);
+		p = strchr(p, ';');
+		if (p) p++;
 	}
+	uart_end_deferred();
+	
+	resp_msg(r, MSG_OK_BATCH);
+	resp_char(r, ':');
+	resp_uint(r, count);
+}
+
+// Prefijo de secuencia "<n>|" (1-65535). Devuelve el inicio del comando o
+// NULL si el prefijo es inválido
+static const char* parse_seq_prefix(const char* cmd, uint16_t* seq) {
+	*seq = SEQ_NONE;
+	if (*cmd < '0' || *cmd > '9') return cmd;
 	
-	uart_send_response(response);
-}
\ No newline at end of file
+	uint32_t value = 0;
+	while (*cmd >= '0' && *cmd <= '9') {
+		value = value * 10 + (uint8_t)(*cmd++ - '0');
+		if (value > UINT16_MAX) return NULL;
+	}
+	if (*cmd != '|' || value == SEQ_NONE) return NULL;
+	*seq = (uint16_t)value;
+	return cmd + 1;
+}
+
+void uart_parse_command(const char* frame) {
+	char response[128];
+	response_t r;
+	resp_init(&r, response, sizeof(response));
+	
+	uint16_t seq;
+	const char* cmd = parse_seq_prefix(frame, &seq);
+	if (!cmd) {
+		resp_msg(&r, MSG_ERR_UNKNOWN_CMD);
+		resp_char(&r, ':');
+		resp_str(&r, frame);
+		uart_send_response(response);
+		return;
+	}
+	command_seq_begin(seq);
+	resp_seq(&r, seq);
+	uint16_t prefix_len = r.len;
+	
+	cmd_args_t args;
+	const command_entry_t* entry;
+	if (strchr(cmd, ';')) {
+		run_batch(cmd, &r);
+	} else if ((entry = lookup_command(cmd, &args)) != NULL) {
+		run_command(entry, &args, &r);
+	} else {
+		resp_msg(&r, MSG_ERR_UNKNOWN_CMD);
+		resp_char(&r, ':');
+		resp_str(&r, cmd);
+	}
+	
+	if (r.len == prefix_len && seq != SEQ_NONE) {
+		// Sin respuesta propia: el ACK devuelve igual el crédito
+		resp_msg(&r, MSG_OK_ACK);
+	}
+	if (r.len > 0) {
+		uart_send_response(response);
+	}
+	command_seq_begin(SEQ_NONE);
+}
@@ -1,6 +1,14 @@
 #ifndef COMMAND_PARSER_H
 #define COMMAND_PARSER_H
 
+#include <stdint.h>
+#include "response_builder.h"
+#include "../drivers/gripper_driver.h"
+
 void uart_parse_command(const char* cmd);
 
+// Línea SYSTEM_STATE de S? (compartida con el benchmark de formateo)
+void command_format_system_state(response_t* r, int32_t h_pos, int32_t v_pos,
+	uint8_t servo1_pos, uint8_t servo2_pos, gripper_state_t gripper_state, int16_t gripper_pos);
+
 #endif
\ No newline at end of file
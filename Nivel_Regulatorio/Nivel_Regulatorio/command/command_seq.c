@@ -0,0 +1,30 @@
+#include "command_seq.h"
+
+static uint16_t current_seq = SEQ_NONE;
+static uint16_t actuator_seq[SEQ_ACTUATOR_COUNT];
+
+void command_seq_begin(uint16_t seq) {
+	current_seq = seq;
+}
+
+uint16_t command_seq_current(void) {
+	return current_seq;
+}
+
+void command_seq_bind(seq_actuator_t actuator) {
+	if (actuator < SEQ_ACTUATOR_COUNT) {
+		actuator_seq[actuator] = current_seq;
+	}
+}
+
+void resp_seq(response_t* r, uint16_t seq) {
+	if (seq == SEQ_NONE) return;
+	resp_uint(r, seq);
+	resp_char(r, '|');
+}
+
+void resp_seq_take(response_t* r, seq_actuator_t actuator) {
+	if (actuator >= SEQ_ACTUATOR_COUNT) return;
+	resp_seq(r, actuator_seq[actuator]);
+	actuator_seq[actuator] = SEQ_NONE;
+}
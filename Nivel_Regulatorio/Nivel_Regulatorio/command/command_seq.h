@@ -0,0 +1,46 @@
+#ifndef COMMAND_SEQ_H
+#define COMMAND_SEQ_H
+
+#include <stdint.h>
+#include "response_builder.h"
+
+// Número de secuencia opcional de los comandos: <17|M:100,50>. La respuesta
+// inmediata (ACK) y el evento que cierra la acción iniciada por el comando
+// llevan el mismo prefijo:
+//
+//   17|OK:MOVE_XY:100,50
+//   17|STEPPER_MOVE_COMPLETED:...
+//
+// Control de flujo por créditos: el host puede tener en vuelo tantos frames
+// como UART_FRAME_SLOTS (RX?: SLOTS=) y recupera un crédito con cada ACK.
+// Todo frame con secuencia recibe exactamente un ACK (OK:ACK si el comando
+// no tiene respuesta propia).
+//
+// Cada actuador recuerda la secuencia del último comando que lo puso en
+// marcha; un comando nuevo reemplaza al anterior, así que el host debe dar
+// por terminadas todas las secuencias previas del mismo actuador.
+
+#define SEQ_NONE 0
+
+typedef enum {
+	SEQ_MOTION = 0,     // Steppers: MOVE_COMPLETED, DECEL_STOP, EMERGENCY_STOP, JOG_STOPPED
+	SEQ_SERVO,          // SERVO_MOVE_COMPLETED
+	SEQ_GRIPPER,        // GRIPPER_ACTION_COMPLETED
+	SEQ_ACTUATOR_COUNT
+} seq_actuator_t;
+
+// Secuencia del frame en ejecución (SEQ_NONE si no trae)
+void command_seq_begin(uint16_t seq);
+uint16_t command_seq_current(void);
+
+// Llamar antes de poner en marcha el actuador (las acciones instantáneas
+// informan su fin dentro de la misma llamada)
+void command_seq_bind(seq_actuator_t actuator);
+
+// Prefijo "<seq>|" si seq != SEQ_NONE
+void resp_seq(response_t* r, uint16_t seq);
+
+// Prefijo de la secuencia ligada al actuador, que queda libre
+void resp_seq_take(response_t* r, seq_actuator_t actuator);
+
+#endif // COMMAND_SEQ_H
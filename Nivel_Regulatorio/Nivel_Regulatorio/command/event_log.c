@@ -0,0 +1,157 @@
+#include "event_log.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/system_clock.h"
+#include <string.h>
+
+// Mensaje agrupado a la espera de su intervalo
+typedef struct {
+	uint8_t cat;
+	uint8_t key;
+	bool used;
+	bool pending;
+	uint32_t last_sent_us;
+	char msg[LOG_COALESCE_MSG_SIZE];
+} coalesce_slot_t;
+
+static const char* const category_names[LOG_CAT_COUNT] = {
+	"MOT", "LIM", "SRV", "GRP", "TRG", "COR", "SYS"
+};
+
+static uint8_t category_level[LOG_CAT_COUNT];
+static uint16_t category_rate_ms[LOG_CAT_COUNT];
+static coalesce_slot_t slots[LOG_COALESCE_SLOTS];
+
+void event_log_init(void) {
+	for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) {
+		category_level[i] = LOG_DEFAULT_LEVEL;
+		category_rate_ms[i] = 0;
+	}
+	category_rate_ms[LOG_CAT_SERVO] = LOG_DEFAULT_SERVO_RATE_MS;
+	
+	for (uint8_t i = 0; i < LOG_COALESCE_SLOTS; i++) {
+		slots[i].used = false;
+		slots[i].pending = false;
+	}
+}
+
+void event_log_set_level(log_category_t cat, log_level_t level) {
+	if (cat >= LOG_CAT_COUNT) return;
+	if (level > LOG_TRACE) level = LOG_TRACE;
+	category_level[cat] = level;
+}
+
+log_level_t event_log_get_level(log_category_t cat) {
+	return (cat < LOG_CAT_COUNT) ? (log_level_t)category_level[cat] : LOG_ERROR;
+}
+
+void event_log_set_rate(log_category_t cat, uint16_t min_interval_ms) {
+	if (cat >= LOG_CAT_COUNT) return;
+	category_rate_ms[cat] = min_interval_ms;
+}
+
+uint16_t event_log_get_rate(log_category_t cat) {
+	return (cat < LOG_CAT_COUNT) ? category_rate_ms[cat] : 0;
+}
+
+bool event_log_enabled(log_category_t cat, log_level_t level) {
+	return cat < LOG_CAT_COUNT && level <= category_level[cat];
+}
+
+void event_log_send(log_category_t cat, log_level_t level, const char* msg) {
+	if (event_log_enabled(cat, level)) {
+		uart_send_response(msg);
+	}
+}
+
+void event_log_send_event(log_category_t cat, log_level_t level, const char* msg) {
+	if (event_log_enabled(cat, level)) {
+		uart_send_event(msg);
+	}
+}
+
+void event_log_send_event_at(log_category_t cat, log_level_t level, const char* msg, uint32_t timestamp_us) {
+	if (event_log_enabled(cat, level)) {
+		uart_send_event_at(msg, timestamp_us);
+	}
+}
+
+void event_log_send_msg(log_category_t cat, log_level_t level, msg_id_t id) {
+	if (event_log_enabled(cat, level)) {
+		message_send(id);
+	}
+}
+
+void event_log_send_event_msg(log_category_t cat, log_level_t level, msg_id_t id) {
+	if (event_log_enabled(cat, level)) {
+		char msg[MESSAGE_MAX_TEXT];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_msg(&r, id);
+		uart_send_event(msg);
+	}
+}
+
+static coalesce_slot_t* find_slot(uint8_t cat, uint8_t key) {
+	coalesce_slot_t* free_slot = NULL;
+	for (uint8_t i = 0; i < LOG_COALESCE_SLOTS; i++) {
+		if (slots[i].used && slots[i].cat == cat && slots[i].key == key) return &slots[i];
+		if (!free_slot && (!slots[i].used || !slots[i].pending)) free_slot = &slots[i];
+	}
+	if (free_slot) {
+		// Reutilizar un slot sin pendientes; el intervalo empieza de cero para la nueva clave
+		free_slot->used = true;
+		free_slot->cat = cat;
+		free_slot->key = key;
+		free_slot->pending = false;
+		free_slot->last_sent_us = system_clock_micros() - ((uint32_t)category_rate_ms[cat] * 1000UL);
+	}
+	return free_slot;
+}
+
+void event_log_coalesce(log_category_t cat, log_level_t level, uint8_t key, const char* msg) {
+	if (!event_log_enabled(cat, level)) return;
+	
+	uint32_t interval_us = (uint32_t)category_rate_ms[cat] * 1000UL;
+	coalesce_slot_t* slot = (interval_us == 0) ? NULL : find_slot(cat, key);
+	if (!slot) {
+		// Sin límite (o todos los slots ocupados): enviar directamente
+		uart_send_response(msg);
+		return;
+	}
+	
+	uint32_t now = system_clock_micros();
+	if (!slot->pending && (uint32_t)(now - slot->last_sent_us) >= interval_us) {
+		slot->last_sent_us = now;
+		uart_send_response(msg);
+		return;
+	}
+	
+	// Dentro del intervalo: quedarse solo con el último valor
+	strncpy(slot->msg, msg, LOG_COALESCE_MSG_SIZE - 1);
+	slot->msg[LOG_COALESCE_MSG_SIZE - 1] = '\0';
+	slot->pending = true;
+}
+
+void event_log_flush(void) {
+	uint32_t now = system_clock_micros();
+	for (uint8_t i = 0; i < LOG_COALESCE_SLOTS; i++) {
+		coalesce_slot_t* slot = &slots[i];
+		if (!slot->pending) continue;
+		if ((uint32_t)(now - slot->last_sent_us) >= (uint32_t)category_rate_ms[slot->cat] * 1000UL) {
+			slot->last_sent_us = now;
+			slot->pending = false;
+			uart_send_response(slot->msg);
+		}
+	}
+}
+
+log_category_t event_log_category_from_name(const char* name) {
+	for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) {
+		if (strncmp(name, category_names[i], 3) == 0) return (log_category_t)i;
+	}
+	return LOG_CAT_COUNT;
+}
+
+const char* event_log_category_name(log_category_t cat) {
+	return (cat < LOG_CAT_COUNT) ? category_names[cat] : "?";
+}
@@ -0,0 +1,64 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "message_catalog.h"
+
+// Filtro de mensajes asíncronos: nivel de verbosidad por categoría y
+// limitador de tasa que agrupa los eventos frecuentes en el último valor.
+// Las respuestas a comandos no pasan por aquí (siempre se envían).
+
+typedef enum {
+	LOG_ERROR = 0,      // Fallos (siempre útiles)
+	LOG_EVENT,          // Eventos que el supervisor interpreta (por defecto)
+	LOG_DEBUG,          // Diagnóstico de arranque / EEPROM / posiciones en límite
+	LOG_TRACE           // Cada paso intermedio (p.ej. SERVO_CHANGED)
+} log_level_t;
+
+typedef enum {
+	LOG_CAT_MOTION = 0,     // MOT: steppers, jog, hold
+	LOG_CAT_LIMIT,          // LIM: finales de carrera
+	LOG_CAT_SERVO,          // SRV: brazo
+	LOG_CAT_GRIPPER,        // GRP: pinza
+	LOG_CAT_TRIGGER,        // TRG: disparos por posición
+	LOG_CAT_CORRECTION,     // COR: lazo de corrección
+	LOG_CAT_SYSTEM,         // SYS: arranque
+	LOG_CAT_COUNT
+} log_category_t;
+
+#define LOG_DEFAULT_LEVEL           LOG_EVENT
+#define LOG_DEFAULT_SERVO_RATE_MS   100     // SERVO_CHANGED agrupado a 10Hz como máximo
+#define LOG_COALESCE_SLOTS          4
+#define LOG_COALESCE_MSG_SIZE       48
+
+void event_log_init(void);
+
+void event_log_set_level(log_category_t cat, log_level_t level);
+log_level_t event_log_get_level(log_category_t cat);
+void event_log_set_rate(log_category_t cat, uint16_t min_interval_ms);   // 0 = sin límite
+uint16_t event_log_get_rate(log_category_t cat);
+
+bool event_log_enabled(log_category_t cat, log_level_t level);
+
+// Enviar si el nivel está habilitado (texto plano / con sufijo T=us)
+void event_log_send(log_category_t cat, log_level_t level, const char* msg);
+void event_log_send_event(log_category_t cat, log_level_t level, const char* msg);
+void event_log_send_event_at(log_category_t cat, log_level_t level, const char* msg, uint32_t timestamp_us);
+
+// Igual que las anteriores para mensajes sin parámetros del catálogo
+void event_log_send_msg(log_category_t cat, log_level_t level, msg_id_t id);
+void event_log_send_event_msg(log_category_t cat, log_level_t level, msg_id_t id);
+
+// Enviar como mucho uno por intervalo de la categoría; mientras tanto se guarda
+// solo el último mensaje de (cat, key) y se emite al vencer el intervalo
+void event_log_coalesce(log_category_t cat, log_level_t level, uint8_t key, const char* msg);
+
+// Emitir los mensajes agrupados pendientes (llamar desde el loop principal)
+void event_log_flush(void);
+
+// Categoría por nombre corto (MOT, LIM, SRV, GRP, TRG, COR, SYS); LOG_CAT_COUNT si no existe
+log_category_t event_log_category_from_name(const char* name);
+const char* event_log_category_name(log_category_t cat);
+
+#endif // EVENT_LOG_H
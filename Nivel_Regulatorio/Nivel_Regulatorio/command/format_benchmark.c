@@ -0,0 +1,117 @@
+#include "format_benchmark.h"
+#include "response_builder.h"
+#include "command_parser.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/system_clock.h"
+#include "../drivers/stepper_driver.h"
+#include "message_catalog.h"
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+// 16MHz / prescaler 8: cada cuenta del reloj son 8 ciclos de CPU
+#define CYCLES_PER_TICK 8
+
+typedef struct {
+	uint32_t sum;
+	uint16_t min;
+} bench_stat_t;
+
+static volatile uint16_t pending_runs = 0;
+
+// Valores anchos y con signo: peor caso realista de ambas líneas
+static const int32_t bench_h_mm = -1234;
+static const int32_t bench_v_mm = 567;
+
+static void stat_reset(bench_stat_t* s) {
+	s->sum = 0;
+	s->min = 0xFFFF;
+}
+
+static void stat_add(bench_stat_t* s, uint32_t start) {
+	uint32_t ticks = system_clock_ticks() - start;
+	uint16_t cycles = (ticks * CYCLES_PER_TICK > 0xFFFF) ? 0xFFFF : (uint16_t)(ticks * CYCLES_PER_TICK);
+	s->sum += cycles;
+	if (cycles < s->min) s->min = cycles;
+}
+
+// Formatos previos de stepper_driver.c y command_parser.c (formato en flash: mismo vfprintf)
+static void snprintf_move_completed(char* buf, uint16_t size) {
+	snprintf_P(buf, size, PSTR("STEPPER_MOVE_COMPLETED:%ld,%ld,REL:%ld,%ld,MM:%ld,%ld"),
+		horizontal_axis.current_position, vertical_axis.current_position,
+		relative_h_counter, relative_v_counter, bench_h_mm, bench_v_mm);
+}
+
+static void snprintf_system_state(char* buf, uint16_t size) {
+	snprintf_P(buf, size, PSTR("SYSTEM_STATE:H=%ld,V=%ld,S1=%d,S2=%d,G=%s,GP=%d"),
+		horizontal_axis.current_position, vertical_axis.current_position,
+		90, 135, "CLOSED", -250);
+}
+
+static void builder_move_completed(char* buf, uint16_t size) {
+	response_t r;
+	resp_init(&r, buf, size);
+	stepper_format_motion_report(&r, MSG_STEPPER_MOVE_COMPLETED, bench_h_mm, bench_v_mm);
+}
+
+static void builder_system_state(char* buf, uint16_t size) {
+	response_t r;
+	resp_init(&r, buf, size);
+	command_format_system_state(&r, horizontal_axis.current_position, vertical_axis.current_position,
+		90, 135, GRIPPER_CLOSED, -250);
+}
+
+static void run(void (*format)(char*, uint16_t), bench_stat_t* s, uint16_t runs) {
+	char buf[128];
+	stat_reset(s);
+	for (uint16_t i = 0; i < runs; i++) {
+		uint32_t start = system_clock_ticks();
+		format(buf, sizeof(buf));
+		stat_add(s, start);
+	}
+}
+
+static void append_stat(response_t* r, const char* name, const bench_stat_t* s, uint16_t runs) {
+	resp_str_P(r, name);
+	resp_char(r, '=');
+	resp_uint(r, s->sum / runs);
+	resp_char(r, '/');
+	resp_uint(r, s->min);
+}
+
+bool format_benchmark_request(uint16_t runs) {
+	if (pending_runs || stepper_is_moving()) return false;
+	if (runs == 0) runs = FORMAT_BENCHMARK_DEFAULT_RUNS;
+	if (runs > FORMAT_BENCHMARK_MAX_RUNS) runs = FORMAT_BENCHMARK_MAX_RUNS;
+	pending_runs = runs;
+	return true;
+}
+
+void format_benchmark_update(void) {
+	uint16_t runs = pending_runs;
+	if (runs == 0) return;
+	
+	bench_stat_t mc_snprintf, mc_builder, ss_snprintf, ss_builder;
+	run(snprintf_move_completed, &mc_snprintf, runs);
+	run(builder_move_completed, &mc_builder, runs);
+	run(snprintf_system_state, &ss_snprintf, runs);
+	run(builder_system_state, &ss_builder, runs);
+	
+	// Ciclos por llamada: media/mínimo (el mínimo descarta las ISRs intercaladas)
+	char msg[128];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, MSG_BENCH);
+	resp_str_P(&r, PSTR(":N="));
+	resp_uint(&r, runs);
+	resp_str_P(&r, PSTR(",MOVE_COMPLETED:"));
+	append_stat(&r, PSTR("SNPRINTF"), &mc_snprintf, runs);
+	resp_char(&r, ',');
+	append_stat(&r, PSTR("BUILDER"), &mc_builder, runs);
+	resp_str_P(&r, PSTR(",SYSTEM_STATE:"));
+	append_stat(&r, PSTR("SNPRINTF"), &ss_snprintf, runs);
+	resp_char(&r, ',');
+	append_stat(&r, PSTR("BUILDER"), &ss_builder, runs);
+	uart_send_response(msg);
+	
+	pending_runs = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef FORMAT_BENCHMARK_H
+#define FORMAT_BENCHMARK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Comparación de coste snprintf vs response_builder para las líneas
+// STEPPER_MOVE_COMPLETED y SYSTEM_STATE. Se pide desde el parser (BM:<n>) y
+// se ejecuta en el loop principal, con interrupciones habilitadas, para no
+// bloquear la ISR de recepción ni perder overflows del reloj.
+
+#define FORMAT_BENCHMARK_DEFAULT_RUNS 100
+#define FORMAT_BENCHMARK_MAX_RUNS     1000
+
+// Devuelve false si ya hay uno pendiente o los ejes se están moviendo
+bool format_benchmark_request(uint16_t runs);
+
+// Llamar desde el loop principal; envía BENCH:... al terminar
+void format_benchmark_update(void);
+
+#endif // FORMAT_BENCHMARK_H
@@ -0,0 +1,433 @@
+#include "gcode_interpreter.h"
+#include "response_builder.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/servo_driver.h"
+#include "../drivers/gripper_driver.h"
+#include "../drivers/system_clock.h"
+#include "../moves/units.h"
+#include "../config/system_config.h"
+#include "../config/parameters.h"
+#include "../config/command_protocol.h"
+#include <avr/pgmspace.h>
+
+typedef enum {
+	BLOCK_MOVE,         // a, b: destino (pasos, absoluto o relativo según flags)
+	BLOCK_DWELL,        // a: ms
+	BLOCK_SERVO,        // a: servo, b: ángulo
+	BLOCK_GRIPPER       // a: 1 = cerrar
+} block_type_t;
+
+#define BLOCK_HAS_X     0x01
+#define BLOCK_HAS_Y     0x02
+#define BLOCK_RELATIVE  0x04
+
+typedef struct {
+	uint8_t type;
+	uint8_t flags;
+	int32_t a;
+	int32_t b;
+	uint16_t h_speed;   // pasos/s (0 = velocidad del eje: V o preset)
+	uint16_t v_speed;
+} gcode_block_t;
+
+// Palabras reconocidas en una línea (valores en centésimas)
+typedef struct {
+	uint32_t present;   // Bit (letra - 'A')
+	int32_t value[26];
+} gcode_words_t;
+
+#define WORD_BIT(letter)    ((uint32_t)1 << ((letter) - 'A'))
+
+static gcode_block_t queue[GCODE_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+
+static gcode_block_t held_block;     // Sin sitio en la cola: su "ok" espera
+static bool held = false;
+static bool sync_pending = false;    // M400: "ok" al vaciarse la cola
+
+static gcode_block_t active_block;
+static bool active = false;
+static uint32_t dwell_start_ms = 0;
+
+// Estado modal
+static bool relative_mode = false;
+static int16_t motion_mode = 0;      // G0/G1 vigente para líneas con solo X/Y
+static int32_t feed_centi = 0;       // Centésimas de mm/min (0 = sin F todavía)
+
+static void send_ok(void) {
+	uart_send_response("ok");
+}
+
+#define NO_COLUMN 0xFF
+
+// "error:<motivo>[:AT=<columna>]"
+static void send_error(const char* reason_P, uint8_t column) {
+	char msg[32];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_str_P(&r, PSTR("error:"));
+	resp_str_P(&r, reason_P);
+	if (column != NO_COLUMN) {
+		resp_str_P(&r, PSTR(":AT="));
+		resp_uint(&r, column);
+	}
+	uart_send_response(msg);
+}
+
+// Número con signo y hasta 2 decimales, en centésimas
+static bool parse_centi(const char** p, int32_t* value) {
+	const char* q = *p;
+	bool negative = (*q == '-');
+	if (*q == '-' || *q == '+') q++;
+
+	int32_t v = 0;
+	uint8_t digits = 0;
+	while (*q >= '0' && *q <= '9') {
+		if (v > 2000000L) return false;
+		v = v * 10 + (*q++ - '0');
+		digits++;
+	}
+	v *= 100;
+	if (*q == '.') {
+		q++;
+		int32_t scale = 10;
+		while (*q >= '0' && *q <= '9') {
+			v += (*q++ - '0') * scale;
+			scale /= 10;
+			digits++;
+		}
+	}
+	if (digits == 0) return false;
+	*value = negative ? -v : v;
+	*p = q;
+	return true;
+}
+
+static bool is_integer(int32_t centi) {
+	return centi % 100 == 0;
+}
+
+// Lee las palabras de la línea. N y el checksum (*) se ignoran; los
+// comentarios "(...)" y ";..." también. G90/G91/G21 se aplican aquí y el
+// G de movimiento queda en *motion_g (-1 si no hay)
+static bool parse_words(const char* line, gcode_words_t* w, int16_t* motion_g) {
+	const char* p = line;
+	w->present = 0;
+	*motion_g = -1;
+
+	while (*p && *p != ';' && *p != '*') {
+		char c = *p;
+		if (c == ' ' || c == '\t') {
+			p++;
+			continue;
+		}
+		if (c == '(') {
+			while (*p && *p != ')') p++;
+			if (*p) p++;
+			continue;
+		}
+		if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+		uint8_t column = (uint8_t)(p - line);
+		if (c < 'A' || c > 'Z') {
+			send_error(PSTR("SYNTAX"), column);
+			return false;
+		}
+
+		p++;
+		int32_t value;
+		if (!parse_centi(&p, &value)) {
+			send_error(PSTR("SYNTAX"), column);
+			return false;
+		}
+
+		switch (c) {
+			case 'G':
+				if (!is_integer(value)) {
+					send_error(PSTR("UNSUPPORTED"), column);
+					return false;
+				}
+				switch (value / 100) {
+					case 90: relative_mode = false; break;
+					case 91: relative_mode = true; break;
+					case 21: break;
+					case 0: case 1: case 4: case 28:
+						if (*motion_g >= 0) {
+							send_error(PSTR("MODAL_CONFLICT"), column);
+							return false;
+						}
+						*motion_g = (int16_t)(value / 100);
+						break;
+					default:
+						send_error(PSTR("UNSUPPORTED"), column);
+						return false;
+				}
+				break;
+			case 'N':
+				break;
+			case 'M': case 'X': case 'Y': case 'F': case 'P': case 'S':
+				if (w->present & WORD_BIT(c)) {
+					send_error(PSTR("REPEATED_WORD"), column);
+					return false;
+				}
+				w->present |= WORD_BIT(c);
+				w->value[c - 'A'] = value;
+				break;
+			default:
+				send_error(PSTR("UNSUPPORTED"), column);
+				return false;
+		}
+	}
+	return true;
+}
+
+// Avance en mm/min (centésimas) a pasos/s de cada eje, dentro de los topes
+static uint16_t feed_to_steps(int32_t feed, units_axis_t axis, uint16_t max_speed) {
+	uint32_t steps = units_feed_to_rate(axis, (uint32_t)feed);
+	if (steps < MIN_SPEED) return MIN_SPEED;
+	if (steps > max_speed) return max_speed;
+	return (uint16_t)steps;
+}
+
+// Los bloques se convierten en el orden en que se ejecutan: en G91 el resto
+// de cada conversión pasa al siguiente bloque y no se acumula error
+static int32_t centi_to_steps(int32_t centi, units_axis_t axis) {
+	return relative_mode ? units_relative_steps(axis, centi) : units_absolute_steps(axis, centi);
+}
+
+static void push_block(const gcode_block_t* block) {
+	queue[(queue_head + queue_count) % GCODE_QUEUE_SIZE] = *block;
+	queue_count++;
+}
+
+// Devuelve false (ya respondido con error) si la línea no genera un bloque válido
+static bool build_block(gcode_words_t* w, int16_t motion_g, gcode_block_t* block, bool* has_block) {
+	*has_block = false;
+	block->flags = 0;
+	block->h_speed = 0;
+	block->v_speed = 0;
+
+	if (w->present & WORD_BIT('F')) {
+		if (w->value['F' - 'A'] <= 0) {
+			send_error(PSTR("RANGE"), NO_COLUMN);
+			return false;
+		}
+		feed_centi = w->value['F' - 'A'];
+	}
+
+	if (w->present & WORD_BIT('M')) {
+		int32_t m = w->value['M' - 'A'];
+		if (motion_g >= 0 || !is_integer(m)) {
+			send_error(PSTR("UNSUPPORTED"), NO_COLUMN);
+			return false;
+		}
+		switch (m / 100) {
+			case 10:
+			case 11:
+				block->type = BLOCK_GRIPPER;
+				block->a = (m / 100 == 10);
+				*has_block = true;
+				return true;
+			case 280: {
+				if ((w->present & (WORD_BIT('P') | WORD_BIT('S'))) != (WORD_BIT('P') | WORD_BIT('S'))) {
+					send_error(PSTR("RANGE"), NO_COLUMN);
+					return false;
+				}
+				int32_t servo = w->value['P' - 'A'];
+				int32_t angle = w->value['S' - 'A'];
+				if ((servo != 100 && servo != 200) || angle < 0 || angle > 18000) {
+					send_error(PSTR("RANGE"), NO_COLUMN);
+					return false;
+				}
+				block->type = BLOCK_SERVO;
+				block->a = servo / 100;
+				block->b = angle / 100;
+				*has_block = true;
+				return true;
+			}
+			case 400:
+				sync_pending = true;
+				return true;
+			default:
+				send_error(PSTR("UNSUPPORTED"), NO_COLUMN);
+				return false;
+		}
+	}
+
+	if (motion_g == 0 || motion_g == 1) {
+		motion_mode = motion_g;
+	} else if (motion_g < 0 && (w->present & (WORD_BIT('X') | WORD_BIT('Y')))) {
+		motion_g = motion_mode;
+	}
+	
+	switch (motion_g) {
+		case 0:
+		case 1:
+			if (!(w->present & (WORD_BIT('X') | WORD_BIT('Y')))) return true;
+			block->type = BLOCK_MOVE;
+			block->flags = relative_mode ? BLOCK_RELATIVE : 0;
+			if (w->present & WORD_BIT('X')) {
+				block->flags |= BLOCK_HAS_X;
+				block->a = centi_to_steps(w->value['X' - 'A'], UNITS_AXIS_H);
+			}
+			if (w->present & WORD_BIT('Y')) {
+				block->flags |= BLOCK_HAS_Y;
+				block->b = centi_to_steps(w->value['Y' - 'A'], UNITS_AXIS_V);
+			}
+			// G0 (h_speed/v_speed = 0) va a la velocidad del eje, que ya
+			// respeta el preset activo
+			if (motion_g == 1 && feed_centi > 0) {
+				block->h_speed = feed_to_steps(feed_centi, UNITS_AXIS_H, param_get(PARAM_MAX_SPEED_H));
+				block->v_speed = feed_to_steps(feed_centi, UNITS_AXIS_V, param_get(PARAM_MAX_SPEED_V));
+			}
+			*has_block = true;
+			return true;
+
+		case 4: {
+			int32_t ms;
+			if (w->present & WORD_BIT('P')) {
+				ms = w->value['P' - 'A'] / 100;
+			} else if (w->present & WORD_BIT('S')) {
+				ms = w->value['S' - 'A'] * 10;
+			} else {
+				send_error(PSTR("RANGE"), NO_COLUMN);
+				return false;
+			}
+			if (ms < 0 || ms > 3600000L) {
+				send_error(PSTR("RANGE"), NO_COLUMN);
+				return false;
+			}
+			block->type = BLOCK_DWELL;
+			block->a = ms;
+			*has_block = true;
+			return true;
+		}
+
+		case 28:
+			// Sin ejes: ambos. Con X/Y solo los indicados (el valor se ignora)
+			block->type = BLOCK_MOVE;
+			block->flags = (w->present & (WORD_BIT('X') | WORD_BIT('Y'))) ? 0 : (BLOCK_HAS_X | BLOCK_HAS_Y);
+			if (w->present & WORD_BIT('X')) block->flags |= BLOCK_HAS_X;
+			if (w->present & WORD_BIT('Y')) block->flags |= BLOCK_HAS_Y;
+			block->a = 0;
+			block->b = 0;
+			*has_block = true;
+			return true;
+
+		default:
+			// Solo palabras modales (F, G90...)
+			return true;
+	}
+}
+
+void gcode_execute_line(const char* line) {
+	if (held || sync_pending) {
+		// El host no esperó el "ok" pendiente
+		send_error(PSTR("BUSY"), NO_COLUMN);
+		return;
+	}
+
+	gcode_words_t words;
+	int16_t motion_g;
+	gcode_block_t block;
+	bool has_block;
+	if (!parse_words(line, &words, &motion_g)) return;
+	if (!build_block(&words, motion_g, &block, &has_block)) return;
+
+	if (has_block) {
+		if (queue_count >= GCODE_QUEUE_SIZE) {
+			held_block = block;
+			held = true;
+			return;
+		}
+		push_block(&block);
+	}
+	if (!sync_pending) {
+		send_ok();
+	}
+}
+
+
+static void start_block(const gcode_block_t* block) {
+	switch (block->type) {
+		case BLOCK_MOVE: {
+			int32_t h, v;
+			stepper_get_position(&h, &v);
+			if (block->flags & BLOCK_RELATIVE) {
+				if (block->flags & BLOCK_HAS_X) h += block->a;
+				if (block->flags & BLOCK_HAS_Y) v += block->b;
+			} else {
+				if (block->flags & BLOCK_HAS_X) h = block->a;
+				if (block->flags & BLOCK_HAS_Y) v = block->b;
+			}
+
+			// El avance del bloque solo rige para este movimiento; el driver lo
+			// acota al preset activo al arrancarlo
+			move_limits_t limits = { block->h_speed, block->v_speed, 0, 0 };
+			stepper_move_absolute_limited(h, v, &limits);
+			break;
+		}
+		case BLOCK_DWELL:
+			dwell_start_ms = system_clock_millis();
+			break;
+		case BLOCK_SERVO:
+			servo_set_position((uint8_t)block->a, (uint8_t)block->b);
+			break;
+		case BLOCK_GRIPPER:
+			if (block->a) {
+				gripper_close();
+			} else {
+				gripper_open();
+			}
+			break;
+	}
+}
+
+static bool actuators_idle(void) {
+	return !stepper_is_moving() && !servo_is_busy() && !gripper_is_busy();
+}
+
+void gcode_update(void) {
+	if (active) {
+		if (!actuators_idle()) return;
+		if (active_block.type == BLOCK_DWELL &&
+			system_clock_millis() - dwell_start_ms < (uint32_t)active_block.a) return;
+		active = false;
+	}
+
+	if (queue_count > 0 && actuators_idle()) {
+		active_block = queue[queue_head];
+		queue_head = (queue_head + 1) % GCODE_QUEUE_SIZE;
+		queue_count--;
+		active = true;
+		start_block(&active_block);
+
+		if (held) {
+			push_block(&held_block);
+			held = false;
+			send_ok();
+		}
+		return;
+	}
+
+	if (sync_pending && queue_count == 0 && !active && !held) {
+		sync_pending = false;
+		send_ok();
+	}
+}
+
+void gcode_abort(void) {
+	// El host espera respuesta de la línea retenida
+	if (held || sync_pending) {
+		send_error(PSTR("ABORTED"), NO_COLUMN);
+	}
+	queue_count = 0;
+	held = false;
+	sync_pending = false;
+	active = false;
+}
+
+bool gcode_is_busy(void) {
+	return active || queue_count > 0 || held;
+}
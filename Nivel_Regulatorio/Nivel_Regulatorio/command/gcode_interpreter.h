@@ -0,0 +1,36 @@
+#ifndef GCODE_INTERPRETER_H
+#define GCODE_INTERPRETER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Subconjunto de G-code para el pórtico, recibido como líneas sueltas
+// (uart_command_is_line). Cada línea se convierte en un bloque y se encola;
+// "ok" sale al encolarlo, así el host transmite la siguiente mientras se
+// ejecuta la anterior. Con la cola llena el "ok" se retiene hasta que haya
+// sitio. Los bloques se ejecutan en orden, cada uno cuando terminó el
+// anterior (ejes, brazo y pinza en reposo).
+//
+//   G0/G1 X Y [F]   Movimiento rápido / con avance (mm, F en mm/min)
+//   G4 P<ms>|S<s>   Pausa
+//   G28 [X] [Y]     Ir al origen de máquina (posición 0 de los ejes)
+//   G90/G91         Coordenadas absolutas / relativas
+//   G21             Milímetros (única unidad)
+//   M10 / M11       Cerrar / abrir pinza
+//   M280 P<1|2> S<ángulo>  Servo del brazo
+//   M400            "ok" recién cuando terminó todo lo encolado
+//
+// Errores: "error:<motivo>[:AT=<columna>]" y la línea se descarta.
+
+// Procesar una línea recibida (responde ok / error)
+void gcode_execute_line(const char* line);
+
+// Descartar los bloques pendientes (S / parada rápida)
+void gcode_abort(void);
+
+bool gcode_is_busy(void);
+
+// Llamar desde el loop principal
+void gcode_update(void);
+
+#endif // GCODE_INTERPRETER_H
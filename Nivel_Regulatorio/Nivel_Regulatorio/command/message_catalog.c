@@ -0,0 +1,61 @@
+#include "message_catalog.h"
+#include "../drivers/uart_driver.h"
+#include <avr/pgmspace.h>
+
+#define MESSAGE_TEXT_DEF(name, text) static const char text_##name[] PROGMEM = text;
+#define MESSAGE_TEXT_REF(name, text) text_##name,
+
+MESSAGE_CATALOG(MESSAGE_TEXT_DEF)
+
+static const char* const message_texts[MSG_COUNT] PROGMEM = {
+	MESSAGE_CATALOG(MESSAGE_TEXT_REF)
+};
+
+static bool id_mode = false;
+
+void message_catalog_set_id_mode(bool enabled) {
+	id_mode = enabled;
+}
+
+bool message_catalog_id_mode(void) {
+	return id_mode;
+}
+
+const char* message_catalog_text(msg_id_t id) {
+	if (id >= MSG_COUNT) return PSTR("?");
+	return (const char*)pgm_read_ptr(&message_texts[id]);
+}
+
+void resp_msg(response_t* r, msg_id_t id) {
+	if (id_mode) {
+		resp_char(r, '#');
+		resp_uint(r, id);
+		} else {
+		resp_str_P(r, message_catalog_text(id));
+	}
+}
+
+void message_send(msg_id_t id) {
+	char msg[MESSAGE_MAX_TEXT];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, id);
+	uart_send_response(msg);
+}
+
+void message_catalog_dump(void) {
+	char line[MESSAGE_MAX_TEXT + 12];
+	response_t r;
+	for (uint8_t i = 0; i < MSG_COUNT; i++) {
+		resp_init(&r, line, sizeof(line));
+		resp_str_P(&r, PSTR("MSG:"));
+		resp_uint(&r, i);
+		resp_char(&r, ',');
+		resp_str_P(&r, message_catalog_text((msg_id_t)i));
+		uart_send_response(line);
+	}
+	resp_init(&r, line, sizeof(line));
+	resp_str_P(&r, PSTR("OK:CATALOG:"));
+	resp_uint(&r, MSG_COUNT);
+	uart_send_response(line);
+}
@@ -0,0 +1,196 @@
+#ifndef MESSAGE_CATALOG_H
+#define MESSAGE_CATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "response_builder.h"
+
+// Catálogo de textos de mensajes en flash (PROGMEM), indexado por ID.
+// Cada entrada es la cabecera de una línea del protocolo; los parámetros se
+// agregan después con response_builder. En modo ID (MI:1) la cabecera se
+// envía como "#<id>" y el supervisor la expande con la tabla de MC?:
+//
+//   STEPPER_MOVE_COMPLETED:100,200,...   ->   #5:100,200,...
+//
+// Los IDs son la posición en la lista: agregar siempre al final.
+
+#define MESSAGE_CATALOG(X) \
+	X(SYSTEM_READY,                     "SYSTEM_READY") \
+	X(SYSTEM_INITIALIZED,               "SYSTEM_INITIALIZED") \
+	X(SYSTEM_STATUS,                    "SYSTEM_STATUS") \
+	X(SYSTEM_STATE,                     "SYSTEM_STATE") \
+	X(STEPPER_MOVE_STARTED,             "STEPPER_MOVE_STARTED") \
+	X(STEPPER_MOVE_COMPLETED,           "STEPPER_MOVE_COMPLETED") \
+	X(STEPPER_MOVE_RESUMED,             "STEPPER_MOVE_RESUMED") \
+	X(STEPPER_EMERGENCY_STOP,           "STEPPER_EMERGENCY_STOP") \
+	X(STEPPER_DECEL_STOP,               "STEPPER_DECEL_STOP") \
+	X(STEPPER_HOLD,                     "STEPPER_HOLD") \
+	X(STEPPER_JOG_STARTED,              "STEPPER_JOG_STARTED") \
+	X(STEPPER_JOG_STOPPED,              "STEPPER_JOG_STOPPED") \
+	X(JOG_POS,                          "JOG_POS") \
+	X(MOVEMENT_SNAPSHOTS,               "MOVEMENT_SNAPSHOTS") \
+	X(CALIBRATION_STARTED,              "CALIBRATION_STARTED") \
+	X(CALIBRATION_COMPLETED,            "CALIBRATION_COMPLETED") \
+	X(POSITION_AT_LIMIT,                "POSITION_AT_LIMIT") \
+	X(LIMIT_H_LEFT_TRIGGERED,           "LIMIT_H_LEFT_TRIGGERED") \
+	X(LIMIT_H_RIGHT_TRIGGERED,          "LIMIT_H_RIGHT_TRIGGERED") \
+	X(LIMIT_V_DOWN_TRIGGERED,           "LIMIT_V_DOWN_TRIGGERED") \
+	X(LIMIT_V_UP_TRIGGERED,             "LIMIT_V_UP_TRIGGERED") \
+	X(LIMIT_STATUS,                     "LIMIT_STATUS") \
+	X(SERVO_CHANGED,                    "SERVO_CHANGED") \
+	X(SERVO_MOVE_STARTED,               "SERVO_MOVE_STARTED") \
+	X(SERVO_MOVE_COMPLETED,             "SERVO_MOVE_COMPLETED") \
+	X(GRIPPER_ACTION_STARTED,           "GRIPPER_ACTION_STARTED") \
+	X(GRIPPER_ACTION_COMPLETED,         "GRIPPER_ACTION_COMPLETED") \
+	X(GRIPPER_STATUS,                   "GRIPPER_STATUS") \
+	X(GRIPPER_ALREADY_OPEN,             "GRIPPER_ALREADY_OPEN") \
+	X(GRIPPER_ALREADY_CLOSED,           "GRIPPER_ALREADY_CLOSED") \
+	X(GRIPPER_BUSY,                     "GRIPPER_BUSY") \
+	X(GRIPPER_INIT,                     "GRIPPER_INIT") \
+	X(EEPROM_LOAD,                      "EEPROM_LOAD") \
+	X(EEPROM_FIRST_TIME,                "EEPROM_FIRST_TIME") \
+	X(TRIGGER_EVENT,                    "TRIGGER_EVENT") \
+	X(CORRECTION_TIMEOUT,               "CORRECTION_TIMEOUT") \
+	X(CORRECTION_ABORTED,               "CORRECTION_ABORTED") \
+	X(CORRECTION_CONVERGED,             "CORRECTION_CONVERGED") \
+	X(HISTORY_BIN,                      "HISTORY_BIN") \
+	X(OK_MOVE_XY,                       "OK:MOVE_XY") \
+	X(ERR_INVALID_PARAMS_MOVE_XY,       "ERR:INVALID_PARAMS_MOVE_XY") \
+	X(OK_DECEL_STOP,                    "OK:DECEL_STOP") \
+	X(ERR_NOT_MOVING,                   "ERR:NOT_MOVING") \
+	X(OK_SOFT_LIMITS,                   "OK:SOFT_LIMITS") \
+	X(ERR_INVALID_PARAMS_SOFT_LIMITS,   "ERR:INVALID_PARAMS_SOFT_LIMITS") \
+	X(OK_JOG,                           "OK:JOG") \
+	X(ERR_JOG_NOT_ACTIVE,               "ERR:JOG_NOT_ACTIVE") \
+	X(ERR_INVALID_PARAMS_JOG,           "ERR:INVALID_PARAMS_JOG") \
+	X(OK_E,                             "OK:E") \
+	X(ERR_INVALID_PARAMS_ERROR,         "ERR:INVALID_PARAMS_ERROR") \
+	X(OK_CORRECTION_STOP,               "OK:CORRECTION_STOP") \
+	X(OK_CORRECTION_GAINS,              "OK:CORRECTION_GAINS") \
+	X(ERR_INVALID_PARAMS_GAINS,         "ERR:INVALID_PARAMS_GAINS") \
+	X(OK_TRIGGERS,                      "OK:TRIGGERS") \
+	X(ERR_TRIGGER_LIST_FULL,            "ERR:TRIGGER_LIST_FULL") \
+	X(ERR_INVALID_PARAMS_TRIGGER,       "ERR:INVALID_PARAMS_TRIGGER") \
+	X(OK_TRIGGERS_CLEARED,              "OK:TRIGGERS_CLEARED") \
+	X(OK_TRIGGER_MODE,                  "OK:TRIGGER_MODE") \
+	X(TRIGGERS,                         "TRIGGERS") \
+	X(CLOCK,                            "CLOCK") \
+	X(PONG,                             "PONG") \
+	X(OK_HISTORY_PERIOD,                "OK:HISTORY_PERIOD") \
+	X(ERR_INVALID_PARAMS_HISTORY,       "ERR:INVALID_PARAMS_HISTORY") \
+	X(POS_AT,                           "POS_AT") \
+	X(ERR_HISTORY_OUT_OF_RANGE,         "ERR:HISTORY_OUT_OF_RANGE") \
+	X(ERR_INVALID_PARAMS_HISTORY_DUMP,  "ERR:INVALID_PARAMS_HISTORY_DUMP") \
+	X(OK_FEED_HOLD,                     "OK:FEED_HOLD") \
+	X(ERR_FEED_HOLD_NOT_MOVING,         "ERR:FEED_HOLD_NOT_MOVING") \
+	X(OK_FEED_RESUME,                   "OK:FEED_RESUME") \
+	X(ERR_FEED_NOT_HELD,                "ERR:FEED_NOT_HELD") \
+	X(OK_STOP,                          "OK:STOP") \
+	X(OK_ARM_INSTANT,                   "OK:ARM_INSTANT") \
+	X(OK_ARM_SMOOTH,                    "OK:ARM_SMOOTH") \
+	X(ERR_INVALID_ARM_PARAMS,           "ERR:INVALID_ARM_PARAMS") \
+	X(OK_ARMS_RESET,                    "OK:ARMS_RESET") \
+	X(OK_SERVO1_POS,                    "OK:SERVO1_POS") \
+	X(OK_SERVO2_POS,                    "OK:SERVO2_POS") \
+	X(ERR_INVALID_SERVO_NUM,            "ERR:INVALID_SERVO_NUM") \
+	X(ERR_INVALID_PARAMS_POS,           "ERR:INVALID_PARAMS_POS") \
+	X(OK_GRIPPER_TOGGLE,                "OK:GRIPPER_TOGGLE") \
+	X(OK_VELOCIDADES,                   "OK:VELOCIDADES") \
+	X(ERR_INVALID_PARAMS_VELOCIDADES,   "ERR:INVALID_PARAMS_VELOCIDADES") \
+	X(OK_FEED_OVERRIDE,                 "OK:FEED_OVERRIDE") \
+	X(ERR_INVALID_PARAMS_FEED_OVERRIDE, "ERR:INVALID_PARAMS_FEED_OVERRIDE") \
+	X(LIMITS,                           "LIMITS") \
+	X(TELEMETRY,                        "TELEMETRY") \
+	X(OK_TELEMETRY,                     "OK:TELEMETRY") \
+	X(OK_TELEMETRY_OFF,                 "OK:TELEMETRY_OFF") \
+	X(ERR_INVALID_TOPIC,                "ERR:INVALID_TOPIC") \
+	X(LOG,                              "LOG") \
+	X(OK_LOG_LEVEL,                     "OK:LOG_LEVEL") \
+	X(OK_LOG_RATE,                      "OK:LOG_RATE") \
+	X(ERR_INVALID_LOG_CATEGORY,         "ERR:INVALID_LOG_CATEGORY") \
+	X(BENCH,                            "BENCH") \
+	X(OK_BENCH,                         "OK:BENCH") \
+	X(ERR_BENCH_BUSY,                   "ERR:BENCH_BUSY") \
+	X(OK_HB,                            "OK:HB") \
+	X(SERVO_POS,                        "SERVO_POS") \
+	X(OK_XY,                            "OK:XY") \
+	X(OK_CALIBRATION_STARTED,           "OK:CALIBRATION_STARTED") \
+	X(OK_CALIBRATION_ENDED,             "OK:CALIBRATION_ENDED") \
+	X(SNAPSHOT_ERROR_NOT_MOVING,        "SNAPSHOT_ERROR:NOT_MOVING") \
+	X(SNAPSHOT_ERROR_MAX_REACHED,       "SNAPSHOT_ERROR:MAX_REACHED") \
+	X(ERR_UNKNOWN_CMD,                  "ERR:UNKNOWN_CMD") \
+	X(OK_MSG_IDS,                       "OK:MSG_IDS") \
+	X(RX_STATS,                         "RX_STATS") \
+	X(OK_ACK,                           "OK:ACK") \
+	X(OK_BATCH,                         "OK:BATCH") \
+	X(ERR_BATCH,                        "ERR:BATCH") \
+	X(ERR_NOT_BATCHABLE,                "ERR:NOT_BATCHABLE") \
+	X(OK_MACRO_UPLOAD,                  "OK:MACRO_UPLOAD") \
+	X(OK_MACRO_RUN,                     "OK:MACRO_RUN") \
+	X(OK_MACRO_ABORT,                   "OK:MACRO_ABORT") \
+	X(ERR_MACRO_BUSY,                   "ERR:MACRO_BUSY") \
+	X(ERR_MACRO_INVALID,                "ERR:MACRO_INVALID") \
+	X(ERR_INVALID_PARAMS_MACRO,         "ERR:INVALID_PARAMS_MACRO") \
+	X(MACRO_STATUS,                     "MACRO_STATUS") \
+	X(MACRO_COMPLETED,                  "MACRO_COMPLETED") \
+	X(MACRO_ABORTED,                    "MACRO_ABORTED") \
+	X(OK_STEP_QUEUE,                    "OK:STEP_QUEUE") \
+	X(OK_STEP_QUEUE_START,              "OK:STEP_QUEUE_START") \
+	X(OK_STEP_QUEUE_END,                "OK:STEP_QUEUE_END") \
+	X(OK_STEP_QUEUE_CLEAR,              "OK:STEP_QUEUE_CLEAR") \
+	X(ERR_STEP_QUEUE_FULL,              "ERR:STEP_QUEUE_FULL") \
+	X(ERR_STEP_QUEUE_BUSY,              "ERR:STEP_QUEUE_BUSY") \
+	X(ERR_STEP_QUEUE_EMPTY,             "ERR:STEP_QUEUE_EMPTY") \
+	X(ERR_INVALID_PARAMS_STEP_QUEUE,    "ERR:INVALID_PARAMS_STEP_QUEUE") \
+	X(STEP_QUEUE_STATUS,                "STEP_QUEUE_STATUS") \
+	X(STEP_QUEUE_STARTED,               "STEP_QUEUE_STARTED") \
+	X(STEP_QUEUE_DONE,                  "STEP_QUEUE_DONE") \
+	X(STEP_QUEUE_UNDERRUN,              "STEP_QUEUE_UNDERRUN") \
+	X(STEP_QUEUE_ABORTED,               "STEP_QUEUE_ABORTED") \
+	X(OK_MOVE_ABS,                      "OK:MOVE_ABS") \
+	X(ERR_INVALID_PARAMS_MOVE_ABS,      "ERR:INVALID_PARAMS_MOVE_ABS") \
+	X(PARAM,                            "PARAM") \
+	X(OK_PARAM,                         "OK:PARAM") \
+	X(OK_PARAMS,                        "OK:PARAMS") \
+	X(OK_PARAM_SAVE,                    "OK:PARAM_SAVE") \
+	X(OK_PARAM_LOAD,                    "OK:PARAM_LOAD") \
+	X(ERR_PARAM_UNKNOWN,                "ERR:PARAM_UNKNOWN") \
+	X(ERR_PARAM_RANGE,                  "ERR:PARAM_RANGE") \
+	X(ERR_PARAM_BUSY,                   "ERR:PARAM_BUSY") \
+	X(ERR_PARAM_EMPTY,                  "ERR:PARAM_EMPTY") \
+	X(ERR_INVALID_PARAMS_PARAM,         "ERR:INVALID_PARAMS_PARAM") \
+	X(PRESET,                           "PRESET") \
+	X(PRESET_CHANGED,                   "PRESET_CHANGED") \
+	X(OK_PRESET,                        "OK:PRESET") \
+	X(OK_PRESET_SET,                    "OK:PRESET_SET") \
+	X(ERR_PRESET_UNKNOWN,               "ERR:PRESET_UNKNOWN") \
+	X(ERR_INVALID_PARAMS_PRESET,        "ERR:INVALID_PARAMS_PRESET") \
+	X(ERR_TRIGGER_BUSY,                 "ERR:TRIGGER_BUSY")
+
+#define MESSAGE_ID_ENUM(name, text) MSG_##name,
+
+typedef enum {
+	MESSAGE_CATALOG(MESSAGE_ID_ENUM)
+	MSG_COUNT
+} msg_id_t;
+
+// Texto más largo del catálogo + '\0' (buffers de mensajes sin parámetros)
+#define MESSAGE_MAX_TEXT 40
+
+void message_catalog_set_id_mode(bool enabled);
+bool message_catalog_id_mode(void);
+
+// Puntero a flash del texto (leer con pgm_read_byte / resp_str_P)
+const char* message_catalog_text(msg_id_t id);
+
+// Cabecera del mensaje: texto o "#<id>" según el modo
+void resp_msg(response_t* r, msg_id_t id);
+
+// Línea sin parámetros
+void message_send(msg_id_t id);
+
+// Tabla completa: "MSG:<id>,<texto>" por entrada y "OK:CATALOG:<n>" al final,
+// siempre en texto para que el supervisor pueda recuperarla en modo ID
+void message_catalog_dump(void);
+
+#endif // MESSAGE_CATALOG_H
@@ -0,0 +1,105 @@
+#include "response_builder.h"
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+static const uint32_t powers_of_ten[10] PROGMEM = {
+	1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL,
+	10000UL, 1000UL, 100UL, 10UL, 1UL
+};
+
+void resp_init(response_t* r, char* buf, uint16_t cap) {
+	r->buf = buf;
+	r->len = 0;
+	r->cap = cap;
+	if (cap) buf[0] = '\0';
+}
+
+void resp_char(response_t* r, char c) {
+	if (r->len + 1 < r->cap) {
+		r->buf[r->len++] = c;
+		r->buf[r->len] = '\0';
+	}
+}
+
+void resp_str(response_t* r, const char* s) {
+	while (*s && r->len + 1 < r->cap) {
+		r->buf[r->len++] = *s++;
+	}
+	r->buf[r->len] = '\0';
+}
+
+void resp_str_P(response_t* r, const char* s) {
+	char c;
+	while ((c = pgm_read_byte(s++)) && r->len + 1 < r->cap) {
+		r->buf[r->len++] = c;
+	}
+	r->buf[r->len] = '\0';
+}
+
+// Dígitos de value con al menos min_digits cifras (ceros a la izquierda)
+static void put_digits(response_t* r, uint32_t value, uint8_t min_digits) {
+	bool started = false;
+	for (uint8_t i = 0; i < 10; i++) {
+		uint32_t power = pgm_read_dword(&powers_of_ten[i]);
+		char digit = '0';
+		while (value >= power) {
+			value -= power;
+			digit++;
+		}
+		if (digit != '0' || started || i >= 10 - min_digits) {
+			started = true;
+			resp_char(r, digit);
+		}
+	}
+}
+
+void resp_uint(response_t* r, uint32_t value) {
+	put_digits(r, value, 1);
+}
+
+void resp_int(response_t* r, int32_t value) {
+	if (value < 0) {
+		resp_char(r, '-');
+		put_digits(r, (uint32_t)0 - (uint32_t)value, 1);
+		} else {
+		put_digits(r, (uint32_t)value, 1);
+	}
+}
+
+void resp_fixed(response_t* r, int32_t value, uint8_t decimals) {
+	if (decimals == 0 || decimals > 9) {
+		resp_int(r, value);
+		return;
+	}
+	uint32_t magnitude = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+	if (value < 0) resp_char(r, '-');
+	
+	// Separar parte entera y decimal restando la potencia del divisor
+	uint32_t scale = pgm_read_dword(&powers_of_ten[9 - decimals]);
+	uint32_t integer = 0;
+	uint32_t chunk = scale;
+	uint32_t chunk_count = 1;
+	// División binaria: doblar el bloque mientras quepa y restar de mayor a menor
+	while (chunk <= (magnitude >> 1)) {
+		chunk <<= 1;
+		chunk_count <<= 1;
+	}
+	while (chunk_count) {
+		if (magnitude >= chunk) {
+			magnitude -= chunk;
+			integer += chunk_count;
+		}
+		chunk >>= 1;
+		chunk_count >>= 1;
+	}
+	
+	put_digits(r, integer, 1);
+	resp_char(r, '.');
+	put_digits(r, magnitude, decimals);
+}
+
+void resp_int_pair(response_t* r, int32_t a, int32_t b) {
+	resp_int(r, a);
+	resp_char(r, ',');
+	resp_int(r, b);
+}
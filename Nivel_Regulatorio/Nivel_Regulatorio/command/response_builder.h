@@ -0,0 +1,34 @@
+#ifndef RESPONSE_BUILDER_H
+#define RESPONSE_BUILDER_H
+
+#include <stdint.h>
+
+// Constructor de respuestas sin snprintf: concatena literales y enteros
+// directamente en el buffer de salida. Las conversiones usan restas de
+// potencias de 10 (sin divisiones de 32 bits, caras en AVR). Si el buffer se
+// llena, el texto se trunca y siempre queda terminado en '\0'.
+
+typedef struct {
+	char* buf;
+	uint16_t len;
+	uint16_t cap;       // Incluye el '\0'
+} response_t;
+
+void resp_init(response_t* r, char* buf, uint16_t cap);
+void resp_char(response_t* r, char c);
+void resp_str(response_t* r, const char* s);
+void resp_str_P(response_t* r, const char* s);      // Texto en flash (PSTR / PROGMEM)
+void resp_uint(response_t* r, uint32_t value);
+void resp_int(response_t* r, int32_t value);
+
+// value / 10^decimals con el número de decimales fijo (p.ej. 1234,2 -> "12.34")
+void resp_fixed(response_t* r, int32_t value, uint8_t decimals);
+
+// Atajos para los pares "a,b" habituales del protocolo
+void resp_int_pair(response_t* r, int32_t a, int32_t b);
+
+static inline const char* resp_cstr(const response_t* r) {
+	return r->buf;
+}
+
+#endif // RESPONSE_BUILDER_H
@@ -0,0 +1,196 @@
+#include "telemetry.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/system_clock.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/servo_driver.h"
+#include "../drivers/gripper_driver.h"
+#include "../drivers/position_trigger.h"
+#include "../limits/limit_switch.h"
+#include <string.h>
+
+static const char* const topic_names[TELEMETRY_TOPIC_COUNT] = {
+	"POS", "LIM", "SRV", "GRP", "QUE", "TIM"
+};
+
+static uint16_t topic_period_ms[TELEMETRY_TOPIC_COUNT];
+static uint32_t topic_last_us[TELEMETRY_TOPIC_COUNT];
+static uint8_t frame_seq = 0;
+static bool any_subscribed = false;
+
+// Trama preasignada: se construye y se envía sin copias intermedias
+static uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + 1];
+
+// Estadísticas del loop principal entre tramas TIMING
+static uint32_t loop_last_us = 0;
+static uint32_t loop_sum_us = 0;
+static uint16_t loop_max_us = 0;
+static uint32_t loop_count = 0;
+
+static uint8_t* put_u8(uint8_t* p, uint8_t v) {
+	*p++ = v;
+	return p;
+}
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v) {
+	*p++ = (uint8_t)v;
+	*p++ = (uint8_t)(v >> 8);
+	return p;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v) {
+	p = put_u16(p, (uint16_t)v);
+	return put_u16(p, (uint16_t)(v >> 16));
+}
+
+void telemetry_init(void) {
+	telemetry_unsubscribe_all();
+	frame_seq = 0;
+	loop_last_us = system_clock_micros();
+	loop_sum_us = 0;
+	loop_max_us = 0;
+	loop_count = 0;
+}
+
+uint16_t telemetry_subscribe(telemetry_topic_t topic, uint16_t period_ms) {
+	if (topic >= TELEMETRY_TOPIC_COUNT) return 0;
+	if (period_ms != 0 && period_ms < TELEMETRY_MIN_PERIOD_MS) {
+		period_ms = TELEMETRY_MIN_PERIOD_MS;
+	}
+	topic_period_ms[topic] = period_ms;
+	topic_last_us[topic] = system_clock_micros();
+	if (topic == TELEMETRY_TIMING) {
+		// Empezar la ventana de estadísticas con la suscripción
+		loop_sum_us = 0;
+		loop_max_us = 0;
+		loop_count = 0;
+	}
+	
+	any_subscribed = false;
+	for (uint8_t i = 0; i < TELEMETRY_TOPIC_COUNT; i++) {
+		if (topic_period_ms[i]) any_subscribed = true;
+	}
+	return period_ms;
+}
+
+uint16_t telemetry_get_period(telemetry_topic_t topic) {
+	return (topic < TELEMETRY_TOPIC_COUNT) ? topic_period_ms[topic] : 0;
+}
+
+void telemetry_unsubscribe_all(void) {
+	for (uint8_t i = 0; i < TELEMETRY_TOPIC_COUNT; i++) {
+		topic_period_ms[i] = 0;
+	}
+	any_subscribed = false;
+}
+
+telemetry_topic_t telemetry_topic_from_name(const char* name) {
+	for (uint8_t i = 0; i < TELEMETRY_TOPIC_COUNT; i++) {
+		if (strncmp(name, topic_names[i], 3) == 0) return (telemetry_topic_t)i;
+	}
+	return TELEMETRY_TOPIC_COUNT;
+}
+
+const char* telemetry_topic_name(telemetry_topic_t topic) {
+	return (topic < TELEMETRY_TOPIC_COUNT) ? topic_names[topic] : "?";
+}
+
+// Escribe el payload del tópico a partir de p; devuelve el puntero al final
+static uint8_t* build_payload(telemetry_topic_t topic, uint8_t* p) {
+	switch (topic) {
+		case TELEMETRY_POS: {
+			uint8_t flags = 0;
+			if (horizontal_axis.state != STEPPER_IDLE) flags |= 0x01;
+			if (vertical_axis.state != STEPPER_IDLE) flags |= 0x02;
+			if (stepper_is_jogging()) flags |= 0x04;
+			if (stepper_is_held()) flags |= 0x08;
+			int32_t h_pos, v_pos;
+			stepper_get_position(&h_pos, &v_pos);
+			p = put_u32(p, (uint32_t)h_pos);
+			p = put_u32(p, (uint32_t)v_pos);
+			p = put_u16(p, horizontal_axis.current_speed);
+			p = put_u16(p, vertical_axis.current_speed);
+			p = put_u8(p, flags);
+			break;
+		}
+		case TELEMETRY_LIMITS: {
+			limit_status_t limits = limit_switch_get_status();
+			uint8_t bitmap = 0;
+			if (limits.h_left_triggered) bitmap |= 0x01;
+			if (limits.h_right_triggered) bitmap |= 0x02;
+			if (limits.v_up_triggered) bitmap |= 0x04;
+			if (limits.v_down_triggered) bitmap |= 0x08;
+			p = put_u8(p, bitmap);
+			break;
+		}
+		case TELEMETRY_SERVO:
+			p = put_u8(p, servo_get_current_position(1));
+			p = put_u8(p, servo_get_current_position(2));
+			p = put_u8(p, servo_get_target_position(1));
+			p = put_u8(p, servo_get_target_position(2));
+			p = put_u8(p, servo_is_busy() ? 1 : 0);
+			break;
+		case TELEMETRY_GRIPPER:
+			p = put_u16(p, (uint16_t)gripper_get_position());
+			p = put_u8(p, (uint8_t)gripper_get_state());
+			break;
+		case TELEMETRY_QUEUE:
+			p = put_u8(p, position_trigger_pending());
+			p = put_u16(p, position_trigger_get_dropped());
+			break;
+		case TELEMETRY_TIMING:
+			p = put_u16(p, loop_max_us);
+			p = put_u16(p, loop_count ? (uint16_t)(loop_sum_us / loop_count) : 0);
+			p = put_u16(p, (loop_count > 0xFFFF) ? 0xFFFF : (uint16_t)loop_count);
+			loop_sum_us = 0;
+			loop_max_us = 0;
+			loop_count = 0;
+			break;
+		default:
+			break;
+	}
+	return p;
+}
+
+static void send_frame(telemetry_topic_t topic, uint32_t now_us) {
+	uint8_t* payload = frame + TELEMETRY_HEADER_SIZE;
+	uint8_t* end = build_payload(topic, payload);
+	uint8_t len = (uint8_t)(end - payload);
+	
+	frame[0] = TELEMETRY_SYNC;
+	frame[1] = (uint8_t)topic;
+	frame[2] = frame_seq++;
+	frame[3] = len;
+	put_u32(frame + 4, now_us);
+	
+	uint8_t checksum = 0;
+	for (uint8_t* p = frame + 1; p < end; p++) {
+		checksum ^= *p;
+	}
+	*end++ = checksum;
+	
+	for (uint8_t* p = frame; p < end; p++) {
+		uart_send_char((char)*p);
+	}
+}
+
+void telemetry_update(void) {
+	uint32_t now = system_clock_micros();
+	
+	// Duración de la vuelta anterior del loop principal
+	uint32_t loop_us = now - loop_last_us;
+	loop_last_us = now;
+	loop_sum_us += loop_us;
+	if (loop_us > loop_max_us) {
+		loop_max_us = (loop_us > 0xFFFF) ? 0xFFFF : (uint16_t)loop_us;
+	}
+	loop_count++;
+	
+	if (!any_subscribed) return;
+	
+	for (uint8_t i = 0; i < TELEMETRY_TOPIC_COUNT; i++) {
+		if (topic_period_ms[i] == 0) continue;
+		if (system_clock_elapsed(&topic_last_us[i], (uint32_t)topic_period_ms[i] * 1000UL)) {
+			send_frame((telemetry_topic_t)i, now);
+		}
+	}
+}
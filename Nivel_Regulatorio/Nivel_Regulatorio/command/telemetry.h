@@ -0,0 +1,44 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Telemetría binaria por suscripción. Cada tópico se emite con su propio
+// periodo como una trama de layout fijo (little-endian):
+//
+//   [0xA5][topic][seq][len][t_us:4][payload:len][checksum]
+//
+// checksum = XOR de topic..último byte de payload. El byte de sincronía no es
+// ASCII, así que el supervisor distingue las tramas de las líneas de texto.
+
+#define TELEMETRY_SYNC          0xA5
+#define TELEMETRY_HEADER_SIZE   8
+#define TELEMETRY_MAX_PAYLOAD   16
+#define TELEMETRY_MIN_PERIOD_MS 5       // Un tick de control
+
+typedef enum {
+	TELEMETRY_POS = 0,      // h:i32 v:i32 vh:u16 vv:u16 flags:u8 (bit0 H mov, bit1 V mov, bit2 jog, bit3 hold)
+	TELEMETRY_LIMITS,       // bitmap:u8 (bit0 H_LEFT, bit1 H_RIGHT, bit2 V_UP, bit3 V_DOWN)
+	TELEMETRY_SERVO,        // pos1:u8 pos2:u8 target1:u8 target2:u8 moving:u8
+	TELEMETRY_GRIPPER,      // steps:i16 state:u8
+	TELEMETRY_QUEUE,        // trigger_pending:u8 trigger_dropped:u16
+	TELEMETRY_TIMING,       // loop_max_us:u16 loop_avg_us:u16 loops:u16 (desde la trama anterior)
+	TELEMETRY_TOPIC_COUNT
+} telemetry_topic_t;
+
+void telemetry_init(void);
+
+// Periodo en ms (0 = desuscribir). Devuelve el periodo aplicado
+uint16_t telemetry_subscribe(telemetry_topic_t topic, uint16_t period_ms);
+uint16_t telemetry_get_period(telemetry_topic_t topic);
+void telemetry_unsubscribe_all(void);
+
+// Tópico por nombre corto (POS, LIM, SRV, GRP, QUE, TIM); TELEMETRY_TOPIC_COUNT si no existe
+telemetry_topic_t telemetry_topic_from_name(const char* name);
+const char* telemetry_topic_name(telemetry_topic_t topic);
+
+// Llamar en cada vuelta del loop principal: mide el loop y emite lo que toque
+void telemetry_update(void);
+
+#endif // TELEMETRY_H
@@ -13,5 +13,16 @@
 
 // Buffer para comunicacion
 #define UART_BUFFER_SIZE    128
+#define UART_FRAME_SLOTS    4       // Frames completos en espera de ejecucin (potencia de 2)
+#define UART_TX_DEFER_SIZE  192     // Salida retenida mientras arranca un batch
+
+// Parada rpida: byte suelto (fuera o dentro de un frame) atendido en la
+// ISR de recepcin. Corta los pasos al instante y descarta los frames en
+// espera; el reporte sale despus desde el loop principal (OK:STOP)
+#define UART_ESTOP_BYTE     0x18    // CAN (Ctrl-X), nunca aparece en un frame ASCII
+
+// G-code: lneas sueltas terminadas en '\n' (sin '<' '>'), respuesta "ok" al
+// encolar cada bloque; el host enva la siguiente al recibirla
+#define GCODE_QUEUE_SIZE    8       // Bloques en espera de ejecucin
 
 #endif
\ No newline at end of file
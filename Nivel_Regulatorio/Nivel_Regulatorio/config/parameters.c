@@ -0,0 +1,171 @@
+#include "parameters.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/step_queue.h"
+#include "../moves/units.h"
+#include "../moves/motion_preset.h"
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+
+#define PARAM_NAME_SIZE     14
+
+typedef struct {
+	char name[PARAM_NAME_SIZE];
+	uint16_t min;
+	uint16_t max;
+	uint16_t def;
+	uint8_t idle_only;      // Cambia la escala pasos <-> mm
+} param_def_t;
+
+// Mismo orden que param_id_t. PWM_MIN y PWM_MAX no se solapan: el rango del
+// servo nunca queda invertido
+static const param_def_t param_table[PARAM_COUNT] PROGMEM = {
+	{ "MICROSTEPS",    1,          32,            MICROSTEPS,             1 },
+	{ "MM_REV_H",      100,        20000,         MM_PER_REV_BELT_CENTI,  1 },
+	{ "MM_REV_V",      100,        20000,         MM_PER_REV_SCREW_CENTI, 1 },
+	{ "MAX_SPEED_H",   MIN_SPEED,  MAX_STEP_RATE, MAX_SPEED_H,            0 },
+	{ "MAX_SPEED_V",   MIN_SPEED,  MAX_STEP_RATE, MAX_SPEED_V,            0 },
+	{ "ACCEL_H",       100,        60000,         ACCEL_H,                0 },
+	{ "ACCEL_V",       100,        60000,         ACCEL_V,                0 },
+	{ "DEBOUNCE",      1,          50,            LIMIT_DEBOUNCE_TICKS,   0 },
+	{ "SERVO_PWM_MIN", 1000,       2999,          SERVO_PWM_MIN,          0 },
+	{ "SERVO_PWM_MAX", 3001,       5000,          SERVO_PWM_MAX,          0 },
+	{ "GRIPPER_CLOSE", 100,        4000,          GRIPPER_STEPS_TO_CLOSE, 0 },
+};
+
+// Bloque en EEPROM: magic, cantidad, valores (little-endian) y suma de control
+typedef struct {
+	uint8_t magic;
+	uint8_t count;
+	uint16_t values[PARAM_COUNT];
+	uint8_t checksum;
+} param_block_t;
+
+uint16_t param_values[PARAM_COUNT];
+
+static uint8_t block_checksum(const param_block_t* block) {
+	const uint8_t* p = (const uint8_t*)block->values;
+	uint8_t sum = block->count;
+	for (uint8_t i = 0; i < sizeof(block->values); i++) {
+		sum += p[i];
+	}
+	return (uint8_t)~sum;
+}
+
+static bool motion_active(void) {
+	return stepper_is_moving() || step_queue_is_active();
+}
+
+// Llevar el valor a los módulos que no leen param_values en cada uso
+static void apply(param_id_t id) {
+	switch (id) {
+		case PARAM_MICROSTEPS:
+		case PARAM_MM_REV_H:
+		case PARAM_MM_REV_V:
+			units_init();
+			break;
+		case PARAM_MAX_SPEED_H:
+		case PARAM_MAX_SPEED_V:
+		case PARAM_ACCEL_H:
+		case PARAM_ACCEL_V:
+			// El preset activo se acota a los nuevos máximos
+			motion_preset_apply();
+			break;
+		default: break;
+	}
+}
+
+static void apply_all(void) {
+	for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+		apply((param_id_t)i);
+	}
+}
+
+static void set_defaults(void) {
+	for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+		param_values[i] = pgm_read_word(&param_table[i].def);
+	}
+}
+
+// Copia el bloque de EEPROM a RAM solo si está completo y todo en rango
+static bool read_block(void) {
+	param_block_t block;
+	eeprom_read_block(&block, (const void*)PARAM_EEPROM_BASE, sizeof(block));
+	if (block.magic != PARAM_EEPROM_MAGIC || block.count != PARAM_COUNT) return false;
+	if (block.checksum != block_checksum(&block)) return false;
+
+	for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+		if (block.values[i] < param_min((param_id_t)i) || block.values[i] > param_max((param_id_t)i)) return false;
+	}
+	memcpy(param_values, block.values, sizeof(param_values));
+	return true;
+}
+
+void param_init(void) {
+	// Sin aplicar: los drivers toman los valores en su propio init
+	set_defaults();
+	read_block();
+}
+
+param_result_t param_set(param_id_t id, uint16_t value) {
+	if (id >= PARAM_COUNT) return PARAM_UNKNOWN;
+	if (value < param_min(id) || value > param_max(id)) return PARAM_RANGE;
+	if (pgm_read_byte(&param_table[id].idle_only) && motion_active()) return PARAM_BUSY;
+
+	param_values[id] = value;
+	apply(id);
+	return PARAM_OK;
+}
+
+param_id_t param_find(const char* name, uint8_t len) {
+	if (len >= PARAM_NAME_SIZE) return PARAM_COUNT;
+	for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+		const char* entry = param_table[i].name;
+		if (strncmp_P(name, entry, len) == 0 && pgm_read_byte(&entry[len]) == '\0') {
+			return (param_id_t)i;
+		}
+	}
+	return PARAM_COUNT;
+}
+
+const char* param_name(param_id_t id) {
+	return param_table[id].name;
+}
+
+uint16_t param_min(param_id_t id) {
+	return pgm_read_word(&param_table[id].min);
+}
+
+uint16_t param_max(param_id_t id) {
+	return pgm_read_word(&param_table[id].max);
+}
+
+uint16_t param_default(param_id_t id) {
+	return pgm_read_word(&param_table[id].def);
+}
+
+bool param_save(void) {
+	if (motion_active()) return false;
+
+	param_block_t block;
+	block.magic = PARAM_EEPROM_MAGIC;
+	block.count = PARAM_COUNT;
+	memcpy(block.values, param_values, sizeof(block.values));
+	block.checksum = block_checksum(&block);
+	eeprom_update_block(&block, (void*)PARAM_EEPROM_BASE, sizeof(block));
+	return true;
+}
+
+param_result_t param_load(void) {
+	if (motion_active()) return PARAM_BUSY;
+	if (!read_block()) return PARAM_EMPTY;
+	apply_all();
+	return PARAM_OK;
+}
+
+param_result_t param_load_defaults(void) {
+	if (motion_active()) return PARAM_BUSY;
+	set_defaults();
+	apply_all();
+	return PARAM_OK;
+}
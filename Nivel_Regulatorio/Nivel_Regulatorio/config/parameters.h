@@ -0,0 +1,68 @@
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "system_config.h"
+
+// Parámetros de ajuste por máquina que antes eran #define. La tabla (flash)
+// guarda nombre, rango y valor por defecto; los valores viven en RAM y los
+// módulos los leen directamente con param_get. Se cargan de EEPROM al
+// arrancar (PARAM_EEPROM_BASE) si el bloque guardado es válido.
+//
+// Los pasos/mm se ajustan con MICROSTEPS y los mm por vuelta de cada eje
+// (centésimas), que es como units.c calcula la razón entera.
+
+typedef enum {
+	PARAM_MICROSTEPS = 0,   // Micropasos del driver (TB6600)
+	PARAM_MM_REV_H,         // Centésimas de mm por vuelta (correa)
+	PARAM_MM_REV_V,         // Centésimas de mm por vuelta (varilla)
+	PARAM_MAX_SPEED_H,      // pasos/s
+	PARAM_MAX_SPEED_V,
+	PARAM_ACCEL_H,          // pasos/s²
+	PARAM_ACCEL_V,
+	PARAM_DEBOUNCE,         // Lecturas iguales (ticks de 5ms) para aceptar un fin de carrera
+	PARAM_SERVO_PWM_MIN,    // Counts de Timer5 para 0°
+	PARAM_SERVO_PWM_MAX,    // Counts de Timer5 para 180°
+	PARAM_GRIPPER_CLOSE,    // Pasos de abierto a cerrado
+	PARAM_COUNT
+} param_id_t;
+
+typedef enum {
+	PARAM_OK = 0,
+	PARAM_UNKNOWN,          // Nombre inexistente
+	PARAM_RANGE,            // Valor fuera de [min, max]
+	PARAM_BUSY,             // Cambia la escala de pasos: solo con los ejes quietos
+	PARAM_EMPTY             // La EEPROM no tiene un bloque válido
+} param_result_t;
+
+extern uint16_t param_values[PARAM_COUNT];
+
+static inline uint16_t param_get(param_id_t id) {
+	return param_values[id];
+}
+
+// Defaults y luego EEPROM si el bloque es válido (antes de los drivers)
+void param_init(void);
+
+param_result_t param_set(param_id_t id, uint16_t value);
+
+// PARAM_COUNT si el nombre no existe
+param_id_t param_find(const char* name, uint8_t len);
+
+// Nombre (flash), mínimo, máximo y valor por defecto
+const char* param_name(param_id_t id);
+uint16_t param_min(param_id_t id);
+uint16_t param_max(param_id_t id);
+uint16_t param_default(param_id_t id);
+
+// Guardar el bloque completo (solo escribe los bytes que cambian); false
+// durante un movimiento, como las macros en EEPROM
+bool param_save(void);
+
+// Recargar de EEPROM o volver a los defaults. Si no hay bloque válido
+// (PARAM_EMPTY) los valores en RAM no cambian
+param_result_t param_load(void);
+param_result_t param_load_defaults(void);
+
+#endif // PARAMETERS_H
@@ -13,21 +13,77 @@
 #define MICROSTEPS          8       // Configuración TB6600
 #define STEPS_PER_REV_TOTAL (STEPS_PER_REV_NEMA * MICROSTEPS)
 
-// Relaciones mecánicas
-#define MM_PER_REV_BELT     40.0    // mm por revolución en correa
-#define MM_PER_REV_SCREW    8.0     // mm por revolución varilla roscada
-#define STEPS_PER_MM_H      (STEPS_PER_REV_TOTAL / MM_PER_REV_BELT)
-#define STEPS_PER_MM_V      (STEPS_PER_REV_TOTAL / MM_PER_REV_SCREW)
+// Relaciones mecánicas en centésimas de mm (enteras: sin float en las
+// conversiones, ver moves/units.h)
+#define MM_PER_REV_BELT_CENTI   4000    // 40.00 mm por revolución en correa
+#define MM_PER_REV_SCREW_CENTI  800     // 8.00 mm por revolución varilla roscada
+#define STEPS_PER_MM_H      (STEPS_PER_REV_TOTAL * 100L / MM_PER_REV_BELT_CENTI)
+#define STEPS_PER_MM_V      (STEPS_PER_REV_TOTAL * 100L / MM_PER_REV_SCREW_CENTI)
 
 // Velocidades máximas (pasos/segundo)
 #define MAX_SPEED_H         10000
 #define MAX_SPEED_V         15000
 #define MIN_SPEED           500
+#define MAX_STEP_RATE       20000   // Tope absoluto de pasos/segundo (incluye override)
+
+// Override de avance (% de la velocidad configurada)
+#define FEED_OVERRIDE_MIN   10
+#define FEED_OVERRIDE_MAX   200
+
+// Modo jog (velocidad continua)
+#define JOG_MAX_TRAVEL_STEPS    2000000L    // Recorrido "infinito" si no hay límites de software
+#define JOG_REPORT_PERIOD_TICKS 20          // Reporte de posición cada 20 ticks de 5ms = 100ms
+
+// Lazo de corrección guiado por visión (ganancias en centésimas)
+#define CORRECTION_DEFAULT_KP        400    // 4.0 1/s
+#define CORRECTION_DEFAULT_KI        50     // 0.5 1/s²
+#define CORRECTION_DEFAULT_MAX_SPEED 3000   // pasos/s
+#define CORRECTION_MIN_SPEED         100    // pasos/s fuera de la banda muerta
+#define CORRECTION_DEADBAND_STEPS    4
+#define CORRECTION_TIMEOUT_MS        1000   // Sin errores nuevos en este tiempo: frenar
 
 // Aceleraciones (pasos/segundo²)
 #define ACCEL_H             7500
 #define ACCEL_V             9000
 
+// Fines de carrera
+#define LIMIT_DEBOUNCE_TICKS    6       // Lecturas seguidas (tick de 5ms) para aceptar un cambio
+
+// ========== PARÁMETROS EN EEPROM (PG/PS) ==========
+// Los valores de esta sección y de las de motores, servos y gripper marcados
+// en config/parameters.c son solo los defaults: rigen los guardados con PW
+#define PARAM_EEPROM_BASE       0x10    // Después de servo/gripper (0x00-0x06)
+#define PARAM_EEPROM_MAGIC      0xC5
+
+// ========== PRESETS DE MOVIMIENTO (MP) ==========
+// Vacío: velocidades y aceleraciones de los parámetros (0 = la del parámetro)
+// y servo sin límite. Con carga: más suave para no soltar ni dañar la lechuga
+#define PRESET_LOADED_SPEED_H       6000    // pasos/s
+#define PRESET_LOADED_SPEED_V       9000
+#define PRESET_LOADED_ACCEL_H       3000    // pasos/s²
+#define PRESET_LOADED_ACCEL_V       4000
+#define PRESET_LOADED_SERVO_MS_DEG  10      // Mínimo 10ms por grado de recorrido
+#define PRESET_EMPTY_GRIPPER_MS     3       // ms entre medios pasos del gripper
+#define PRESET_LOADED_GRIPPER_MS    5
+
+// ========== MACROS ==========
+#define MACRO_SLOT_SIZE         96      // Bytes por programa (destinos de salto en 8 bits)
+#define MACRO_RAM_SLOTS         2       // Slots 0-1: se pierden al reiniciar
+#define MACRO_EEPROM_SLOTS      4       // Slots 2-5: persistentes
+#define MACRO_EEPROM_BASE       0x100   // Después de servo/gripper (0x00-0x06)
+#define MACRO_COUNTERS          4       // Contadores de SET/LOOP
+#define MACRO_STEPS_PER_UPDATE  8       // Instrucciones sin espera por pasada del loop
+#define MACRO_WAIT_TIMEOUT_MS   30000   // WAIT sin terminar: se aborta el programa
+
+// ========== COLA DE PASOS (QA/QG) ==========
+#define STEP_QUEUE_SIZE             16      // Segmentos por eje (potencia de 2)
+#define STEP_QUEUE_MAX_PER_FRAME    8       // Segmentos en un frame QA
+#define STEP_QUEUE_MIN_INTERVAL_US  (1000000UL / MAX_STEP_RATE)
+#define STEP_QUEUE_MAX_INTERVAL_US  32767   // Dos intervalos en 16 bits de timer (0.5us)
+#define STEP_QUEUE_PULSE_TICKS      40      // Ancho del pulso STEP: 20us
+#define STEP_QUEUE_START_WINDOW_US  20000   // Antelación con que se programa el arranque
+#define STEP_QUEUE_MAX_LEAD_US      10000000UL  // QG más lejos que esto se rechaza
+
 // ========== PARÁMETROS SERVOS ==========
 // Posiciones iniciales por defecto
 #define SERVO1_DEFAULT_POS  90      // Posición inicial servo 1
@@ -3,9 +3,15 @@
 #include <util/delay.h>
 #include <avr/eeprom.h>
 #include "../config/system_config.h"
+#include "../config/parameters.h"
+#include "system_clock.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../command/command_seq.h"
+#include <avr/pgmspace.h>
 
 // Secuencia de 8 medios pasos (igual que Arduino)
-static const uint8_t step_sequence[8][4] = {
+static const uint8_t step_sequence[8][4] PROGMEM = {
 	{1, 0, 0, 0},
 	{1, 1, 0, 0},
 	{0, 1, 0, 0},
@@ -19,14 +25,15 @@ static const uint8_t step_sequence[8][4] = {
 // Variable global del controlador
 static gripper_controller_t gripper = {0};
 
+// Recorrido completo (parmetro GRIPPER_CLOSE); con signo como current_steps
+static inline int16_t close_steps(void) {
+	return (int16_t)param_get(PARAM_GRIPPER_CLOSE);
+}
+
 // Variables para control no bloqueante
 static volatile uint16_t steps_to_do = 0;
 static volatile int8_t step_direction = 0;  // 1=forward, -1=backward, 0=stop
 
-// Contador simple para timing del gripper
-static volatile uint16_t gripper_tick_counter = 0;
-static uint16_t ticks_per_step = 200;  // Valor intermedio - ni muy rpido ni muy lento
-
 // Direcciones EEPROM para gripper (continuar despus de las del servo)
 #define EEPROM_GRIPPER_STATE    0x03
 #define EEPROM_GRIPPER_STEPS    0x04  // Para guardar posicin exacta (2 bytes)
@@ -35,26 +42,29 @@ static uint16_t ticks_per_step = 200;  // Valor intermedio - ni muy r
 
 // Funcin para aplicar el patrn actual a los pines
 static void apply_pattern(uint8_t pattern_index) {
+	uint8_t coils[4];
+	memcpy_P(coils, step_sequence[pattern_index], sizeof(coils));
+	
 	// Aplicar directamente a los bits correctos de PORTC
-	if (step_sequence[pattern_index][0]) {
+	if (coils[0]) {
 		PORTC |= (1 << 3);   // IN1 - PC3 (Pin 34)
 		} else {
 		PORTC &= ~(1 << 3);
 	}
 	
-	if (step_sequence[pattern_index][1]) {
+	if (coils[1]) {
 		PORTC |= (1 << 2);   // IN2 - PC2 (Pin 35)
 		} else {
 		PORTC &= ~(1 << 2);
 	}
 	
-	if (step_sequence[pattern_index][2]) {
+	if (coils[2]) {
 		PORTC |= (1 << 1);   // IN3 - PC1 (Pin 36)
 		} else {
 		PORTC &= ~(1 << 1);
 	}
 	
-	if (step_sequence[pattern_index][3]) {
+	if (coils[3]) {
 		PORTC |= (1 << 0);   // IN4 - PC0 (Pin 37)
 		} else {
 		PORTC &= ~(1 << 0);
@@ -79,20 +89,20 @@ void gripper_init(void) {
 	
 	steps_to_do = 0;
 	step_direction = 0;
-	gripper_tick_counter = 0;
-	ticks_per_step = 200;
 	
 	gripper_load_state();
 	
 	if (gripper.state == GRIPPER_OPENING || gripper.state == GRIPPER_CLOSING) {
-		gripper.state = (gripper.current_steps < GRIPPER_STEPS_TO_CLOSE / 2) ?
+		gripper.state = (gripper.current_steps < close_steps() / 2) ?
 		GRIPPER_OPEN : GRIPPER_CLOSED;
 	}
 	
 	steps_to_do = 0;
 	step_direction = 0;
 	
-	uart_send_gripper_status();
+	if (event_log_enabled(LOG_CAT_GRIPPER, LOG_DEBUG)) {
+		uart_send_gripper_status();
+	}
 	
 	gripper.state = GRIPPER_OPEN;  // TEMPORAL
 	gripper.current_steps = 0;     // TEMPORAL
@@ -101,55 +111,84 @@ void gripper_init(void) {
 	gripper_load_state();
 	    
 	// ? DEBUG: Ver qu se carg
-	char debug_msg[128];
-	snprintf(debug_msg, sizeof(debug_msg),
-	"GRIPPER_INIT:state=%d,steps=%d,target_steps=%d",
-	gripper.state, gripper.current_steps, GRIPPER_STEPS_TO_CLOSE);
-	uart_send_response(debug_msg);
+	if (event_log_enabled(LOG_CAT_GRIPPER, LOG_DEBUG)) {
+		char debug_msg[64];
+		response_t r;
+		resp_init(&r, debug_msg, sizeof(debug_msg));
+		resp_msg(&r, MSG_GRIPPER_INIT);
+		resp_str_P(&r, PSTR(":state="));
+		resp_uint(&r, gripper.state);
+		resp_str_P(&r, PSTR(",steps="));
+		resp_int(&r, gripper.current_steps);
+		resp_str_P(&r, PSTR(",target_steps="));
+		resp_int(&r, close_steps());
+		uart_send_response(debug_msg);
+	}
 	    
 	// Resetear variables globales
 	steps_to_do = 0;
 	step_direction = 0;
-	gripper_tick_counter = 0;
-	ticks_per_step = 200;
 }
 	
-void uart_send_gripper_status(void) {
-	const char* state_str;
-	switch(gripper.state) {
-		case GRIPPER_OPEN: state_str = "OPEN"; break;
-		case GRIPPER_CLOSED: state_str = "CLOSED"; break;
-		case GRIPPER_OPENING: state_str = "OPENING"; break;
-		case GRIPPER_CLOSING: state_str = "CLOSING"; break;
-		default: state_str = "IDLE"; break;
+const char* gripper_state_name(gripper_state_t state) {
+	switch(state) {
+		case GRIPPER_OPEN: return PSTR("OPEN");
+		case GRIPPER_CLOSED: return PSTR("CLOSED");
+		case GRIPPER_OPENING: return PSTR("OPENING");
+		case GRIPPER_CLOSING: return PSTR("CLOSING");
+		default: return PSTR("IDLE");
 	}
-	
-	char msg[64];
-	snprintf(msg, sizeof(msg), "GRIPPER_STATUS:%s,%d", state_str, gripper.current_steps);
+}
+
+// "<mensaje>:<estado>" para los eventos de accin
+static void send_action_event(msg_id_t id, gripper_state_t state) {
+	if (!event_log_enabled(LOG_CAT_GRIPPER, LOG_EVENT)) return;
+	
+	char msg[40];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	if (id == MSG_GRIPPER_ACTION_COMPLETED) {
+		resp_seq_take(&r, SEQ_GRIPPER);
+	}
+	resp_msg(&r, id);
+	resp_char(&r, ':');
+	resp_str_P(&r, gripper_state_name(state));
+	uart_send_event(msg);
+}
+
+void uart_send_gripper_status(void) {
+	char msg[40];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, MSG_GRIPPER_STATUS);
+	resp_char(&r, ':');
+	resp_str_P(&r, gripper_state_name(gripper.state));
+	resp_char(&r, ',');
+	resp_int(&r, gripper.current_steps);
 	uart_send_response(msg);
 }
 
 void gripper_open(void) {
 	if (gripper.state == GRIPPER_OPEN) {
-		uart_send_response("GRIPPER_ALREADY_OPEN");
+		message_send(MSG_GRIPPER_ALREADY_OPEN);
 		return;
 	}
 	
 	steps_to_do = 0;
 	step_direction = 0;
 	
-	steps_to_do = GRIPPER_STEPS_TO_CLOSE - gripper.current_steps;
+	steps_to_do = close_steps() - gripper.current_steps;
 	step_direction = 1;
 	gripper.state = GRIPPER_OPENING;
 	gripper.target_state = GRIPPER_OPEN;
-	gripper_tick_counter = 0;
+	gripper.last_step_time = system_clock_micros();
 	
-	uart_send_response("GRIPPER_ACTION_STARTED:OPENING");
+	send_action_event(MSG_GRIPPER_ACTION_STARTED, GRIPPER_OPENING);
 }
 
 void gripper_close(void) {
 	if (gripper.state == GRIPPER_CLOSED) {
-		uart_send_response("GRIPPER_ALREADY_CLOSED");
+		message_send(MSG_GRIPPER_ALREADY_CLOSED);
 		return;
 	}
 	
@@ -160,32 +199,32 @@ void gripper_close(void) {
 	step_direction = -1;
 	gripper.state = GRIPPER_CLOSING;
 	gripper.target_state = GRIPPER_CLOSED;
-	gripper_tick_counter = 0;
+	gripper.last_step_time = system_clock_micros();
 	
-	uart_send_response("GRIPPER_ACTION_STARTED:CLOSING");
+	send_action_event(MSG_GRIPPER_ACTION_STARTED, GRIPPER_CLOSING);
 }
 
 void gripper_toggle(void) {
 	if (gripper.state == GRIPPER_OPENING || gripper.state == GRIPPER_CLOSING) {
-		uart_send_response("GRIPPER_BUSY");
+		message_send(MSG_GRIPPER_BUSY);
 		return;
 	}
 	
-	if (gripper.state == GRIPPER_CLOSED || gripper.current_steps < GRIPPER_STEPS_TO_CLOSE / 2) {
-		steps_to_do = GRIPPER_STEPS_TO_CLOSE - gripper.current_steps;
+	if (gripper.state == GRIPPER_CLOSED || gripper.current_steps < close_steps() / 2) {
+		steps_to_do = close_steps() - gripper.current_steps;
 		step_direction = 1;
 		gripper.state = GRIPPER_OPENING;
 		gripper.target_state = GRIPPER_OPEN;
-		uart_send_response("GRIPPER_ACTION_STARTED:OPENING");
+		send_action_event(MSG_GRIPPER_ACTION_STARTED, GRIPPER_OPENING);
 		} else {
 		steps_to_do = gripper.current_steps;
 		step_direction = -1;
 		gripper.state = GRIPPER_CLOSING;
 		gripper.target_state = GRIPPER_CLOSED;
-		uart_send_response("GRIPPER_ACTION_STARTED:CLOSING");
+		send_action_event(MSG_GRIPPER_ACTION_STARTED, GRIPPER_CLOSING);
 	}
 	
-	gripper_tick_counter = 0;
+	gripper.last_step_time = system_clock_micros();
 }
 
 void gripper_update(void) {
@@ -195,24 +234,18 @@ void gripper_update(void) {
 			gripper.state = gripper.target_state;
 			gripper_save_state();
 			
-			if (gripper.state == GRIPPER_OPEN) {
-				uart_send_response("GRIPPER_ACTION_COMPLETED:OPEN");
-				} else if (gripper.state == GRIPPER_CLOSED) {
-				uart_send_response("GRIPPER_ACTION_COMPLETED:CLOSED");
+			if (gripper.state == GRIPPER_OPEN || gripper.state == GRIPPER_CLOSED) {
+				send_action_event(MSG_GRIPPER_ACTION_COMPLETED, gripper.state);
 			}
 		}
 		return;
 	}
 	
-	gripper_tick_counter++;
-	
-	if (gripper_tick_counter < ticks_per_step) {
-		apply_pattern(gripper.phase_index);
+	// Paso siguiente programado contra el reloj del sistema
+	if (!system_clock_elapsed(&gripper.last_step_time, gripper.step_delay_us)) {
 		return;
 	}
 	
-	gripper_tick_counter = 0;
-	
 	if (step_direction > 0) {
 		gripper.phase_index = (gripper.phase_index + 1) % 8;
 		gripper.current_steps++;
@@ -226,14 +259,10 @@ void gripper_update(void) {
 	}
 	
 	if (gripper.current_steps < 0) gripper.current_steps = 0;
-	if (gripper.current_steps > GRIPPER_STEPS_TO_CLOSE) gripper.current_steps = GRIPPER_STEPS_TO_CLOSE;
+	if (gripper.current_steps > close_steps()) gripper.current_steps = close_steps();
 	
 	apply_pattern(gripper.phase_index);
 	
-	for(volatile uint16_t i = 0; i < 1000; i++) {
-		__asm__ __volatile__ ("nop");
-	}
-	
 	steps_to_do--;
 	
 	if (steps_to_do == 0) {
@@ -242,10 +271,8 @@ void gripper_update(void) {
 		gripper.state = gripper.target_state;
 		gripper_save_state();
 		
-		if (gripper.state == GRIPPER_OPEN) {
-			uart_send_response("GRIPPER_ACTION_COMPLETED:OPEN");
-			} else if (gripper.state == GRIPPER_CLOSED) {
-			uart_send_response("GRIPPER_ACTION_COMPLETED:CLOSED");
+		if (gripper.state == GRIPPER_OPEN || gripper.state == GRIPPER_CLOSED) {
+			send_action_event(MSG_GRIPPER_ACTION_COMPLETED, gripper.state);
 		}
 	}
 }
@@ -256,7 +283,7 @@ void gripper_stop(void) {
 	step_direction = 0;
 	
 	// Determinar estado actual basado en posicin
-	if (gripper.current_steps < GRIPPER_STEPS_TO_CLOSE / 2) {
+	if (gripper.current_steps < close_steps() / 2) {
 		gripper.state = GRIPPER_OPEN;
 		} else {
 		gripper.state = GRIPPER_CLOSED;
@@ -276,12 +303,11 @@ int16_t gripper_get_position(void) {
 }
 
 void gripper_set_speed(uint16_t delay_ms) {
-	// Ajustar ticks_per_step basado en el delay deseado
+	// Periodo entre medios pasos, limitado al rango que el 28BYJ-48 sigue sin perder pasos
 	if (delay_ms < 2) delay_ms = 2;
 	if (delay_ms > 10) delay_ms = 10;
 	
-	// Para 3ms de delay, queremos ~200 ticks
-	ticks_per_step = delay_ms * 67;  // ~200 para 3ms
+	gripper.step_delay_us = delay_ms * 1000;
 }
 
 static void gripper_save_state(void) {
@@ -298,12 +324,19 @@ static void gripper_load_state(void) {
 		uint16_t saved_steps = eeprom_read_word((uint16_t*)EEPROM_GRIPPER_STEPS);
 		
 		// ? DEBUG
-		char debug_msg[64];
-		snprintf(debug_msg, sizeof(debug_msg),
-		"EEPROM_LOAD:state=%d,steps=%d", saved_state, saved_steps);
-		uart_send_response(debug_msg);
+		if (event_log_enabled(LOG_CAT_GRIPPER, LOG_DEBUG)) {
+			char debug_msg[40];
+			response_t r;
+			resp_init(&r, debug_msg, sizeof(debug_msg));
+			resp_msg(&r, MSG_EEPROM_LOAD);
+			resp_str_P(&r, PSTR(":state="));
+			resp_uint(&r, saved_state);
+			resp_str_P(&r, PSTR(",steps="));
+			resp_uint(&r, saved_steps);
+			uart_send_response(debug_msg);
+		}
 		
-		if (saved_steps <= GRIPPER_STEPS_TO_CLOSE) {
+		if (saved_steps <= close_steps()) {
 			gripper.current_steps = saved_steps;
 			gripper.state = (gripper_state_t)saved_state;
 			gripper.target_state = gripper.state;
@@ -312,9 +345,17 @@ static void gripper_load_state(void) {
 		// Primera vez - estado inicial cerrado
 		gripper.state = GRIPPER_CLOSED;
 		gripper.target_state = GRIPPER_CLOSED;
-		gripper.current_steps = GRIPPER_STEPS_TO_CLOSE;
+		gripper.current_steps = close_steps();
 		gripper_save_state();
 		
-		uart_send_response("EEPROM_FIRST_TIME:CLOSED");
+		if (event_log_enabled(LOG_CAT_GRIPPER, LOG_DEBUG)) {
+			char debug_msg[32];
+			response_t r;
+			resp_init(&r, debug_msg, sizeof(debug_msg));
+			resp_msg(&r, MSG_EEPROM_FIRST_TIME);
+			resp_char(&r, ':');
+			resp_str_P(&r, gripper_state_name(GRIPPER_CLOSED));
+			uart_send_response(debug_msg);
+		}
 	}
 }
\ No newline at end of file
@@ -43,6 +43,7 @@ int16_t gripper_get_position(void);         // Funci
 static void gripper_save_state(void);
 static void gripper_load_state(void);
 void uart_send_gripper_status(void);
+const char* gripper_state_name(gripper_state_t state);   // Texto en flash (PSTR)
 void gripper_toggle(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "position_trigger.h"
+#include "uart_driver.h"
+#include "system_clock.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+// Lista de posiciones de un eje, ordenada de menor a mayor
+typedef struct {
+	int32_t points[TRIGGER_MAX_POINTS];
+	uint8_t count;
+	int8_t next_index;        // Próximo punto a cruzar (-1 = ninguno)
+	int8_t step;              // +1 sentido positivo, -1 sentido negativo
+	uint8_t fired;            // Puntos disparados en el movimiento actual
+} trigger_list_t;
+
+// Evento de cruce pendiente de enviar
+typedef struct {
+	uint32_t timestamp_us;
+	int32_t position;
+	uint8_t axis;
+	uint8_t index;
+} trigger_event_t;
+
+volatile bool trigger_h_armed = false;
+volatile bool trigger_v_armed = false;
+volatile int32_t trigger_h_next = 0;
+volatile int32_t trigger_v_next = 0;
+
+static trigger_list_t lists[2];
+static uint8_t trigger_mode = TRIGGER_MODE_PIN | TRIGGER_MODE_EVENT;
+
+static trigger_event_t event_queue[TRIGGER_EVENT_QUEUE];
+static volatile uint8_t event_head = 0;
+static volatile uint8_t event_tail = 0;
+static volatile uint16_t events_dropped = 0;
+
+void position_trigger_init(void) {
+	// Salida de disparo en LOW
+	DDRH |= (1 << 5);
+	PORTH &= ~(1 << 5);
+	
+	position_trigger_clear();
+}
+
+static void load_next(trigger_axis_t axis) {
+	trigger_list_t* list = &lists[axis];
+	bool armed = (list->next_index >= 0 && list->next_index < (int8_t)list->count);
+	int32_t next = armed ? list->points[list->next_index] : 0;
+	
+	if (axis == TRIGGER_AXIS_H) {
+		trigger_h_next = next;
+		trigger_h_armed = armed;
+		} else {
+		trigger_v_next = next;
+		trigger_v_armed = armed;
+	}
+}
+
+bool position_trigger_add(trigger_axis_t axis, int32_t position) {
+	trigger_list_t* list = &lists[axis];
+	
+	// Inserción ordenada (listas pequeñas). Un punto repetido se une al
+	// existente: la ISR solo compara igualdad y avanza, así que el segundo
+	// nunca se alcanzaría y detendría el resto de la lista
+	uint8_t i = list->count;
+	while (i > 0 && list->points[i - 1] >= position) {
+		if (list->points[i - 1] == position) return true;
+		i--;
+	}
+	if (list->count >= TRIGGER_MAX_POINTS) return false;
+	
+	for (uint8_t j = list->count; j > i; j--) {
+		list->points[j] = list->points[j - 1];
+	}
+	list->points[i] = position;
+	list->count++;
+	return true;
+}
+
+void position_trigger_clear(void) {
+	uint8_t sreg = SREG;
+	cli();
+	for (uint8_t a = 0; a < 2; a++) {
+		lists[a].count = 0;
+		lists[a].next_index = -1;
+		lists[a].step = 1;
+		lists[a].fired = 0;
+	}
+	trigger_h_armed = false;
+	trigger_v_armed = false;
+	SREG = sreg;
+}
+
+uint8_t position_trigger_count(trigger_axis_t axis) {
+	return lists[axis].count;
+}
+
+void position_trigger_set_mode(uint8_t mode) {
+	trigger_mode = mode & (TRIGGER_MODE_PIN | TRIGGER_MODE_EVENT);
+}
+
+uint8_t position_trigger_get_mode(void) {
+	return trigger_mode;
+}
+
+void position_trigger_arm(trigger_axis_t axis, int32_t current_pos, bool positive) {
+	trigger_list_t* list = &lists[axis];
+	int8_t index = -1;
+	
+	if (positive) {
+		// Primer punto por delante de la posición actual
+		for (uint8_t i = 0; i < list->count; i++) {
+			if (list->points[i] > current_pos) {
+				index = i;
+				break;
+			}
+		}
+		} else {
+		for (int8_t i = (int8_t)list->count - 1; i >= 0; i--) {
+			if (list->points[i] < current_pos) {
+				index = i;
+				break;
+			}
+		}
+	}
+	
+	uint8_t sreg = SREG;
+	cli();
+	list->next_index = index;
+	list->step = positive ? 1 : -1;
+	list->fired = 0;
+	load_next(axis);
+	SREG = sreg;
+}
+
+void position_trigger_disarm(trigger_axis_t axis) {
+	uint8_t sreg = SREG;
+	cli();
+	lists[axis].next_index = -1;
+	load_next(axis);
+	SREG = sreg;
+}
+
+// Se ejecuta dentro de la ISR del stepper: mínimo trabajo posible
+void position_trigger_fire(trigger_axis_t axis) {
+	trigger_list_t* list = &lists[axis];
+	
+	if (trigger_mode & TRIGGER_MODE_PIN) {
+		PINH = (1 << 5);  // Escribir 1 en PINx conmuta el pin
+	}
+	
+	if (trigger_mode & TRIGGER_MODE_EVENT) {
+		uint8_t next_head = (event_head + 1) % TRIGGER_EVENT_QUEUE;
+		if (next_head != event_tail) {
+			event_queue[event_head].timestamp_us = system_clock_micros();
+			event_queue[event_head].position = list->points[list->next_index];
+			event_queue[event_head].axis = axis;
+			event_queue[event_head].index = (uint8_t)list->next_index;
+			event_head = next_head;
+			} else {
+			events_dropped++;
+		}
+	}
+	
+	list->fired++;
+	list->next_index += list->step;
+	load_next(axis);
+}
+
+void position_trigger_process_events(void) {
+	while (event_tail != event_head) {
+		trigger_event_t event = event_queue[event_tail];
+		event_tail = (event_tail + 1) % TRIGGER_EVENT_QUEUE;
+		
+		char msg[64];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_msg(&r, MSG_TRIGGER_EVENT);
+		resp_char(&r, ':');
+		resp_char(&r, (event.axis == TRIGGER_AXIS_H) ? 'H' : 'V');
+		resp_char(&r, ',');
+		resp_uint(&r, event.index);
+		resp_char(&r, ',');
+		resp_int(&r, event.position);
+		resp_str_P(&r, PSTR(",T="));
+		resp_uint(&r, event.timestamp_us);
+		event_log_send(LOG_CAT_TRIGGER, LOG_EVENT, msg);
+	}
+}
+
+uint16_t position_trigger_get_dropped(void) {
+	uint16_t dropped;
+	uint8_t sreg = SREG;
+	cli();
+	dropped = events_dropped;
+	SREG = sreg;
+	return dropped;
+}
+
+uint8_t position_trigger_pending(void) {
+	uint8_t head = event_head;
+	uint8_t tail = event_tail;
+	return (uint8_t)((head + TRIGGER_EVENT_QUEUE - tail) % TRIGGER_EVENT_QUEUE);
+}
@@ -0,0 +1,56 @@
+#ifndef POSITION_TRIGGER_H
+#define POSITION_TRIGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Salida de disparo de cámara (libre en el cableado actual)
+#define TRIGGER_OUT_PIN     8       // PH5
+
+// Capacidad de las listas (por eje) y de la cola de eventos
+#define TRIGGER_MAX_POINTS  24
+#define TRIGGER_EVENT_QUEUE 16
+
+// Acciones al cruzar una posición
+#define TRIGGER_MODE_PIN    0x01    // Conmutar TRIGGER_OUT_PIN
+#define TRIGGER_MODE_EVENT  0x02    // Encolar evento con timestamp
+
+// Eje de la lista
+typedef enum {
+	TRIGGER_AXIS_H = 0,
+	TRIGGER_AXIS_V = 1
+} trigger_axis_t;
+
+// Próxima posición armada por eje: la ISR del stepper solo compara contra esto
+extern volatile bool trigger_h_armed;
+extern volatile bool trigger_v_armed;
+extern volatile int32_t trigger_h_next;
+extern volatile int32_t trigger_v_next;
+
+void position_trigger_init(void);
+
+// Gestión de listas (fuera de movimiento: la lista armada solo se elige al
+// arrancar un eje). Un punto repetido no ocupa lugar
+bool position_trigger_add(trigger_axis_t axis, int32_t position);   // false si la lista está llena
+void position_trigger_clear(void);
+uint8_t position_trigger_count(trigger_axis_t axis);
+void position_trigger_set_mode(uint8_t mode);
+uint8_t position_trigger_get_mode(void);
+
+// Armar la lista al arrancar un eje (elige el primer punto en el sentido de marcha)
+void position_trigger_arm(trigger_axis_t axis, int32_t current_pos, bool positive);
+void position_trigger_disarm(trigger_axis_t axis);
+
+// Llamada desde la ISR del eje cuando current_position == trigger_x_next
+void position_trigger_fire(trigger_axis_t axis);
+
+// Enviar eventos encolados (llamar desde el loop principal)
+void position_trigger_process_events(void);
+
+// Eventos perdidos por cola llena
+uint16_t position_trigger_get_dropped(void);
+
+// Eventos encolados pendientes de enviar
+uint8_t position_trigger_pending(void);
+
+#endif // POSITION_TRIGGER_H
@@ -2,6 +2,12 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "../config/system_config.h"
+#include "../config/parameters.h"
+#include "system_clock.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../command/command_seq.h"
+#include <avr/pgmspace.h>
 #include <avr/eeprom.h>
 
 // Direcciones EEPROM
@@ -10,28 +16,17 @@
 #define EEPROM_MAGIC       0x02
 #define EEPROM_MAGIC_VALUE 0xAA
 
-// Variables para tiempo independiente con Timer2
-static volatile uint32_t servo_millis = 0;
-
 // Declaracin adelantada
 static void servo_save_positions(void);
 static void servo_set_position_raw(uint8_t servo_num, uint8_t angle);
 
 static servo_controller_t servo_ctrl = {0};
 
-// ISR Timer2 - 1000Hz para actualizacin suave
-ISR(TIMER2_COMPA_vect) {
-	servo_millis++;
-}
+// Lmite de velocidad del preset de movimiento (ms por grado, 0 = sin lmite)
+static uint8_t speed_limit_ms_per_deg = 0;
 
-// Funcin para obtener tiempo en ms
-static uint32_t servo_get_millis(void) {
-	uint32_t ms;
-	uint8_t oldSREG = SREG;
-	cli();
-	ms = servo_millis;
-	SREG = oldSREG;
-	return ms;
+static uint8_t angle_delta(uint8_t a, uint8_t b) {
+	return (a > b) ? a - b : b - a;
 }
 
 void servo_init(void) {
@@ -43,12 +38,6 @@ void servo_init(void) {
 	TCCR5B = (1 << WGM53) | (1 << WGM52) | (1 << CS51);  // Fast PWM, prescaler 8
 	ICR5 = 39999;  // TOP value para 50Hz
 	
-	// Configurar Timer2 para 1000Hz (1ms)
-	TCCR2A = (1 << WGM21);     // Modo CTC
-	TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20);  // Prescaler 1024
-	OCR2A = 15;                 // 16MHz / 1024 / 16 = ~1000Hz
-	TIMSK2 = (1 << OCIE2A);     // Habilitar interrupcin
-	
 	// Inicializar en posicin por defecto PRIMERO
 	servo_ctrl.current_pos1 = SERVO1_DEFAULT_POS;
 	servo_ctrl.current_pos2 = SERVO2_DEFAULT_POS;
@@ -100,8 +89,8 @@ static void servo_set_position_raw(uint8_t servo_num, uint8_t angle) {
 	// 1.5ms = 3000 counts (90)
 	// 2.25ms = 4500 counts (180)
 	
-	uint16_t min_count = SERVO_PWM_MIN;
-	uint16_t max_count = SERVO_PWM_MAX;
+	uint16_t min_count = param_get(PARAM_SERVO_PWM_MIN);
+	uint16_t max_count = param_get(PARAM_SERVO_PWM_MAX);
 	
 	uint16_t ocr_value = min_count +
 	((uint32_t)(max_count - min_count) * angle) / 180;
@@ -112,9 +101,16 @@ static void servo_set_position_raw(uint8_t servo_num, uint8_t angle) {
 		OCR5B = ocr_value;
 	}
 	
-	char msg[64];
-	snprintf(msg, sizeof(msg), "SERVO_CHANGED:%d,%d", servo_num, angle);
-	uart_send_response(msg);
+	// Se llama en cada paso de la interpolacin: no formatear si el nivel lo descarta
+	if (!event_log_enabled(LOG_CAT_SERVO, LOG_TRACE)) return;
+	
+	char msg[32];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, MSG_SERVO_CHANGED);
+	resp_char(&r, ':');
+	resp_int_pair(&r, servo_num, angle);
+	event_log_coalesce(LOG_CAT_SERVO, LOG_TRACE, servo_num, msg);
 }
 
 void servo_move_to(uint8_t angle1, uint8_t angle2, uint16_t time_ms) {
@@ -123,6 +119,15 @@ void servo_move_to(uint8_t angle1, uint8_t angle2, uint16_t time_ms) {
 	if (angle2 < SERVO2_MIN_ANGLE) angle2 = SERVO2_MIN_ANGLE;
 	if (angle2 > SERVO2_MAX_ANGLE) angle2 = SERVO2_MAX_ANGLE;
 	
+	// Con lmite de velocidad el movimiento dura al menos lo que pide el servo que ms recorre
+	if (speed_limit_ms_per_deg) {
+		uint8_t d1 = angle_delta(angle1, servo_ctrl.current_pos1);
+		uint8_t d2 = angle_delta(angle2, servo_ctrl.current_pos2);
+		uint16_t min_time = (uint16_t)((d1 > d2) ? d1 : d2) * speed_limit_ms_per_deg;
+		if (min_time > SERVO_MAX_MOVE_TIME) min_time = SERVO_MAX_MOVE_TIME;
+		if (time_ms < min_time) time_ms = min_time;
+	}
+	
 	if (time_ms == 0) {
 		servo_ctrl.current_pos1 = angle1;
 		servo_ctrl.current_pos2 = angle2;
@@ -131,26 +136,40 @@ void servo_move_to(uint8_t angle1, uint8_t angle2, uint16_t time_ms) {
 		servo_save_positions();
 		servo_ctrl.state = SERVO_IDLE;
 		
-		uart_send_response("SERVO_MOVE_COMPLETED:INSTANT");
+		if (event_log_enabled(LOG_CAT_SERVO, LOG_EVENT)) {
+			char msg[40];
+			response_t r;
+			resp_init(&r, msg, sizeof(msg));
+			resp_seq_take(&r, SEQ_SERVO);
+			resp_msg(&r, MSG_SERVO_MOVE_COMPLETED);
+			resp_str_P(&r, PSTR(":INSTANT"));
+			uart_send_event(msg);
+		}
 		} else {
 		servo_ctrl.start_pos1 = servo_ctrl.current_pos1;
 		servo_ctrl.start_pos2 = servo_ctrl.current_pos2;
 		servo_ctrl.target_pos1 = angle1;
 		servo_ctrl.target_pos2 = angle2;
-		servo_ctrl.start_time_ms = servo_get_millis();
+		servo_ctrl.start_time_ms = system_clock_millis();
 		servo_ctrl.duration_ms = time_ms;
 		servo_ctrl.state = SERVO_MOVING;
 		
-		char msg[64];
-		snprintf(msg, sizeof(msg), "SERVO_MOVE_STARTED:%d,%d,%d", angle1, angle2, time_ms);
-		uart_send_response(msg);
+		char msg[40];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_msg(&r, MSG_SERVO_MOVE_STARTED);
+		resp_char(&r, ':');
+		resp_int_pair(&r, angle1, angle2);
+		resp_char(&r, ',');
+		resp_uint(&r, time_ms);
+		event_log_send_event(LOG_CAT_SERVO, LOG_EVENT, msg);
 	}
 }
 
 void servo_update(void) {
 	if (servo_ctrl.state != SERVO_MOVING) return;
 	
-	uint32_t current_time = servo_get_millis();
+	uint32_t current_time = system_clock_millis();
 	uint32_t elapsed_time = current_time - servo_ctrl.start_time_ms;
 	
 	if (elapsed_time >= servo_ctrl.duration_ms) {
@@ -161,9 +180,14 @@ void servo_update(void) {
 		servo_save_positions();
 		servo_ctrl.state = SERVO_IDLE;
 		
-		char msg[64];
-		snprintf(msg, sizeof(msg), "SERVO_MOVE_COMPLETED:%d,%d", servo_ctrl.target_pos1, servo_ctrl.target_pos2);
-		uart_send_response(msg);
+		char msg[40];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_seq_take(&r, SEQ_SERVO);
+		resp_msg(&r, MSG_SERVO_MOVE_COMPLETED);
+		resp_char(&r, ':');
+		resp_int_pair(&r, servo_ctrl.target_pos1, servo_ctrl.target_pos2);
+		event_log_send_event(LOG_CAT_SERVO, LOG_EVENT, msg);
 		} else {
 		float progress = (float)elapsed_time / (float)servo_ctrl.duration_ms;
 		
@@ -182,6 +206,15 @@ void servo_update(void) {
 }
 
 void servo_set_position(uint8_t servo_num, uint8_t angle) {
+	// Con lmite de velocidad (preset con carga) tampoco hay saltos: se
+	// interpola y el otro servo sigue hacia su destino
+	if (speed_limit_ms_per_deg && (servo_num == 1 || servo_num == 2)) {
+		uint8_t angle1 = (servo_num == 1) ? angle : servo_get_target_position(1);
+		uint8_t angle2 = (servo_num == 2) ? angle : servo_get_target_position(2);
+		servo_move_to(angle1, angle2, 0);
+		return;
+	}
+	
 	servo_set_position_raw(servo_num, angle);
 	
 	if (servo_num == 1) {
@@ -192,15 +225,30 @@ void servo_set_position(uint8_t servo_num, uint8_t angle) {
 	
 	servo_save_positions();
 	
-	char msg[64];
-	snprintf(msg, sizeof(msg), "SERVO_MOVE_COMPLETED:%d,%d", servo_num, angle);
+	char msg[40];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_seq_take(&r, SEQ_SERVO);
+	resp_msg(&r, MSG_SERVO_MOVE_COMPLETED);
+	resp_char(&r, ':');
+	resp_int_pair(&r, servo_num, angle);
 	uart_send_response(msg);
 }
 
+void servo_set_speed_limit(uint8_t ms_per_degree) {
+	speed_limit_ms_per_deg = ms_per_degree;
+}
+
 bool servo_is_busy(void) {
 	return (servo_ctrl.state == SERVO_MOVING);
 }
 
 uint8_t servo_get_current_position(uint8_t servo_num) {
 	return (servo_num == 1) ? servo_ctrl.current_pos1 : servo_ctrl.current_pos2;
+}
+
+uint8_t servo_get_target_position(uint8_t servo_num) {
+	// Sin interpolacin en curso el destino es la posicin actual
+	if (servo_ctrl.state != SERVO_MOVING) return servo_get_current_position(servo_num);
+	return (servo_num == 1) ? servo_ctrl.target_pos1 : servo_ctrl.target_pos2;
 }
\ No newline at end of file
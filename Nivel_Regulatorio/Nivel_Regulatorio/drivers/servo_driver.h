@@ -37,8 +37,10 @@ void servo_init(void);
 void servo_set_position(uint8_t servo_num, uint8_t angle);
 void servo_move_to(uint8_t angle1, uint8_t angle2, uint16_t time_ms);
 void servo_update(void);
+void servo_set_speed_limit(uint8_t ms_per_degree);   // Duracin mnima por grado (0 = sin lmite)
 bool servo_is_busy(void);
 uint8_t servo_get_current_position(uint8_t servo_num);
+uint8_t servo_get_target_position(uint8_t servo_num);
 void stepper_start_calibration(void);
 void stepper_stop_calibration(void);
 
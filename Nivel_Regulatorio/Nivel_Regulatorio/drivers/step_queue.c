@@ -0,0 +1,193 @@
+#include "step_queue.h"
+#include "stepper_driver.h"
+#include "system_clock.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../command/message_catalog.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+
+#define STEP_QUEUE_MASK (STEP_QUEUE_SIZE - 1)
+
+// Un productor (loop principal) y un consumidor (ISR del eje) por cola:
+// head solo lo escribe push y tail solo pop
+static step_segment_t ring[STEP_QUEUE_AXIS_COUNT][STEP_QUEUE_SIZE];
+static volatile uint8_t head[STEP_QUEUE_AXIS_COUNT];
+static volatile uint8_t tail[STEP_QUEUE_AXIS_COUNT];
+
+static volatile bool ended = false;
+static volatile uint8_t underrun_mask = 0;
+static uint8_t participants = 0;
+static step_queue_state_t state = STEP_QUEUE_IDLE;
+static uint32_t start_at = 0;
+static uint16_t underruns = 0;
+
+void step_queue_init(void) {
+	step_queue_clear();
+	underruns = 0;
+}
+
+bool step_queue_segment_valid(const step_segment_t* seg) {
+	if (seg->interval < STEP_QUEUE_MIN_INTERVAL_US || seg->interval > STEP_QUEUE_MAX_INTERVAL_US) return false;
+	if (seg->count == 0) return seg->add == 0;
+
+	// El intervalo del último paso también tiene que caber en el timer
+	int32_t steps = (seg->count > 0) ? seg->count : -(int32_t)seg->count;
+	int32_t last = (int32_t)seg->interval + (steps - 1) * seg->add;
+	return last >= (int32_t)STEP_QUEUE_MIN_INTERVAL_US && last <= STEP_QUEUE_MAX_INTERVAL_US;
+}
+
+uint8_t step_queue_count(step_queue_axis_t axis) {
+	return (uint8_t)(head[axis] - tail[axis]) & STEP_QUEUE_MASK;
+}
+
+uint8_t step_queue_free(step_queue_axis_t axis) {
+	// Un hueco queda libre para distinguir llena de vacía
+	return STEP_QUEUE_SIZE - 1 - step_queue_count(axis);
+}
+
+step_queue_result_t step_queue_push(step_queue_axis_t axis, const step_segment_t* segs, uint8_t n) {
+	if (ended || (state == STEP_QUEUE_RUNNING && !(participants & (1 << axis)))) return STEP_QUEUE_BUSY;
+	for (uint8_t i = 0; i < n; i++) {
+		if (!step_queue_segment_valid(&segs[i])) return STEP_QUEUE_INVALID;
+	}
+	if (n > step_queue_free(axis)) return STEP_QUEUE_FULL;
+
+	uint8_t h = head[axis];
+	for (uint8_t i = 0; i < n; i++) {
+		ring[axis][h] = segs[i];
+		h = (h + 1) & STEP_QUEUE_MASK;
+	}
+	head[axis] = h;   // Publicar después de copiar: la ISR ve segmentos completos
+	return STEP_QUEUE_OK;
+}
+
+bool step_queue_pop(step_queue_axis_t axis, step_segment_t* seg) {
+	uint8_t t = tail[axis];
+	if (t == head[axis]) {
+		if (!ended) underrun_mask |= (uint8_t)(1 << axis);
+		return false;
+	}
+	*seg = ring[axis][t];
+	tail[axis] = (t + 1) & STEP_QUEUE_MASK;
+	return true;
+}
+
+bool step_queue_start(uint32_t start_us) {
+	if (state != STEP_QUEUE_IDLE) return false;
+	if (step_queue_count(STEP_QUEUE_AXIS_H) == 0 && step_queue_count(STEP_QUEUE_AXIS_V) == 0) return false;
+
+	underrun_mask = 0;
+	start_at = start_us;
+	state = STEP_QUEUE_ARMED;
+	return true;
+}
+
+void step_queue_end(void) {
+	ended = true;
+}
+
+void step_queue_clear(void) {
+	uint8_t sreg = SREG;
+	cli();
+	for (uint8_t i = 0; i < STEP_QUEUE_AXIS_COUNT; i++) {
+		head[i] = 0;
+		tail[i] = 0;
+	}
+	ended = false;
+	underrun_mask = 0;
+	participants = 0;
+	state = STEP_QUEUE_IDLE;
+	SREG = sreg;
+}
+
+bool step_queue_is_active(void) {
+	return state != STEP_QUEUE_IDLE;
+}
+
+step_queue_state_t step_queue_get_state(void) {
+	return state;
+}
+
+const char* step_queue_state_name(step_queue_state_t st) {
+	switch (st) {
+		case STEP_QUEUE_ARMED: return PSTR("ARMED");
+		case STEP_QUEUE_RUNNING: return PSTR("RUN");
+		default: return PSTR("IDLE");
+	}
+}
+
+uint16_t step_queue_get_underruns(void) {
+	return underruns;
+}
+
+static void resp_axes(response_t* r, uint8_t mask) {
+	if (mask & (1 << STEP_QUEUE_AXIS_H)) resp_char(r, 'H');
+	if (mask & (1 << STEP_QUEUE_AXIS_V)) resp_char(r, 'V');
+}
+
+// <name>:AXES=<ejes>,POS=h,v[,LEFT=nh,nv]
+static void report_end(msg_id_t id, uint8_t axes, bool with_left) {
+	int32_t h_pos, v_pos;
+	stepper_get_position(&h_pos, &v_pos);
+
+	char msg[64];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, id);
+	resp_str_P(&r, PSTR(":AXES="));
+	resp_axes(&r, axes);
+	resp_str_P(&r, PSTR(",POS="));
+	resp_int_pair(&r, h_pos, v_pos);
+	if (with_left) {
+		resp_str_P(&r, PSTR(",LEFT="));
+		resp_int_pair(&r, step_queue_count(STEP_QUEUE_AXIS_H), step_queue_count(STEP_QUEUE_AXIS_V));
+	}
+	event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
+}
+
+void step_queue_update(void) {
+	if (state == STEP_QUEUE_ARMED) {
+		// El arranque se programa en los timers con hasta 20ms de antelación
+		int32_t lead = (int32_t)(start_at - system_clock_micros());
+		if (lead > STEP_QUEUE_START_WINDOW_US) return;
+
+		participants = 0;
+		if (step_queue_count(STEP_QUEUE_AXIS_H) > 0) participants |= (1 << STEP_QUEUE_AXIS_H);
+		if (step_queue_count(STEP_QUEUE_AXIS_V) > 0) participants |= (1 << STEP_QUEUE_AXIS_V);
+		uint32_t late = stepper_queue_begin(start_at, participants);
+		state = STEP_QUEUE_RUNNING;
+
+		char msg[48];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_msg(&r, MSG_STEP_QUEUE_STARTED);
+		resp_str_P(&r, PSTR(":AXES="));
+		resp_axes(&r, participants);
+		resp_str_P(&r, PSTR(",LATE="));
+		resp_uint(&r, late);
+		event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
+		return;
+	}
+
+	if (state != STEP_QUEUE_RUNNING) return;
+
+	uint8_t starved = underrun_mask;
+	if (starved) {
+		// Un eje sin segmentos desincroniza la trayectoria: parar ambos
+		stepper_stop_silent();
+		underruns++;
+		report_end(MSG_STEP_QUEUE_UNDERRUN, starved, false);
+		step_queue_clear();
+		return;
+	}
+
+	if (stepper_queue_running()) return;
+
+	// Ejes detenidos con la secuencia completa, o por límite / parada
+	bool drained = ended && step_queue_count(STEP_QUEUE_AXIS_H) == 0 && step_queue_count(STEP_QUEUE_AXIS_V) == 0;
+	report_end(drained ? MSG_STEP_QUEUE_DONE : MSG_STEP_QUEUE_ABORTED, participants, !drained);
+	step_queue_clear();
+}
@@ -0,0 +1,80 @@
+#ifndef STEP_QUEUE_H
+#define STEP_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../config/system_config.h"
+
+// Secuencias de pasos calculadas por el host (estilo queue_step): cada eje
+// tiene una cola de segmentos comprimidos que las ISR de Timer1/Timer3
+// reproducen sin perfil ni destino propios.
+//
+// Segmento = (interval, count, add): count pasos, el primero `interval` us
+// después del paso anterior y cada uno `add` us más tarde que el anterior.
+// El signo de count da la dirección; count = 0 es una pausa de `interval` us
+// sin pulso (mantiene el eje sincronizado mientras el otro se mueve).
+//
+// QG fija el instante de arranque en el reloj del firmware (system_clock):
+// el primer segmento cuenta desde ahí. Solo participan los ejes con
+// segmentos al arrancar; cada uno debe recibir los siguientes antes de
+// vaciar su cola. Si se vacía sin que el host haya cerrado la secuencia con
+// QE es un underrun: se detienen ambos ejes y se reporta.
+
+typedef enum {
+	STEP_QUEUE_AXIS_H = 0,
+	STEP_QUEUE_AXIS_V = 1,
+	STEP_QUEUE_AXIS_COUNT
+} step_queue_axis_t;
+
+typedef struct {
+	uint16_t interval;      // us hasta el primer paso
+	int16_t count;          // Pasos con signo; 0 = pausa
+	int16_t add;            // us sumados al intervalo en cada paso
+} step_segment_t;
+
+typedef enum {
+	STEP_QUEUE_IDLE = 0,
+	STEP_QUEUE_ARMED,       // Esperando el instante de arranque
+	STEP_QUEUE_RUNNING
+} step_queue_state_t;
+
+typedef enum {
+	STEP_QUEUE_OK = 0,
+	STEP_QUEUE_INVALID,     // Intervalo fuera de rango en algún paso del segmento
+	STEP_QUEUE_FULL,
+	STEP_QUEUE_BUSY         // El eje no participa de la secuencia en curso
+} step_queue_result_t;
+
+void step_queue_init(void);
+
+// Comprobar un segmento sin encolarlo
+bool step_queue_segment_valid(const step_segment_t* seg);
+
+// Encolar n segmentos en un eje (todos o ninguno)
+step_queue_result_t step_queue_push(step_queue_axis_t axis, const step_segment_t* segs, uint8_t n);
+
+// Extraer el siguiente segmento (desde la ISR del eje). Cola vacía sin QE
+// registra el underrun
+bool step_queue_pop(step_queue_axis_t axis, step_segment_t* seg);
+
+uint8_t step_queue_count(step_queue_axis_t axis);
+uint8_t step_queue_free(step_queue_axis_t axis);
+
+// QG: arrancar en start_us (reloj del firmware)
+bool step_queue_start(uint32_t start_us);
+
+// QE: no llegarán más segmentos; vaciar las colas termina la secuencia
+void step_queue_end(void);
+
+// Descartar segmentos y estado (S, QX, parada rápida). Los ejes los para el llamador
+void step_queue_clear(void);
+
+bool step_queue_is_active(void);    // Armada o en reproducción
+step_queue_state_t step_queue_get_state(void);
+const char* step_queue_state_name(step_queue_state_t state);   // Texto en flash (PSTR)
+uint16_t step_queue_get_underruns(void);
+
+// Llamar desde el loop principal: arranque programado y fin de la secuencia
+void step_queue_update(void);
+
+#endif // STEP_QUEUE_H
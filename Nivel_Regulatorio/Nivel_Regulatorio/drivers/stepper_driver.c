@@ -1,9 +1,23 @@
 #include "stepper_driver.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "../config/system_config.h"
+#include "../config/parameters.h"
 #include <stdlib.h>
+#include <string.h>
 #include "../limits/limit_switch.h"
+#include "position_trigger.h"
+#include "system_clock.h"
+#include "uart_driver.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../command/message_catalog.h"
+#include "../command/command_seq.h"
+#include <avr/pgmspace.h>
+#include "../moves/position_history.h"
+#include "step_queue.h"
+#include "../moves/units.h"
 
 // Variables para modo calibraci�n
 static bool calibration_mode = false;
@@ -26,19 +40,98 @@ static volatile bool update_speeds_flag = false;
 static volatile bool movement_completed_flag = false;
 static volatile bool h_axis_completed = false;
 static volatile bool v_axis_completed = false;
+static volatile uint32_t axis_completed_us = 0;   // Instante del último eje en llegar
+
+// Parada controlada / feed-hold (procesados al completar la deceleración)
+typedef enum {
+	STOP_REQUEST_NONE = 0,
+	STOP_REQUEST_DECEL,     // Parada con deceleración: se reporta como STEPPER_DECEL_STOP
+	STOP_REQUEST_HOLD,      // Feed-hold: se conserva el destino para reanudar
+	STOP_REQUEST_RETARGET   // Cambio de destino que exige frenar: continuar al detenerse
+} stop_request_t;
+
+static volatile stop_request_t pending_stop = STOP_REQUEST_NONE;
+static bool feed_hold_active = false;
+static int32_t hold_h_target = 0;
+static int32_t hold_v_target = 0;
+
+// Límites del último movimiento por destino (rigen también al reanudar un
+// hold o al continuar tras frenar por un retarget); el jog usa los del eje
+static move_limits_t move_limits = {0};
+
+// Modo jog (velocidad continua): se mantiene hasta nueva velocidad, parada o límite
+static bool jog_active = false;
+static int16_t jog_h_velocity = 0;     // pasos/s con signo
+static int16_t jog_v_velocity = 0;
+static uint8_t jog_report_counter = 0;
+
+// Límites de software para el jog (en pasos)
+static bool soft_limits_enabled = false;
+static int32_t soft_h_min = 0;
+static int32_t soft_h_max = 0;
+static int32_t soft_v_min = 0;
+static int32_t soft_v_max = 0;
+
+// Override de avance en % de la velocidad nominal (se aplica también en movimiento)
+static uint16_t feed_override_percent = 100;
 
 // Variables para alternar HIGH/LOW en interrupciones
 static volatile bool h_step_state = false;  // false=LOW, true=HIGH
 static volatile bool v_step_state = false;  // false=LOW, true=HIGH
 
+// Parada rápida desde la ISR de recepción: hasta que stepper_stop_all la
+// procese ningún timer de pasos puede volver a arrancar
+static volatile bool halt_latched = false;
+
+// Reproducción de la cola de pasos del host: segmento en curso de cada eje
+typedef struct {
+	volatile bool active;
+	bool start_wait;        // Primer compare: llegada al instante de arranque
+	bool pulse;             // false en una pausa (count = 0)
+	uint16_t interval;      // us hasta el próximo paso
+	uint16_t count;         // Pasos restantes del segmento
+	int16_t add;
+} queue_run_t;
+
+static queue_run_t h_run = {0};
+static queue_run_t v_run = {0};
+
+static void set_axis_direction(stepper_axis_t* axis, bool positive);
+
 static int32_t abs32(int32_t x) {
 	return (x < 0) ? -x : x;
 }
 
+// "<name>:h,v,REL:rh,rv,MM:mh,mv" - formato común de fin de movimiento y paradas (mm con 2 decimales)
+const char* stepper_format_motion_report(response_t* r, msg_id_t id, int32_t h_centi, int32_t v_centi) {
+	resp_msg(r, id);
+	resp_char(r, ':');
+	resp_int_pair(r, horizontal_axis.current_position, vertical_axis.current_position);
+	resp_str_P(r, PSTR(",REL:"));
+	resp_int_pair(r, relative_h_counter, relative_v_counter);
+	resp_str_P(r, PSTR(",MM:"));
+	units_resp_mm_pair(r, h_centi, v_centi);
+	return resp_cstr(r);
+}
+
+// "<name>:FROM=h,v,TO=th,tv"
+static const char* build_move_started(response_t* r, msg_id_t id, int32_t h_to, int32_t v_to) {
+	resp_msg(r, id);
+	resp_str_P(r, PSTR(":FROM="));
+	resp_int_pair(r, horizontal_axis.current_position, vertical_axis.current_position);
+	resp_str_P(r, PSTR(",TO="));
+	resp_int_pair(r, h_to, v_to);
+	return resp_cstr(r);
+}
+
 // Timer4 para actualización periódica de velocidades (200Hz)
 ISR(TIMER4_COMPA_vect) {
 	update_speeds_flag = true;
-	motion_profile_tick();  // Incrementar contador para motion profile
+	system_clock_tick();  // Programar el siguiente tick (compare móvil sobre el reloj libre)
+	
+	// Historial de posición para georreferenciar capturas
+	position_history_tick(horizontal_axis.state != STEPPER_IDLE || vertical_axis.state != STEPPER_IDLE,
+		horizontal_axis.current_position, vertical_axis.current_position);
 	
 	// Verificar si ambos ejes completaron (procesamiento ligero)
 	if (h_axis_completed && v_axis_completed && !movement_completed_flag) {
@@ -67,19 +160,25 @@ static void update_horizontal_speed(uint16_t speed) {
 		// Asegurar que los pines queden en LOW
 		PORTB &= ~((1 << 5) | (1 << 6));  // Pins 11, 12 LOW
 		h_step_state = false;
+		h_run.active = false;
 		return;
 	}
 	
 	uint16_t top_value = calculate_timer_top(speed);
 	
-	// Si el timer no está corriendo, iniciarlo
+	// Si el timer no está corriendo, iniciarlo (salvo parada rápida pendiente)
 	if ((TCCR1B & 0x07) == 0) {
-		OCR1A = top_value;
-		OCR1B = top_value;
-		TCCR1A = 0;
-		TCCR1B = (1 << WGM12) | (1 << CS11); // Modo CTC, prescaler 8
-		TIMSK1 |= (1 << OCIE1A);
-		h_step_state = false;  // Empezar con LOW
+		uint8_t sreg = SREG;
+		cli();
+		if (!halt_latched) {
+			OCR1A = top_value;
+			OCR1B = top_value;
+			TCCR1A = 0;
+			TCCR1B = (1 << WGM12) | (1 << CS11); // Modo CTC, prescaler 8
+			TIMSK1 |= (1 << OCIE1A);
+			h_step_state = false;  // Empezar con LOW
+		}
+		SREG = sreg;
 	} else {
 		// Timer corriendo: Actualizar de forma SEGURA
 		// Deshabilitar interrupciones temporalmente para cambio atómico
@@ -106,18 +205,24 @@ static void update_vertical_speed(uint16_t speed) {
 		// Asegurar que el pin quede en LOW
 		PORTE &= ~(1 << 3);  // Pin 5 LOW
 		v_step_state = false;
+		v_run.active = false;
 		return;
 	}
 	
 	uint16_t top_value = calculate_timer_top(speed);
 	
-	// Si el timer no está corriendo, iniciarlo
+	// Si el timer no está corriendo, iniciarlo (salvo parada rápida pendiente)
 	if ((TCCR3B & 0x07) == 0) {
-		OCR3A = top_value;
-		TCCR3A = 0;
-		TCCR3B = (1 << WGM32) | (1 << CS31); // Modo CTC, prescaler 8
-		TIMSK3 |= (1 << OCIE3A);
-		v_step_state = false;  // Empezar con LOW
+		uint8_t sreg = SREG;
+		cli();
+		if (!halt_latched) {
+			OCR3A = top_value;
+			TCCR3A = 0;
+			TCCR3B = (1 << WGM32) | (1 << CS31); // Modo CTC, prescaler 8
+			TIMSK3 |= (1 << OCIE3A);
+			v_step_state = false;  // Empezar con LOW
+		}
+		SREG = sreg;
 	} else {
 		// Timer corriendo: Actualizar de forma SEGURA
 		// Deshabilitar interrupciones temporalmente para cambio atómico
@@ -134,8 +239,80 @@ static void update_vertical_speed(uint16_t speed) {
 	}
 }
 
+// Cargar el siguiente segmento de la cola; false si no hay
+static bool queue_load(queue_run_t* run, stepper_axis_t* axis, step_queue_axis_t id) {
+	step_segment_t seg;
+	if (!step_queue_pop(id, &seg)) return false;
+	
+	run->interval = seg.interval;
+	run->add = seg.add;
+	run->pulse = (seg.count != 0);
+	run->count = (seg.count > 0) ? seg.count : (seg.count < 0) ? -seg.count : 1;
+	
+	// La dirección cambia con el pin STEP en LOW, lejos del próximo flanco
+	if (run->pulse && (seg.count > 0) != axis->direction) {
+		set_axis_direction(axis, seg.count > 0);
+	}
+	return true;
+}
+
+// Pasar al siguiente paso de la secuencia. Devuelve el TOP del timer hasta
+// su flanco de subida, descontando los ticks ya transcurridos desde el paso
+static uint16_t queue_advance(queue_run_t* run, stepper_axis_t* axis, step_queue_axis_t id, uint16_t elapsed) {
+	if (--run->count == 0) {
+		if (!queue_load(run, axis, id)) {
+			run->active = false;
+			return 0xFFFF;
+		}
+		} else {
+		run->interval += run->add;
+	}
+	return (run->interval << 1) - elapsed - 1;
+}
+
+// Contar el paso recién dado en modo cola (sin disparos por posición)
+static inline void queue_count_step(stepper_axis_t* axis, volatile int32_t* relative) {
+	if (axis->direction) {
+		axis->current_position++;
+		(*relative)++;
+		} else {
+		axis->current_position--;
+		(*relative)--;
+	}
+}
+
 // ISR Timer1 - motores horizontales (SIN DELAYS)
 ISR(TIMER1_COMPA_vect) {
+	if (h_run.active) {
+		uint16_t top;
+		if (h_step_state) {
+			PORTB &= ~((1 << 5) | (1 << 6));
+			h_step_state = false;
+			queue_count_step(&horizontal_axis, &relative_h_counter);
+			top = queue_advance(&h_run, &horizontal_axis, STEP_QUEUE_AXIS_H, STEP_QUEUE_PULSE_TICKS);
+			} else if (h_run.start_wait) {
+			h_run.start_wait = false;
+			top = (h_run.interval << 1) - 1;
+			} else if (h_run.pulse) {
+			PORTB |= (1 << 5) | (1 << 6);
+			h_step_state = true;
+			top = STEP_QUEUE_PULSE_TICKS - 1;
+			} else {
+			// Pausa: el "paso" transcurre sin pulso
+			top = queue_advance(&h_run, &horizontal_axis, STEP_QUEUE_AXIS_H, 0);
+		}
+		
+		if (!h_run.active) {
+			update_horizontal_speed(0);
+			horizontal_axis.state = STEPPER_IDLE;
+			return;
+		}
+		// En CTC un TOP por debajo del contador daría la vuelta completa (32ms)
+		OCR1A = top;
+		if (TCNT1 >= top) TCNT1 = top - 1;
+		return;
+	}
+	
 	if (h_step_state) {
 		PORTB &= ~((1 << 5) | (1 << 6));
 		h_step_state = false;
@@ -148,6 +325,11 @@ ISR(TIMER1_COMPA_vect) {
 			relative_h_counter--;
 		}
 		
+		// Disparo por comparación de posición (cámara / eventos)
+		if (trigger_h_armed && horizontal_axis.current_position == trigger_h_next) {
+			position_trigger_fire(TRIGGER_AXIS_H);
+		}
+		
 		if (calibration_mode) {
 			calibration_step_counter++;
 		}
@@ -158,6 +340,7 @@ ISR(TIMER1_COMPA_vect) {
 			update_horizontal_speed(0);
 			horizontal_axis.state = STEPPER_IDLE;
 			motion_profile_reset(&horizontal_axis.profile);
+			axis_completed_us = system_clock_micros();
 			h_axis_completed = true;
 		}
 		} else {
@@ -167,6 +350,34 @@ ISR(TIMER1_COMPA_vect) {
 }
 
 ISR(TIMER3_COMPA_vect) {
+	if (v_run.active) {
+		uint16_t top;
+		if (v_step_state) {
+			PORTE &= ~(1 << 3);
+			v_step_state = false;
+			queue_count_step(&vertical_axis, &relative_v_counter);
+			top = queue_advance(&v_run, &vertical_axis, STEP_QUEUE_AXIS_V, STEP_QUEUE_PULSE_TICKS);
+			} else if (v_run.start_wait) {
+			v_run.start_wait = false;
+			top = (v_run.interval << 1) - 1;
+			} else if (v_run.pulse) {
+			PORTE |= (1 << 3);
+			v_step_state = true;
+			top = STEP_QUEUE_PULSE_TICKS - 1;
+			} else {
+			top = queue_advance(&v_run, &vertical_axis, STEP_QUEUE_AXIS_V, 0);
+		}
+		
+		if (!v_run.active) {
+			update_vertical_speed(0);
+			vertical_axis.state = STEPPER_IDLE;
+			return;
+		}
+		OCR3A = top;
+		if (TCNT3 >= top) TCNT3 = top - 1;
+		return;
+	}
+	
 	if (v_step_state) {
 		PORTE &= ~(1 << 3);
 		v_step_state = false;
@@ -179,6 +390,11 @@ ISR(TIMER3_COMPA_vect) {
 			relative_v_counter--;
 		}
 		
+		// Disparo por comparación de posición (cámara / eventos)
+		if (trigger_v_armed && vertical_axis.current_position == trigger_v_next) {
+			position_trigger_fire(TRIGGER_AXIS_V);
+		}
+		
 		if (calibration_mode) {
 			calibration_step_counter++;
 		}
@@ -189,6 +405,7 @@ ISR(TIMER3_COMPA_vect) {
 			update_vertical_speed(0);
 			vertical_axis.state = STEPPER_IDLE;
 			motion_profile_reset(&vertical_axis.profile);
+			axis_completed_us = system_clock_micros();
 			v_axis_completed = true;
 		}
 		} else {
@@ -225,26 +442,33 @@ void stepper_init(void) {
 	// Inicializar módulo de motion profile
 	motion_profile_init();
 	
+	// Razones enteras pasos <-> centésimas de mm
+	units_init();
+	
 	// Inicializar módulo de fines de carrera
 	limit_switch_init();
 	
+	// Inicializar disparos por posición
+	position_trigger_init();
+	
+	// Inicializar historial de posición
+	position_history_init();
+	
+	// Cola de pasos del host (vacía)
+	step_queue_init();
+	
 	// Inicializar estados por defecto
-	horizontal_axis.max_speed = MAX_SPEED_H;
-	horizontal_axis.acceleration = ACCEL_H;
+	horizontal_axis.max_speed = param_get(PARAM_MAX_SPEED_H);
+	horizontal_axis.acceleration = param_get(PARAM_ACCEL_H);
 	horizontal_axis.current_speed = 0;
 	horizontal_axis.state = STEPPER_IDLE;
 	
-	vertical_axis.max_speed = MAX_SPEED_V;
-	vertical_axis.acceleration = ACCEL_V;
+	vertical_axis.max_speed = param_get(PARAM_MAX_SPEED_V);
+	vertical_axis.acceleration = param_get(PARAM_ACCEL_V);
 	vertical_axis.current_speed = 0;
 	vertical_axis.state = STEPPER_IDLE;
 	
-	// Configurar Timer4 para actualización de velocidades (200Hz)
-	// Timer4 es de 16 bits en ATmega2560
-    TCCR4A = 0;
-    TCCR4B = (1 << WGM42) | (1 << CS42); // CTC mode, prescaler 256
-    OCR4A = 311; // 16MHz / 256 / 312 = ~200Hz (reduce sobrecarga, suficiente para control suave)
-    TIMSK4 = (1 << OCIE4A);
+	// El tick de 200Hz (compare A de Timer4) lo configura system_clock_init()
 
 	// Habilitar motores por defecto
 	stepper_enable_motors(true, true);
@@ -283,123 +507,516 @@ void stepper_enable_motors(bool h_enable, bool v_enable) {
 	}
 }
 
-void stepper_move_relative(int32_t h_steps, int32_t v_steps) {
-	stepper_move_absolute(
-	horizontal_axis.current_position + h_steps,
-	vertical_axis.current_position + v_steps
-	);
-}
+// Origen de una planificación de movimiento
+typedef enum {
+	MOVE_NEW = 0,       // Comando nuevo: resetea contadores relativos y snapshots
+	MOVE_RESUME,        // Reanudación tras feed-hold (conserva contadores)
+	MOVE_CONTINUE       // Continuación tras frenar por cambio de destino (ya anunciado)
+} move_start_t;
 
-void stepper_move_absolute(int32_t h_pos, int32_t v_pos) {
-	stepper_stop_silent();
-	
-	// Resetear contadores relativos al iniciar nuevo movimiento
-	relative_h_counter = 0;
-	relative_v_counter = 0;
-	
-	// Resetear snapshots al iniciar nuevo movimiento
-	snapshot_count = 0;
-	
-	horizontal_axis.target_position = h_pos;
-	vertical_axis.target_position = v_pos;
+static void start_movement(int32_t h_pos, int32_t v_pos, move_start_t mode);
+static void decel_axis(stepper_axis_t* axis);
+static void jog_apply(void);
+
+static uint16_t apply_feed_override(uint16_t speed) {
+	// El jog (y la corrección que lo usa) pide una velocidad exacta: sin override
+	if (jog_active) return speed;
 	
-	int32_t h_distance = abs32(h_pos - horizontal_axis.current_position);
-	int32_t v_distance = abs32(v_pos - vertical_axis.current_position);
+	uint32_t scaled = ((uint32_t)speed * feed_override_percent) / 100;
+	if (scaled > MAX_STEP_RATE) scaled = MAX_STEP_RATE;
+	if (scaled < 50) scaled = 50;
+	return (uint16_t)scaled;
+}
+
+static void set_axis_direction(stepper_axis_t* axis, bool positive) {
+	axis->direction = positive;
 	
-	if (h_pos > horizontal_axis.current_position) {
-		// INVERTIDO: X+ ahora va hacia la IZQUIERDA (igual que supervisor)
-		horizontal_axis.direction = true;
-		PORTA |= (1 << 0);
-		PORTA &= ~(1 << 2);
-		} else if (h_pos < horizontal_axis.current_position) {
-		// INVERTIDO: X- ahora va hacia la DERECHA (igual que supervisor)
-		horizontal_axis.direction = false;
-		PORTA &= ~(1 << 0);
-		PORTA |= (1 << 2);
+	if (axis == &horizontal_axis) {
+		if (positive) {
+			// INVERTIDO: X+ ahora va hacia la IZQUIERDA (igual que supervisor)
+			PORTA |= (1 << 0);
+			PORTA &= ~(1 << 2);
+			} else {
+			// INVERTIDO: X- ahora va hacia la DERECHA (igual que supervisor)
+			PORTA &= ~(1 << 0);
+			PORTA |= (1 << 2);
+		}
+		} else {
+		if (positive) {
+			PORTA &= ~(1 << 4);
+			} else {
+			PORTA |= (1 << 4);
+		}
 	}
+}
 
-	if (v_pos > vertical_axis.current_position) {
-		vertical_axis.direction = true;
-		PORTA &= ~(1 << 4);
-		} else if (v_pos < vertical_axis.current_position) {
-		vertical_axis.direction = false;
-		PORTA |= (1 << 4);
-	}
-	
-	uint16_t h_speed_adjusted = horizontal_axis.max_speed;
-	uint16_t v_speed_adjusted = vertical_axis.max_speed;
+// Velocidad y aceleración del movimiento para un eje (propias o las del eje)
+static uint16_t axis_max_speed(stepper_axis_t* axis) {
+	uint16_t limit = (axis == &horizontal_axis) ? move_limits.h_speed : move_limits.v_speed;
+	return limit ? limit : axis->max_speed;
+}
+
+static uint16_t axis_accel(stepper_axis_t* axis) {
+	uint16_t limit = (axis == &horizontal_axis) ? move_limits.h_accel : move_limits.v_accel;
+	return limit ? limit : axis->acceleration;
+}
+
+// Repartir velocidades para que ambos ejes lleguen a la vez
+static void compute_coordinated_speeds(int32_t h_distance, int32_t v_distance,
+uint16_t* h_speed, uint16_t* v_speed) {
+	uint16_t h_max = axis_max_speed(&horizontal_axis);
+	uint16_t v_max = axis_max_speed(&vertical_axis);
+	uint16_t h_speed_adjusted = h_max;
+	uint16_t v_speed_adjusted = v_max;
 	
 	if (h_distance > 0 && v_distance > 0 && horizontal_axis.enabled && vertical_axis.enabled) {
 		if (h_distance > v_distance) {
-			v_speed_adjusted = (uint32_t)horizontal_axis.max_speed * v_distance / h_distance;
-			h_speed_adjusted = horizontal_axis.max_speed;
+			v_speed_adjusted = (uint32_t)h_max * v_distance / h_distance;
+			h_speed_adjusted = h_max;
 			
 			if (v_speed_adjusted < 500) v_speed_adjusted = 500;
 			
-			if (v_speed_adjusted > vertical_axis.max_speed) {
-				h_speed_adjusted = (uint32_t)horizontal_axis.max_speed * vertical_axis.max_speed / v_speed_adjusted;
-				v_speed_adjusted = vertical_axis.max_speed;
+			if (v_speed_adjusted > v_max) {
+				h_speed_adjusted = (uint32_t)h_max * v_max / v_speed_adjusted;
+				v_speed_adjusted = v_max;
 			}
 			} else if (v_distance > h_distance) {
-			h_speed_adjusted = (uint32_t)vertical_axis.max_speed * h_distance / v_distance;
-			v_speed_adjusted = vertical_axis.max_speed;
+			h_speed_adjusted = (uint32_t)v_max * h_distance / v_distance;
+			v_speed_adjusted = v_max;
 			
 			if (h_speed_adjusted < 500) h_speed_adjusted = 500;
 			
-			if (h_speed_adjusted > horizontal_axis.max_speed) {
-				v_speed_adjusted = (uint32_t)vertical_axis.max_speed * horizontal_axis.max_speed / h_speed_adjusted;
-				h_speed_adjusted = horizontal_axis.max_speed;
+			if (h_speed_adjusted > h_max) {
+				v_speed_adjusted = (uint32_t)v_max * h_max / h_speed_adjusted;
+				h_speed_adjusted = h_max;
 			}
 		}
 	}
 	
+	*h_speed = h_speed_adjusted;
+	*v_speed = v_speed_adjusted;
+}
+
+// Arrancar un eje detenido hacia target. Devuelve true si el movimiento empezó
+static bool start_axis(stepper_axis_t* axis, int32_t target, uint16_t speed) {
+	if (target == axis->current_position) return false;
+	
+	bool positive = (target > axis->current_position);
+	set_axis_direction(axis, positive);
+	
+	if (!axis->enabled) return false;
+	
+	bool allowed = (axis == &horizontal_axis) ?
+		limit_switch_check_h_movement(positive) :
+		limit_switch_check_v_movement(positive);
+	if (!allowed) {
+		axis->target_position = axis->current_position;
+		return false;
+	}
+	
+	// Armar la lista de disparos en el sentido de marcha
+	position_trigger_arm((axis == &horizontal_axis) ? TRIGGER_AXIS_H : TRIGGER_AXIS_V,
+		axis->current_position, positive);
+	
+	motion_profile_setup(&axis->profile,
+	axis->current_position,
+	target,
+	apply_feed_override(speed),
+	axis_accel(axis));
+	axis->move_speed = speed;
+	axis->state = STEPPER_MOVING;
+	axis->current_speed = 0;
+	return true;
+}
+
+// ¿Puede el eje cambiar de destino sin detenerse? (misma dirección y fuera de la distancia de frenado)
+static bool axis_can_retarget(stepper_axis_t* axis, int32_t target) {
+	if (axis->state != STEPPER_MOVING) return true;
+	
+	int32_t delta = target - axis->current_position;
+	if (delta == 0 || (delta > 0) != axis->direction) return false;
+	
+	uint32_t v = axis->profile.current_speed;
+	uint32_t accel = axis_accel(axis);
+	if (accel == 0) accel = 1;
+	return (uint32_t)abs32(delta) > (v * v) / (2 * accel);
+}
+
+// Reprogramar un eje hacia un nuevo destino conservando su velocidad actual.
+// Devuelve false si el eje sigue en marcha pero ya pasó el destino: hay que
+// frenar y continuar desde reposo
+static bool retarget_axis(stepper_axis_t* axis, int32_t target, uint16_t speed, volatile bool* completed) {
+	if (axis->state == STEPPER_MOVING) {
+		bool moving;
+		bool retargeted;
+		uint16_t max_speed = apply_feed_override(speed);
+		uint16_t accel = axis_accel(axis);
+		
+		// Comprobar y actualizar destino, pasos y perfil en la misma seccin
+		// crtica: la ISR del eje no puede completarlo, pasar el destino ni
+		// resetear el perfil a medio recalcular
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			moving = (axis->state == STEPPER_MOVING);
+			int32_t ahead = axis->direction ? target - axis->current_position : axis->current_position - target;
+			retargeted = moving && ahead > 1 && motion_profile_is_active(&axis->profile);
+			if (retargeted) {
+				axis->target_position = target;
+				axis->profile.acceleration = accel;
+				motion_profile_retarget(&axis->profile, axis->current_position, target, max_speed);
+				axis->move_speed = speed;
+				*completed = false;
+			}
+		}
+		
+		if (retargeted) {
+			// Re-comprobar: si qued detenido lejos del nuevo destino sin que nadie
+			// lo cancelara (las paradas llevan el destino a la posicin actual),
+			// seguir desde reposo
+			bool stopped_short;
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				stopped_short = (axis->state != STEPPER_MOVING) &&
+					axis->target_position == target &&
+					abs32(target - axis->current_position) > 1;
+			}
+			if (!stopped_short) return true;
+			} else if (moving) {
+			return false;
+		}
+		// La ISR lo complet mientras tanto: arrancar desde reposo
+	}
+	
+	bool started = start_axis(axis, target, speed);
+	*completed = !started;
+	return true;
+}
+
+// Frenar ambos ejes y seguir hacia (h_pos, v_pos) desde reposo
+static void retarget_after_stop(int32_t h_pos, int32_t v_pos) {
+	hold_h_target = h_pos;
+	hold_v_target = v_pos;
+	pending_stop = STOP_REQUEST_RETARGET;
+	decel_axis(&horizontal_axis);
+	decel_axis(&vertical_axis);
+}
+
+// Nuevo destino recibido en pleno movimiento: re-planificar desde la posición y velocidad actuales
+static void retarget_movement(int32_t h_pos, int32_t v_pos) {
+	feed_hold_active = false;
+	jog_active = false;
+	
+	// Mismas semánticas de reporte que un movimiento nuevo
+	relative_h_counter = 0;
+	relative_v_counter = 0;
+	snapshot_count = 0;
+	movement_completed_flag = false;
+	
+	if (!axis_can_retarget(&horizontal_axis, h_pos) || !axis_can_retarget(&vertical_axis, v_pos)) {
+		// Inversión o destino dentro de la distancia de frenado: frenar y continuar desde reposo
+		retarget_after_stop(h_pos, v_pos);
+		} else {
+		pending_stop = STOP_REQUEST_NONE;
+		
+		uint16_t h_speed, v_speed;
+		compute_coordinated_speeds(abs32(h_pos - horizontal_axis.current_position),
+			abs32(v_pos - vertical_axis.current_position), &h_speed, &v_speed);
+		
+		bool h_ok = retarget_axis(&horizontal_axis, h_pos, h_speed, &h_axis_completed);
+		bool v_ok = retarget_axis(&vertical_axis, v_pos, v_speed, &v_axis_completed);
+		if (!h_ok || !v_ok) retarget_after_stop(h_pos, v_pos);
+	}
+	
+	char msg[64];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, build_move_started(&r, MSG_STEPPER_MOVE_STARTED, h_pos, v_pos));
+}
+
+void stepper_move_relative(int32_t h_steps, int32_t v_steps) {
+	stepper_move_relative_limited(h_steps, v_steps, NULL);
+}
+
+void stepper_move_absolute(int32_t h_pos, int32_t v_pos) {
+	stepper_move_absolute_limited(h_pos, v_pos, NULL);
+}
+
+void stepper_move_relative_limited(int32_t h_steps, int32_t v_steps, const move_limits_t* limits) {
+	stepper_move_absolute_limited(
+	horizontal_axis.current_position + h_steps,
+	vertical_axis.current_position + v_steps,
+	limits
+	);
+}
+
+// Límite propio de un movimiento (0 = el del eje): nunca por encima del
+// parámetro ni del valor del eje, que es el que fija el preset activo
+static uint16_t clamp_limit(uint16_t value, param_id_t max_param, uint16_t axis_value) {
+	uint16_t max = param_get(max_param);
+	if (axis_value < max) max = axis_value;
+	return (value > max) ? max : value;
+}
+
+void stepper_move_absolute_limited(int32_t h_pos, int32_t v_pos, const move_limits_t* limits) {
+	// Durante la cola de pasos los ejes son del host
+	if (step_queue_is_active()) return;
+	
+	// Cada movimiento trae sus límites: sin ellos vuelven a regir los del eje
+	if (limits) {
+		move_limits.h_speed = clamp_limit(limits->h_speed, PARAM_MAX_SPEED_H, horizontal_axis.max_speed);
+		move_limits.v_speed = clamp_limit(limits->v_speed, PARAM_MAX_SPEED_V, vertical_axis.max_speed);
+		move_limits.h_accel = clamp_limit(limits->h_accel, PARAM_ACCEL_H, horizontal_axis.acceleration);
+		move_limits.v_accel = clamp_limit(limits->v_accel, PARAM_ACCEL_V, vertical_axis.acceleration);
+	} else {
+		memset(&move_limits, 0, sizeof(move_limits));
+	}
+	
+	if (stepper_is_moving()) {
+		retarget_movement(h_pos, v_pos);
+		return;
+	}
+	start_movement(h_pos, v_pos, MOVE_NEW);
+}
+
+// Planificar movimiento desde reposo. MOVE_RESUME conserva los contadores relativos
+// y snapshots del movimiento interrumpido; MOVE_CONTINUE además no vuelve a anunciarlo
+static void start_movement(int32_t h_pos, int32_t v_pos, move_start_t mode) {
+	stepper_stop_silent();
+	
+	// Un movimiento nuevo descarta cualquier parada, hold o jog pendiente
+	pending_stop = STOP_REQUEST_NONE;
+	feed_hold_active = false;
+	jog_active = false;
+	
+	if (mode == MOVE_NEW) {
+		// Resetear contadores relativos al iniciar nuevo movimiento
+		relative_h_counter = 0;
+		relative_v_counter = 0;
+		
+		// Resetear snapshots al iniciar nuevo movimiento
+		snapshot_count = 0;
+	}
+	
+	horizontal_axis.target_position = h_pos;
+	vertical_axis.target_position = v_pos;
+	
+	int32_t h_distance = abs32(h_pos - horizontal_axis.current_position);
+	int32_t v_distance = abs32(v_pos - vertical_axis.current_position);
+	
+	uint16_t h_speed_adjusted, v_speed_adjusted;
+	compute_coordinated_speeds(h_distance, v_distance, &h_speed_adjusted, &v_speed_adjusted);
+	
 	// Resetear flags de completado
+	axis_completed_us = system_clock_micros();
 	h_axis_completed = (h_distance == 0);
 	v_axis_completed = (v_distance == 0);
 	movement_completed_flag = false;
 	
 	bool movement_started = false;
 	
-	if (h_distance > 0 && horizontal_axis.enabled) {
-		bool h_dir = (h_pos > horizontal_axis.current_position);
-		if (!limit_switch_check_h_movement(h_dir)) {
-			horizontal_axis.target_position = horizontal_axis.current_position;
-			h_distance = 0;
-			} else {
-			motion_profile_setup(&horizontal_axis.profile,
-			horizontal_axis.current_position,
-			h_pos,
-			h_speed_adjusted,
-			horizontal_axis.acceleration);
-			horizontal_axis.state = STEPPER_MOVING;
-			horizontal_axis.current_speed = 0;
-			movement_started = true;
-		}
+	if (start_axis(&horizontal_axis, h_pos, h_speed_adjusted)) {
+		movement_started = true;
+	}
+	
+	if (start_axis(&vertical_axis, v_pos, v_speed_adjusted)) {
+		movement_started = true;
 	}
 	
-	if (v_distance > 0 && vertical_axis.enabled) {
-		bool v_dir = (v_pos > vertical_axis.current_position);
-		if (!limit_switch_check_v_movement(v_dir)) {
-			vertical_axis.target_position = vertical_axis.current_position;
-			v_distance = 0;
+	if (movement_started && mode != MOVE_CONTINUE) {
+		char msg[64];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		build_move_started(&r, (mode == MOVE_RESUME) ? MSG_STEPPER_MOVE_RESUMED : MSG_STEPPER_MOVE_STARTED, h_pos, v_pos);
+		event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
+	}
+}
+
+// Acortar el destino de un eje en movimiento a su distancia de frenado
+static void decel_axis(stepper_axis_t* axis) {
+	if (axis->state != STEPPER_MOVING) return;
+	
+	int32_t new_target = motion_profile_decel_target(&axis->profile, axis->current_position);
+	
+	// target_position se lee en la ISR del eje: actualizar de forma atómica
+	uint8_t sreg = SREG;
+	cli();
+	axis->target_position = new_target;
+	SREG = sreg;
+}
+
+bool stepper_decel_stop(void) {
+	if (feed_hold_active && !stepper_is_moving()) {
+		// Detenido en hold: descartar el destino pendiente y reportar la parada
+		feed_hold_active = false;
+		pending_stop = STOP_REQUEST_DECEL;
+		axis_completed_us = system_clock_micros();
+		h_axis_completed = true;
+		v_axis_completed = true;
+		movement_completed_flag = true;
+		return true;
+	}
+	// La cola de pasos no tiene perfil que acortar: solo S o QX la detienen
+	if (!stepper_is_moving() || stepper_queue_running()) return false;
+	
+	// Un hold en curso se convierte en parada definitiva
+	pending_stop = STOP_REQUEST_DECEL;
+	decel_axis(&horizontal_axis);
+	decel_axis(&vertical_axis);
+	return true;
+}
+
+bool stepper_feed_hold(void) {
+	// En jog no hay destino que conservar: usar J:0,0 o SD
+	if (!stepper_is_moving() || pending_stop != STOP_REQUEST_NONE || jog_active || stepper_queue_running()) return false;
+	
+	// Guardar destino original antes de acortarlo
+	hold_h_target = horizontal_axis.target_position;
+	hold_v_target = vertical_axis.target_position;
+	
+	pending_stop = STOP_REQUEST_HOLD;
+	decel_axis(&horizontal_axis);
+	decel_axis(&vertical_axis);
+	return true;
+}
+
+bool stepper_feed_resume(void) {
+	if (!feed_hold_active || stepper_is_moving()) return false;
+	
+	start_movement(hold_h_target, hold_v_target, MOVE_RESUME);
+	return true;
+}
+
+uint16_t stepper_set_feed_override(uint16_t percent) {
+	if (percent < FEED_OVERRIDE_MIN) percent = FEED_OVERRIDE_MIN;
+	if (percent > FEED_OVERRIDE_MAX) percent = FEED_OVERRIDE_MAX;
+	feed_override_percent = percent;
+	
+	// Reescalar los perfiles activos; ambos ejes mantienen la relación de velocidades
+	if (horizontal_axis.state == STEPPER_MOVING) {
+		motion_profile_set_max_speed(&horizontal_axis.profile, horizontal_axis.current_position,
+			apply_feed_override(horizontal_axis.move_speed));
+	}
+	if (vertical_axis.state == STEPPER_MOVING) {
+		motion_profile_set_max_speed(&vertical_axis.profile, vertical_axis.current_position,
+			apply_feed_override(vertical_axis.move_speed));
+	}
+	
+	return feed_override_percent;
+}
+
+uint16_t stepper_get_feed_override(void) {
+	return feed_override_percent;
+}
+
+bool stepper_is_held(void) {
+	return feed_hold_active || pending_stop == STOP_REQUEST_HOLD;
+}
+
+// Destino del jog: el límite de software en el sentido de marcha, o un recorrido muy largo
+static int32_t jog_target(stepper_axis_t* axis, bool positive) {
+	if (soft_limits_enabled) {
+		bool is_h = (axis == &horizontal_axis);
+		int32_t limit = positive ? (is_h ? soft_h_max : soft_v_max) : (is_h ? soft_h_min : soft_v_min);
+		// Ya fuera de la ventana en ese sentido: no moverse
+		if (positive ? (axis->current_position >= limit) : (axis->current_position <= limit)) {
+			return axis->current_position;
+		}
+		return limit;
+	}
+	return positive ? axis->current_position + JOG_MAX_TRAVEL_STEPS :
+		axis->current_position - JOG_MAX_TRAVEL_STEPS;
+}
+
+// Acotada a la velocidad del eje antes de pasar a 16 bits
+static uint16_t jog_speed(stepper_axis_t* axis, int16_t velocity) {
+	int32_t speed = abs32(velocity);
+	uint16_t max_speed = axis_max_speed(axis);
+	if (speed > max_speed) speed = max_speed;
+	return (uint16_t)speed;
+}
+
+static bool jog_axis_can_change(stepper_axis_t* axis, int16_t velocity) {
+	if (velocity == 0) return true;  // Se frena en su propio eje
+	return axis_can_retarget(axis, jog_target(axis, velocity > 0));
+}
+
+// false si hay que frenar y reaplicar el jog desde reposo (ver retarget_axis)
+static bool jog_apply_axis(stepper_axis_t* axis, int16_t velocity, volatile bool* completed) {
+	if (velocity == 0) {
+		if (axis->state == STEPPER_MOVING) {
+			decel_axis(axis);
 			} else {
-			motion_profile_setup(&vertical_axis.profile,
-			vertical_axis.current_position,
-			v_pos,
-			v_speed_adjusted,
-			vertical_axis.acceleration);
-			vertical_axis.state = STEPPER_MOVING;
-			vertical_axis.current_speed = 0;
-			movement_started = true;
+			*completed = true;
 		}
+		return true;
+	}
+	return retarget_axis(axis, jog_target(axis, velocity > 0), jog_speed(axis, velocity), completed);
+}
+
+// Aplicar las velocidades de jog guardadas a ambos ejes
+static void jog_apply(void) {
+	if (jog_axis_can_change(&horizontal_axis, jog_h_velocity) &&
+		jog_axis_can_change(&vertical_axis, jog_v_velocity)) {
+		pending_stop = STOP_REQUEST_NONE;
+		movement_completed_flag = false;
+		bool h_ok = jog_apply_axis(&horizontal_axis, jog_h_velocity, &h_axis_completed);
+		bool v_ok = jog_apply_axis(&vertical_axis, jog_v_velocity, &v_axis_completed);
+		if (h_ok && v_ok) return;
+	}
+	
+	// Inversión de sentido: frenar ambos ejes y reaplicar el jog desde reposo
+	pending_stop = STOP_REQUEST_RETARGET;
+	decel_axis(&horizontal_axis);
+	decel_axis(&vertical_axis);
+}
+
+bool stepper_jog(int16_t h_velocity, int16_t v_velocity) {
+	if (step_queue_is_active()) return false;
+	
+	if (h_velocity == 0 && v_velocity == 0) {
+		// Velocidad cero: frenar con la deceleración configurada
+		if (!jog_active) return false;
+		jog_h_velocity = 0;
+		jog_v_velocity = 0;
+		stepper_decel_stop();
+		return true;
 	}
 	
-	if (movement_started) {
+	if (!jog_active) {
+		// Arranque del jog: cuenta como un movimiento nuevo
+		feed_hold_active = false;
+		memset(&move_limits, 0, sizeof(move_limits));
+		relative_h_counter = 0;
+		relative_v_counter = 0;
+		snapshot_count = 0;
+		jog_report_counter = 0;
+		
 		char msg[64];
-		snprintf(msg, sizeof(msg), "STEPPER_MOVE_STARTED:FROM=%ld,%ld,TO=%ld,%ld", 
-			horizontal_axis.current_position, vertical_axis.current_position, h_pos, v_pos);
-		uart_send_response(msg);
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_msg(&r, MSG_STEPPER_JOG_STARTED);
+		resp_char(&r, ':');
+		resp_int_pair(&r, horizontal_axis.current_position, vertical_axis.current_position);
+		resp_str_P(&r, PSTR(",VEL="));
+		resp_int_pair(&r, h_velocity, v_velocity);
+		event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
 	}
+	
+	jog_active = true;
+	jog_h_velocity = h_velocity;
+	jog_v_velocity = v_velocity;
+	jog_apply();
+	return true;
+}
+
+bool stepper_is_jogging(void) {
+	return jog_active;
+}
+
+void stepper_set_soft_limits(bool enabled, int32_t h_min, int32_t h_max, int32_t v_min, int32_t v_max) {
+	soft_limits_enabled = enabled;
+	soft_h_min = (h_min < h_max) ? h_min : h_max;
+	soft_h_max = (h_min < h_max) ? h_max : h_min;
+	soft_v_min = (v_min < v_max) ? v_min : v_max;
+	soft_v_max = (v_min < v_max) ? v_max : v_min;
 }
 
 void stepper_stop_silent(void) {
@@ -413,20 +1030,98 @@ void stepper_stop_silent(void) {
 	motion_profile_reset(&vertical_axis.profile);
 }
 
-void stepper_stop_all(void) {
-	// Calcular movimiento relativo antes de parar (para parada de emergencia)
-	bool was_moving = stepper_is_moving();
-	int32_t h_relative_mm = 0;
-	int32_t v_relative_mm = 0;
+void stepper_halt_from_isr(void) {
+	// Solo cortar los pulsos: estados, perfiles y reporte quedan para
+	// stepper_stop_all desde el loop principal
+	update_horizontal_speed(0);
+	update_vertical_speed(0);
+	halt_latched = true;
+}
+
+// Arrancar la reproducción de la cola en los ejes de axes_mask: el timer
+// de cada eje cuenta desde start_us con el reloj del sistema como
+// referencia (Timer1/3/4 comparten prescaler). Devuelve el retraso en us
+// si start_us ya había pasado
+uint32_t stepper_queue_begin(uint32_t start_us, uint8_t axes_mask) {
+	stepper_stop_silent();
+	pending_stop = STOP_REQUEST_NONE;
+	feed_hold_active = false;
+	jog_active = false;
 	
-	if (was_moving) {
-		h_relative_mm = relative_h_counter / STEPS_PER_MM_H;
-		v_relative_mm = relative_v_counter / STEPS_PER_MM_V;
+	// Sin fin de movimiento normal: la secuencia la cierra step_queue_update
+	relative_h_counter = 0;
+	relative_v_counter = 0;
+	snapshot_count = 0;
+	movement_completed_flag = false;
+	h_axis_completed = false;
+	v_axis_completed = false;
+	position_trigger_disarm(TRIGGER_AXIS_H);
+	position_trigger_disarm(TRIGGER_AXIS_V);
+	
+	bool use_h = (axes_mask & (1 << STEP_QUEUE_AXIS_H)) && queue_load(&h_run, &horizontal_axis, STEP_QUEUE_AXIS_H);
+	bool use_v = (axes_mask & (1 << STEP_QUEUE_AXIS_V)) && queue_load(&v_run, &vertical_axis, STEP_QUEUE_AXIS_V);
+	uint32_t late_us = 0;
+	
+	uint8_t sreg = SREG;
+	cli();
+	if (halt_latched) {
+		SREG = sreg;
+		return 0;
+	}
+	
+	// Ticks de 0.5us hasta el arranque (aritmética módulo 2^32 del reloj)
+	int32_t lead = (int32_t)((start_us << 1) - system_clock_ticks());
+	if (lead < (int32_t)STEP_QUEUE_PULSE_TICKS) {
+		late_us = (uint32_t)(STEP_QUEUE_PULSE_TICKS - lead) >> 1;
+		lead = STEP_QUEUE_PULSE_TICKS;
 	}
+	if (lead > 0xFFFF) lead = 0xFFFF;
+	
+	if (use_h) {
+		h_run.start_wait = true;
+		h_run.active = true;
+		h_step_state = false;
+		horizontal_axis.state = STEPPER_MOVING;
+		TCNT1 = 0;
+		OCR1A = (uint16_t)lead - 1;
+		TCCR1A = 0;
+		TCCR1B = (1 << WGM12) | (1 << CS11);
+		TIFR1 = (1 << OCF1A);
+		TIMSK1 |= (1 << OCIE1A);
+	}
+	if (use_v) {
+		v_run.start_wait = true;
+		v_run.active = true;
+		v_step_state = false;
+		vertical_axis.state = STEPPER_MOVING;
+		TCNT3 = 0;
+		OCR3A = (uint16_t)lead - 1;
+		TCCR3A = 0;
+		TCCR3B = (1 << WGM32) | (1 << CS31);
+		TIFR3 = (1 << OCF3A);
+		TIMSK3 |= (1 << OCIE3A);
+	}
+	SREG = sreg;
+	return late_us;
+}
+
+bool stepper_queue_running(void) {
+	return h_run.active || v_run.active;
+}
+
+void stepper_stop_all(void) {
+	// Estado previo a la parada (para el reporte de emergencia)
+	bool was_moving = stepper_is_moving();
 	
 	// Parar timers
 	update_horizontal_speed(0);
 	update_vertical_speed(0);
+	halt_latched = false;
+	
+	// La parada de emergencia cancela cualquier parada controlada, hold o jog
+	pending_stop = STOP_REQUEST_NONE;
+	feed_hold_active = false;
+	jog_active = false;
 	
 	// Resetear estados y perfiles
 	horizontal_axis.state = STEPPER_IDLE;
@@ -436,19 +1131,16 @@ void stepper_stop_all(void) {
 	
 	// Si estaba moviendose, reportar donde se detuvo y resetear contadores
 	if (was_moving) {
-		// Calcular distancia en mm con redondeo preciso
-		h_relative_mm = (relative_h_counter >= 0) ? 
-			(relative_h_counter + STEPS_PER_MM_H/2) / STEPS_PER_MM_H : 
-			(relative_h_counter - STEPS_PER_MM_H/2) / STEPS_PER_MM_H;
-		v_relative_mm = (relative_v_counter >= 0) ? 
-			(relative_v_counter + STEPS_PER_MM_V/2) / STEPS_PER_MM_V : 
-			(relative_v_counter - STEPS_PER_MM_V/2) / STEPS_PER_MM_V;
+		// Distancia recorrida en centésimas de mm
+		int32_t h_relative_centi = units_steps_to_centi(UNITS_AXIS_H, relative_h_counter);
+		int32_t v_relative_centi = units_steps_to_centi(UNITS_AXIS_V, relative_v_counter);
 			
-		char msg[128];
-		snprintf(msg, sizeof(msg), "STEPPER_EMERGENCY_STOP:%ld,%ld,REL:%ld,%ld,MM:%ld,%ld",
-		horizontal_axis.current_position, vertical_axis.current_position,
-		relative_h_counter, relative_v_counter, h_relative_mm, v_relative_mm);
-		uart_send_response(msg);
+		char msg[96];
+		response_t r;
+		resp_init(&r, msg, sizeof(msg));
+		resp_seq_take(&r, SEQ_MOTION);
+		stepper_format_motion_report(&r, MSG_STEPPER_EMERGENCY_STOP, h_relative_centi, v_relative_centi);
+		event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
 		
 		// Resetear contadores relativos después de reportar emergencia
 		relative_h_counter = 0;
@@ -471,37 +1163,119 @@ void stepper_set_position(int32_t h_pos, int32_t v_pos) {
 	vertical_axis.current_position = v_pos;
 }
 
+void stepper_send_snapshots(void) {
+	if (snapshot_count == 0) return;
+	
+	if (!event_log_enabled(LOG_CAT_MOTION, LOG_EVENT)) return;
+	
+	// Se emite por partes en lugar de armar la línea completa (hasta 16 snapshots)
+	char part[32];
+	response_t r;
+	resp_init(&r, part, sizeof(part));
+	resp_msg(&r, MSG_MOVEMENT_SNAPSHOTS);
+	resp_char(&r, ':');
+	uart_send_string(part);
+	for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
+		resp_init(&r, part, sizeof(part));
+		resp_char(&r, 'S');
+		resp_uint(&r, i + 1);
+		resp_char(&r, '=');
+		units_resp_mm_pair(&r, snapshots[i].h_centi, snapshots[i].v_centi);
+		resp_char(&r, ';');
+		uart_send_string(part);
+	}
+	uart_send_string("\r\n");
+}
+
 // Función para procesar completado de movimiento (FUERA DE ISR)
 static void process_movement_completed(void) {
 	if (!movement_completed_flag) return;
 	movement_completed_flag = false;
 	
-	// Calcular distancia en mm desde contadores relativos con mayor precisión
-	int32_t h_relative_mm = (relative_h_counter >= 0) ? 
-		(relative_h_counter + STEPS_PER_MM_H/2) / STEPS_PER_MM_H : 
-		(relative_h_counter - STEPS_PER_MM_H/2) / STEPS_PER_MM_H;
-	int32_t v_relative_mm = (relative_v_counter >= 0) ? 
-		(relative_v_counter + STEPS_PER_MM_V/2) / STEPS_PER_MM_V : 
-		(relative_v_counter - STEPS_PER_MM_V/2) / STEPS_PER_MM_V;
+	if (pending_stop == STOP_REQUEST_RETARGET) {
+		// Frenado por cambio de destino completado: seguir hacia el nuevo destino
+		h_axis_completed = false;
+		v_axis_completed = false;
+		if (jog_active) {
+			jog_apply();
+			} else {
+			start_movement(hold_h_target, hold_v_target, MOVE_CONTINUE);
+		}
+		return;
+	}
 	
-	char msg[128];
-	snprintf(msg, sizeof(msg), "STEPPER_MOVE_COMPLETED:%ld,%ld,REL:%ld,%ld,MM:%ld,%ld",
-		horizontal_axis.current_position, vertical_axis.current_position,
-		relative_h_counter, relative_v_counter, h_relative_mm, v_relative_mm);
-	uart_send_response(msg);
+	if (pending_stop == STOP_REQUEST_HOLD) {
+		// Feed-hold alcanzado: conservar contadores y snapshots para la reanudación
+		pending_stop = STOP_REQUEST_NONE;
+		feed_hold_active = true;
+		h_axis_completed = false;
+		v_axis_completed = false;
+		
+		char hold_msg[96];
+		response_t r;
+		resp_init(&r, hold_msg, sizeof(hold_msg));
+		resp_msg(&r, MSG_STEPPER_HOLD);
+		resp_char(&r, ':');
+		resp_int_pair(&r, horizontal_axis.current_position, vertical_axis.current_position);
+		resp_str_P(&r, PSTR(",REL:"));
+		resp_int_pair(&r, relative_h_counter, relative_v_counter);
+		resp_str_P(&r, PSTR(",TO="));
+		resp_int_pair(&r, hold_h_target, hold_v_target);
+		event_log_send_event_at(LOG_CAT_MOTION, LOG_EVENT, hold_msg, axis_completed_us);
+		return;
+	}
 	
-	// Enviar snapshots si los hay
-	if (snapshot_count > 0) {
-		char snapshot_msg[512];
-		int offset = snprintf(snapshot_msg, sizeof(snapshot_msg), "MOVEMENT_SNAPSHOTS:");
+	// Distancia recorrida en centésimas de mm desde los contadores relativos
+	int32_t h_relative_centi = units_steps_to_centi(UNITS_AXIS_H, relative_h_counter);
+	int32_t v_relative_centi = units_steps_to_centi(UNITS_AXIS_V, relative_v_counter);
+	
+	if (jog_active) {
+		// Fin del jog: por J:0,0, SD o al llegar al límite de software
+		jog_active = false;
+		pending_stop = STOP_REQUEST_NONE;
 		
-		for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
-			offset += snprintf(snapshot_msg + offset, sizeof(snapshot_msg) - offset,
-				"S%d=%ld,%ld;", i+1, snapshots[i].h_mm, snapshots[i].v_mm);
-		}
-		uart_send_response(snapshot_msg);
+		char jog_msg[96];
+		response_t r;
+		resp_init(&r, jog_msg, sizeof(jog_msg));
+		resp_seq_take(&r, SEQ_MOTION);
+		stepper_format_motion_report(&r, MSG_STEPPER_JOG_STOPPED, h_relative_centi, v_relative_centi);
+		event_log_send_event_at(LOG_CAT_MOTION, LOG_EVENT, jog_msg, axis_completed_us);
+		
+		relative_h_counter = 0;
+		relative_v_counter = 0;
+		h_axis_completed = false;
+		v_axis_completed = false;
+		return;
+	}
+	
+	if (pending_stop == STOP_REQUEST_DECEL) {
+		// Parada controlada: mismo formato que la de emergencia, sin pérdida de pasos
+		pending_stop = STOP_REQUEST_NONE;
+		
+		char stop_msg[96];
+		response_t r;
+		resp_init(&r, stop_msg, sizeof(stop_msg));
+		resp_seq_take(&r, SEQ_MOTION);
+		stepper_format_motion_report(&r, MSG_STEPPER_DECEL_STOP, h_relative_centi, v_relative_centi);
+		event_log_send_event_at(LOG_CAT_MOTION, LOG_EVENT, stop_msg, axis_completed_us);
+		
+		relative_h_counter = 0;
+		relative_v_counter = 0;
+		h_axis_completed = false;
+		v_axis_completed = false;
+		return;
 	}
 	
+	char msg[96];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_seq_take(&r, SEQ_MOTION);
+	stepper_format_motion_report(&r, MSG_STEPPER_MOVE_COMPLETED, h_relative_centi, v_relative_centi);
+	event_log_send_event_at(LOG_CAT_MOTION, LOG_EVENT, msg, axis_completed_us);
+	
+	// Enviar snapshots si los hay
+	stepper_send_snapshots();
+	
 	// Resetear contadores relativos después de reportar
 	relative_h_counter = 0;
 	relative_v_counter = 0;
@@ -517,11 +1291,32 @@ void stepper_update_profiles(void) {
 	// PRIMERO: Procesar completado de movimiento (fuera de ISR)
 	process_movement_completed();
 	
+	// Enviar eventos de disparo por posición encolados en las ISR
+	position_trigger_process_events();
+	
 	if (!update_speeds_flag) return;
 	update_speeds_flag = false;
 	
 	limit_switch_update();
 	
+	// Reporte periódico de posición durante el jog
+	if (jog_active && ++jog_report_counter >= JOG_REPORT_PERIOD_TICKS) {
+		jog_report_counter = 0;
+		char jog_msg[80];
+		response_t r;
+		resp_init(&r, jog_msg, sizeof(jog_msg));
+		resp_msg(&r, MSG_JOG_POS);
+		resp_str_P(&r, PSTR(":H="));
+		resp_int(&r, horizontal_axis.current_position);
+		resp_str_P(&r, PSTR(",V="));
+		resp_int(&r, vertical_axis.current_position);
+		resp_str_P(&r, PSTR(",VH="));
+		resp_uint(&r, horizontal_axis.current_speed);
+		resp_str_P(&r, PSTR(",VV="));
+		resp_uint(&r, vertical_axis.current_speed);
+		event_log_send(LOG_CAT_MOTION, LOG_EVENT, jog_msg);
+	}
+	
 	// Actualizar perfil horizontal si está en movimiento
 	if (motion_profile_is_active(&horizontal_axis.profile)) {
 		uint16_t new_speed = motion_profile_update(&horizontal_axis.profile,
@@ -588,14 +1383,18 @@ void stepper_update_profiles(void) {
 void stepper_start_calibration(void) {
 	calibration_mode = true;
 	calibration_step_counter = 0;
-	uart_send_response("CALIBRATION_STARTED");
+	message_send(MSG_CALIBRATION_STARTED);
 }
 
 void stepper_stop_calibration(void) {
 	calibration_mode = false;
 	
-	char report_msg[64];
-	snprintf(report_msg, sizeof(report_msg), "CALIBRATION_COMPLETED:%lu", (uint32_t)calibration_step_counter);
+	char report_msg[40];
+	response_t r;
+	resp_init(&r, report_msg, sizeof(report_msg));
+	resp_msg(&r, MSG_CALIBRATION_COMPLETED);
+	resp_char(&r, ':');
+	resp_uint(&r, calibration_step_counter);
 	uart_send_response(report_msg);
 	
 	calibration_step_counter = 0;
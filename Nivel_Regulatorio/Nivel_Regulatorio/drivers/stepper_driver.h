@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../moves/motion_profile.h"
+#include "../command/response_builder.h"
+#include "../command/message_catalog.h"
 
 // Estados del stepper
 typedef enum {
@@ -20,12 +22,23 @@ typedef struct {
 	uint16_t current_speed;
 	uint16_t max_speed;
 	uint16_t acceleration;
+	uint16_t move_speed;      // Velocidad nominal del movimiento actual (sin override)
 	bool direction;           // true = positivo, false = negativo
 	bool enabled;
 	stepper_state_t state;
 	motion_profile_t profile;
 } stepper_axis_t;
 
+// Velocidad (pasos/s) y aceleración (pasos/s²) propias de un movimiento;
+// 0 = la del eje (V: / preset). Se acotan a MAX_SPEED_* y ACCEL_* y a los
+// valores actuales del eje
+typedef struct {
+	uint16_t h_speed;
+	uint16_t v_speed;
+	uint16_t h_accel;
+	uint16_t v_accel;
+} move_limits_t;
+
 // Variables globales accesibles (para debugging)
 extern stepper_axis_t horizontal_axis;
 extern stepper_axis_t vertical_axis;
@@ -35,8 +48,8 @@ extern volatile int32_t relative_v_counter;
 // Sistema de snapshots de progreso
 #define MAX_SNAPSHOTS 30
 typedef struct {
-	int32_t h_mm;
-	int32_t v_mm;
+	int32_t h_centi;          // Centésimas de mm
+	int32_t v_centi;
 	int32_t h_steps;
 	int32_t v_steps;
 } progress_snapshot_t;
@@ -50,12 +63,28 @@ void stepper_enable_motors(bool h_enable, bool v_enable);
 void stepper_set_speed(uint16_t h_speed, uint16_t v_speed);
 void stepper_move_relative(int32_t h_steps, int32_t v_steps);
 void stepper_move_absolute(int32_t h_pos, int32_t v_pos);
+void stepper_move_relative_limited(int32_t h_steps, int32_t v_steps, const move_limits_t* limits);
+void stepper_move_absolute_limited(int32_t h_pos, int32_t v_pos, const move_limits_t* limits);
 void stepper_stop_all(void);
+void stepper_halt_from_isr(void);     // Parada rápida: corta Timer1/Timer3 (completar con stepper_stop_all)
 void stepper_stop_silent(void);
+bool stepper_decel_stop(void);      // Parada siguiendo la deceleración del perfil
+bool stepper_feed_hold(void);       // Frenar ambos ejes conservando el destino
+bool stepper_feed_resume(void);     // Reanudar hacia el destino guardado en el hold
+bool stepper_is_held(void);
+uint16_t stepper_set_feed_override(uint16_t percent);  // Devuelve el % aplicado (no afecta al jog)
+uint16_t stepper_get_feed_override(void);
+bool stepper_jog(int16_t h_velocity, int16_t v_velocity);   // pasos/s con signo; 0,0 = frenar
+bool stepper_is_jogging(void);
+uint32_t stepper_queue_begin(uint32_t start_us, uint8_t axes_mask);  // Ver step_queue.h; devuelve el retraso en us
+bool stepper_queue_running(void);
+void stepper_set_soft_limits(bool enabled, int32_t h_min, int32_t h_max, int32_t v_min, int32_t v_max);
 bool stepper_is_moving(void);
 void stepper_get_position(int32_t* h_pos, int32_t* v_pos);
 void stepper_set_position(int32_t h_pos, int32_t v_pos);
 void stepper_update_profiles(void);
+void stepper_send_snapshots(void);   // MOVEMENT_SNAPSHOTS del movimiento actual (si hay)
+const char* stepper_format_motion_report(response_t* r, msg_id_t id, int32_t h_centi, int32_t v_centi);
 static int32_t abs32(int32_t x);
 void stepper_stop_horizontal(void);
 void stepper_stop_vertical(void);
@@ -0,0 +1,97 @@
+#include "system_clock.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+
+// Parte alta del contador (overflows de 65536 cuentas = 32768us)
+static volatile uint32_t overflow_count = 0;
+
+// Milisegundos acumulados en los overflows (el resto en us se arrastra)
+static volatile uint32_t overflow_ms = 0;
+static volatile uint16_t overflow_rem_us = 0;
+
+ISR(TIMER4_OVF_vect) {
+	overflow_count++;
+	overflow_rem_us += 32768 % 1000;
+	overflow_ms += 32768 / 1000;
+	if (overflow_rem_us >= 1000) {
+		overflow_rem_us -= 1000;
+		overflow_ms++;
+	}
+}
+
+void system_clock_init(void) {
+	overflow_count = 0;
+	overflow_ms = 0;
+	overflow_rem_us = 0;
+	
+	// Timer4 es de 16 bits en ATmega2560; modo normal (TOP=0xFFFF)
+	TCCR4A = 0;
+	TCCR4B = (1 << CS41); // prescaler 8 -> 0.5us por cuenta
+	TCNT4 = 0;
+	OCR4A = SYSTEM_CLOCK_TICK_US * SYSTEM_CLOCK_COUNTS_PER_US;
+	TIFR4 = (1 << OCF4A) | (1 << TOV4);
+	TIMSK4 = (1 << OCIE4A) | (1 << TOIE4);
+}
+
+void system_clock_tick(void) {
+	// Compare móvil: el siguiente tick exactamente 5ms después (suma módulo 2^16)
+	OCR4A += (uint16_t)(SYSTEM_CLOCK_TICK_US * SYSTEM_CLOCK_COUNTS_PER_US);
+}
+
+// Lectura atómica de la parte alta y el contador, corrigiendo un overflow pendiente
+static void read_counter(uint32_t* high, uint16_t* count) {
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t ovf = overflow_count;
+	uint16_t cnt = TCNT4;
+	if ((TIFR4 & (1 << TOV4)) && cnt < 0x8000) {
+		// Overflow ocurrido con interrupciones deshabilitadas y aún no atendido
+		ovf++;
+	}
+	SREG = sreg;
+	*high = ovf;
+	*count = cnt;
+}
+
+uint32_t system_clock_ticks(void) {
+	uint32_t high;
+	uint16_t count;
+	read_counter(&high, &count);
+	return (high << 16) | count;
+}
+
+uint32_t system_clock_micros(void) {
+	uint32_t high;
+	uint16_t count;
+	read_counter(&high, &count);
+	// (high * 65536 + count) / 2 sin pasar por 64 bits
+	return (high << 15) + (count >> 1);
+}
+
+uint32_t system_clock_millis(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t ms = overflow_ms;
+	uint16_t rem_us = overflow_rem_us;
+	uint16_t count = TCNT4;
+	if ((TIFR4 & (1 << TOV4)) && count < 0x8000) {
+		rem_us += 32768 % 1000;
+		ms += 32768 / 1000;
+	}
+	SREG = sreg;
+	
+	// rem_us < 2000 y count/2 < 32768: cabe en 16 bits
+	return ms + (uint16_t)(rem_us + (count >> 1)) / 1000;
+}
+
+bool system_clock_elapsed(uint32_t* last_us, uint32_t period_us) {
+	uint32_t now = system_clock_micros();
+	if ((uint32_t)(now - *last_us) < period_us) return false;
+	*last_us += period_us;
+	// Si se perdieron varios periodos, no intentar recuperarlos en ráfaga
+	if ((uint32_t)(now - *last_us) >= period_us) {
+		*last_us = now;
+	}
+	return true;
+}
@@ -0,0 +1,31 @@
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Base de tiempo única del firmware: Timer4 libre (modo normal, prescaler 8)
+// a 0.5us por cuenta, extendido a 32 bits con la interrupción de overflow.
+// El compare A del mismo timer genera el tick de control de 200Hz.
+
+#define SYSTEM_CLOCK_TICK_HZ        200
+#define SYSTEM_CLOCK_TICK_US        (1000000UL / SYSTEM_CLOCK_TICK_HZ)
+#define SYSTEM_CLOCK_COUNTS_PER_US  2       // 16MHz / 8
+
+// Configura Timer4 (debe llamarse antes que el resto de drivers)
+void system_clock_init(void);
+
+// Llamar desde la ISR de TIMER4_COMPA_vect: programa el siguiente tick de control
+void system_clock_tick(void);
+
+// Cuentas de 0.5us (vuelta cada ~35.8 min); comparar siempre por diferencia
+uint32_t system_clock_ticks(void);
+
+// Tiempo desde el arranque (vuelta en 2^32); seguros dentro y fuera de ISRs
+uint32_t system_clock_micros(void);
+uint32_t system_clock_millis(void);
+
+// true cuando han pasado period_us desde *last_us; avanza *last_us sin acumular deriva
+bool system_clock_elapsed(uint32_t* last_us, uint32_t period_us);
+
+#endif // SYSTEM_CLOCK_H
@@ -1,16 +1,52 @@
 #include "uart_driver.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <stdio.h>
 #include <string.h>
 #include "../config/system_config.h"
 #include "../config/command_protocol.h"
 #include "../drivers/gripper_driver.h"
+#include "../drivers/stepper_driver.h"
+#include "../moves/macro_engine.h"
+#include "../command/gcode_interpreter.h"
+#include "system_clock.h"
+#include "step_queue.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include <avr/pgmspace.h>
 
 static void (*command_ready_callback)(void) = NULL;
-static char command_buffer[UART_BUFFER_SIZE];
+
+// Anillo de frames: la ISR escribe en rx_head mientras el loop principal
+// ejecuta rx_tail, as la recepcin del comando k+1 se solapa con la
+// ejecucin del k. Un slot encolado no se vuelve a escribir hasta que
+// uart_process_commands lo libera.
+static char frame_slots[UART_FRAME_SLOTS][UART_BUFFER_SIZE];
+static uint32_t frame_rx_us[UART_FRAME_SLOTS];   // Instante de recepcin del '>' de cada frame
+
+// Recepcin en curso: frame <...> o lnea suelta terminada en '\n'
+typedef enum {
+	RX_IDLE,
+	RX_FRAME,
+	RX_LINE
+} rx_mode_t;
+
+static rx_mode_t rx_mode = RX_IDLE;
+static uint8_t rx_head = 0;
+static uint8_t rx_tail = 0;
+static volatile uint8_t rx_count = 0;
 static uint8_t cmd_index = 0;
-static bool cmd_started = false;
+static bool frame_is_line[UART_FRAME_SLOTS];      // Recibido como lnea G-code (sin '<' '>')
+static bool cmd_discard = false;                  // Frame en curso sin slot libre
+static uint32_t current_frame_us = 0;            // frame_rx_us del frame en ejecucin
+static volatile uart_rx_stats_t rx_stats;
+static volatile bool fast_stop_pending = false;  // Parada rpida a completar en el loop
+static uint8_t frames_after_stop = 0;            // Encolados despus del byte de parada
+
+// Salida retenida: mientras arrancan los subcomandos de un batch los mensajes
+// se acumulan aqu en vez de bloquear entre un arranque y el siguiente
+static char tx_defer_buf[UART_TX_DEFER_SIZE];
+static uint8_t tx_defer_len = 0;
+static bool tx_deferred = false;
 
 void uart_init(uint32_t baud_rate) {
 	uint16_t ubrr_value;
@@ -30,27 +66,58 @@ void uart_init(uint32_t baud_rate) {
 	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 	
 	cmd_index = 0;
-	cmd_started = false;
+	rx_mode = RX_IDLE;
+	cmd_discard = false;
 	
 	while (UCSR0A & (1 << RXC0)) {
 		volatile uint8_t dummy = UDR0;
 		(void)dummy;
 	}
 	
-	uart_send_response("SYSTEM_INITIALIZED");
-	uart_send_system_status();
+	event_log_send_msg(LOG_CAT_SYSTEM, LOG_DEBUG, MSG_SYSTEM_INITIALIZED);
+	if (event_log_enabled(LOG_CAT_SYSTEM, LOG_EVENT)) {
+		uart_send_system_status();
+	}
 }
 
 void uart_set_command_callback(void (*callback)(void)) {
 	command_ready_callback = callback;
 }
 
-void uart_send_char(char c) {
+static void send_char_now(char c) {
 	// Esperar a que el buffer est vaco
 	while (!(UCSR0A & (1 << UDRE0)));
 	UDR0 = c;
 }
 
+static void flush_deferred(void) {
+	for (uint8_t i = 0; i < tx_defer_len; i++) {
+		send_char_now(tx_defer_buf[i]);
+	}
+	tx_defer_len = 0;
+}
+
+void uart_send_char(char c) {
+	if (tx_deferred) {
+		// Buffer lleno: vaciarlo y seguir reteniendo
+		if (tx_defer_len >= UART_TX_DEFER_SIZE) {
+			flush_deferred();
+		}
+		tx_defer_buf[tx_defer_len++] = c;
+		return;
+	}
+	send_char_now(c);
+}
+
+void uart_begin_deferred(void) {
+	tx_deferred = true;
+}
+
+void uart_end_deferred(void) {
+	tx_deferred = false;
+	flush_deferred();
+}
+
 void uart_send_string(const char* str) {
 	while (*str) {
 		uart_send_char(*str++);
@@ -62,42 +129,166 @@ void uart_send_response(const char* response) {
 	uart_send_string("\r\n");
 }
 
-bool uart_get_command(char* dest, uint8_t max_len) {
-	// En esta implementacin, el comando ya est en command_buffer
-	// cuando se llama el callback
-	strncpy(dest, command_buffer, max_len - 1);
-	dest[max_len - 1] = '\0';
-	return true;
+void uart_send_event_at(const char* event, uint32_t timestamp_us) {
+	// Sufijo de tiempo: ",T=us" o ":T=us" si el evento no tiene payload
+	char stamp[16];
+	response_t r;
+	resp_init(&r, stamp, sizeof(stamp));
+	resp_char(&r, strchr(event, ':') ? ',' : ':');
+	resp_str_P(&r, PSTR("T="));
+	resp_uint(&r, timestamp_us);
+	uart_send_string(event);
+	uart_send_string(stamp);
+	uart_send_string("\r\n");
 }
 
-ISR(USART0_RX_vect) {
-	char received = UDR0;
+void uart_send_event(const char* event) {
+	uart_send_event_at(event, system_clock_micros());
+}
+
+uint32_t uart_get_frame_timestamp(void) {
+	return current_frame_us;
+}
+
+bool uart_command_is_line(void) {
+	return frame_is_line[rx_tail];
+}
+
+const char* uart_get_command(void) {
+	// Frame en ejecucin: vlido mientras dura el callback
+	return frame_slots[rx_tail];
+}
+
+// Completa la parada rpida cortada en la ISR: los frames recibidos antes
+// del byte y todava sin ejecutar se descartan, y se informa como un S normal
+static void service_fast_stop(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint8_t stale = rx_count - frames_after_stop;
+	rx_tail = (rx_tail + stale) & (UART_FRAME_SLOTS - 1);
+	rx_count = frames_after_stop;
+	rx_stats.dropped += stale;
+	fast_stop_pending = false;
+	SREG = sreg;
 	
-	if (received == '<') {
-		cmd_started = true;
-		cmd_index = 0;
-	}
-	else if (received == '>' && cmd_started) {
-		// Comando completo - procesar inmediatamente
-		command_buffer[cmd_index] = '\0';
-		cmd_started = false;
-		
-		// Llamar callback directamente desde ISR (ser rpido)
+	macro_abort();
+	gcode_abort();
+	step_queue_clear();
+	stepper_stop_all();
+	message_send(MSG_OK_STOP);
+}
+
+void uart_process_commands(void) {
+	// Tambin entre frames: una parada recibida mientras se ejecutaba uno
+	// descarta los siguientes
+	while (fast_stop_pending || rx_count > 0) {
+		if (fast_stop_pending) {
+			service_fast_stop();
+			continue;
+		}
+		current_frame_us = frame_rx_us[rx_tail];
 		if (command_ready_callback) {
 			command_ready_callback();
 		}
+		
+		// Liberar el slot recin despus de ejecutarlo
+		rx_tail = (rx_tail + 1) & (UART_FRAME_SLOTS - 1);
+		uint8_t sreg = SREG;
+		cli();
+		rx_count--;
+		SREG = sreg;
 	}
-	else if (cmd_started && cmd_index < UART_BUFFER_SIZE - 1) {
-		// Solo agregar caracteres vlidos (no \n, \r)
-		if (received != '\n' && received != '\r') {
-			command_buffer[cmd_index++] = received;
-		}
+}
+
+void uart_get_rx_stats(uart_rx_stats_t* stats) {
+	uint8_t sreg = SREG;
+	cli();
+	stats->frames = rx_stats.frames;
+	stats->dropped = rx_stats.dropped;
+	stats->overflows = rx_stats.overflows;
+	stats->hw_overruns = rx_stats.hw_overruns;
+	stats->fast_stops = rx_stats.fast_stops;
+	stats->pending = rx_count;
+	stats->max_pending = rx_stats.max_pending;
+	SREG = sreg;
+}
+
+// Cierra el frame o lnea en curso y lo encola para el loop principal
+static inline void end_frame(bool is_line) {
+	rx_mode = RX_IDLE;
+	if (cmd_discard) {
+		rx_stats.dropped++;
+		return;
 	}
-	
-	// Si hay overflow, resetear
+	frame_rx_us[rx_head] = system_clock_micros();
+	frame_is_line[rx_head] = is_line;
+	frame_slots[rx_head][cmd_index] = '\0';
+	rx_head = (rx_head + 1) & (UART_FRAME_SLOTS - 1);
+	rx_count++;
+	rx_stats.frames++;
+	if (fast_stop_pending) {
+		frames_after_stop++;
+	}
+	if (rx_count > rx_stats.max_pending) {
+		rx_stats.max_pending = rx_count;
+	}
+}
+
+static inline void begin_frame(rx_mode_t mode) {
+	rx_mode = mode;
+	cmd_index = 0;
+	// Sin slot libre el frame se recibe igual pero se descarta al cerrarse
+	cmd_discard = (rx_count >= UART_FRAME_SLOTS);
+}
+
+static inline void store_byte(char c) {
 	if (cmd_index >= UART_BUFFER_SIZE - 1) {
-		cmd_started = false;
-		cmd_index = 0;
+		// Frame ms largo que el slot: se descarta completo
+		rx_mode = RX_IDLE;
+		rx_stats.overflows++;
+	} else if (!cmd_discard) {
+		frame_slots[rx_head][cmd_index++] = c;
+	}
+}
+
+ISR(USART0_RX_vect) {
+	// DOR0 se lee antes que UDR0: bytes perdidos porque la ISR no lleg a tiempo
+	if (UCSR0A & (1 << DOR0)) {
+		rx_stats.hw_overruns++;
+	}
+	char received = UDR0;
+	bool end_of_line = (received == '\n' || received == '\r');
+	
+	if (received == UART_ESTOP_BYTE) {
+		// Primero los pulsos; el frame a medio recibir se abandona
+		stepper_halt_from_isr();
+		rx_mode = RX_IDLE;
+		fast_stop_pending = true;
+		frames_after_stop = 0;
+		rx_stats.fast_stops++;
+	}
+	else if (received == '<') {
+		// Tambin abandona una lnea G-code incompleta
+		begin_frame(RX_FRAME);
+	}
+	else if (rx_mode == RX_FRAME) {
+		if (received == '>') {
+			end_frame(false);
+		} else if (!end_of_line) {
+			store_byte(received);
+		}
+	}
+	else if (rx_mode == RX_LINE) {
+		if (end_of_line) {
+			end_frame(true);
+		} else {
+			store_byte(received);
+		}
+	}
+	else if (!end_of_line && received != ' ') {
+		// Fuera de un frame: lnea G-code terminada en '\n'
+		begin_frame(RX_LINE);
+		store_byte(received);
 	}
 }
 
@@ -110,20 +301,19 @@ void uart_send_system_status(void) {
 	gripper_state_t gripper_state = gripper_get_state();
 	int16_t gripper_pos = gripper_get_position();
 	
-	const char* gripper_str;
-	switch(gripper_state) {
-		case GRIPPER_OPEN: gripper_str = "OPEN"; break;
-		case GRIPPER_CLOSED: gripper_str = "CLOSED"; break;
-		case GRIPPER_OPENING: gripper_str = "OPENING"; break;
-		case GRIPPER_CLOSING: gripper_str = "CLOSING"; break;
-		default: gripper_str = "IDLE"; break;
-	}
-	
 	// Enviar estado completo
-	char status_msg[128];
-	snprintf(status_msg, sizeof(status_msg),
-	"SYSTEM_STATUS:SERVO1=%d,SERVO2=%d,GRIPPER=%s,GRIPPER_POS=%d",
-	servo1_pos, servo2_pos, gripper_str, gripper_pos);
+	char status_msg[80];
+	response_t r;
+	resp_init(&r, status_msg, sizeof(status_msg));
+	resp_msg(&r, MSG_SYSTEM_STATUS);
+	resp_str_P(&r, PSTR(":SERVO1="));
+	resp_uint(&r, servo1_pos);
+	resp_str_P(&r, PSTR(",SERVO2="));
+	resp_uint(&r, servo2_pos);
+	resp_str_P(&r, PSTR(",GRIPPER="));
+	resp_str_P(&r, gripper_state_name(gripper_state));
+	resp_str_P(&r, PSTR(",GRIPPER_POS="));
+	resp_int(&r, gripper_pos);
 	
 	uart_send_response(status_msg);
 }
\ No newline at end of file
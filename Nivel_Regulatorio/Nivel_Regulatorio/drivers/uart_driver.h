@@ -4,13 +4,32 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Contadores de recepcin (RX?)
+typedef struct {
+	uint32_t frames;        // Frames completos encolados
+	uint16_t dropped;       // Descartados por no haber slot libre
+	uint16_t overflows;     // Descartados por superar UART_BUFFER_SIZE
+	uint16_t hw_overruns;   // Bytes perdidos en el hardware (DOR0)
+	uint16_t fast_stops;    // Paradas rpidas (UART_ESTOP_BYTE) recibidas
+	uint8_t pending;        // Frames en espera ahora
+	uint8_t max_pending;    // Mximo de frames en espera observado
+} uart_rx_stats_t;
+
 // Funciones principales
 void uart_init(uint32_t baud_rate);
 void uart_set_command_callback(void (*callback)(void));
+void uart_process_commands(void);                                     // Loop principal: ejecuta los frames recibidos
 void uart_send_char(char c);
+void uart_begin_deferred(void);                                       // Retener la salida (batch)...
+void uart_end_deferred(void);                                         // ...y enviarla
 void uart_send_string(const char* str);
 void uart_send_response(const char* response);
-bool uart_get_command(char* dest, uint8_t max_len);
+void uart_send_event(const char* event);                              // Con sufijo T=us (reloj del sistema)
+void uart_send_event_at(const char* event, uint32_t timestamp_us);    // Con instante capturado antes
+uint32_t uart_get_frame_timestamp(void);                              // Recepcin del frame en ejecucin (us)
+const char* uart_get_command(void);                                  // Frame recibido (vlido durante el callback)
+bool uart_command_is_line(void);                                      // El frame lleg como lnea G-code
 void uart_send_system_status(void);
+void uart_get_rx_stats(uart_rx_stats_t* stats);
 
 #endif
\ No newline at end of file
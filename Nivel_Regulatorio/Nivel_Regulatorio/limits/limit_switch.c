@@ -2,13 +2,18 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "../drivers/stepper_driver.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/system_clock.h"
+#include "../config/parameters.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include <avr/pgmspace.h>
 
 static limit_status_t limits = {false, false, false, false};
-// Contador para reporte periódico del estado de límites (se incrementa en cada update)
-static uint16_t limit_status_counter = 0;
-// Periodicidad del reporte en ticks de limit_switch_update(); ajustar según frecuencia de llamada
-// Por ejemplo, si limit_switch_update() se llama cada ~10ms, 100 -> ~1s
-#define LIMIT_STATUS_PERIOD_TICKS 100
+// Instante del último reporte periódico del estado de límites (reloj del sistema)
+static uint32_t limit_status_last_us = 0;
+// Periodicidad del reporte, independiente de la frecuencia de llamada de limit_switch_update()
+#define LIMIT_STATUS_PERIOD_US 500000UL
 // Heartbeat habilitado por el supervisor (para evitar spam cuando no hay conexión)
 static uint8_t limit_status_heartbeat_enabled = 0;
 
@@ -17,6 +22,20 @@ void limit_switch_set_heartbeat(uint8_t enabled) {
     limit_status_heartbeat_enabled = enabled ? 1 : 0;
 }
 
+static void report_position_at_limit(void) {
+	if (!event_log_enabled(LOG_CAT_LIMIT, LOG_DEBUG)) return;
+	
+	char pos_msg[64];
+	response_t r;
+	resp_init(&r, pos_msg, sizeof(pos_msg));
+	resp_msg(&r, MSG_POSITION_AT_LIMIT);
+	resp_str_P(&r, PSTR(":H="));
+	resp_int(&r, horizontal_axis.current_position);
+	resp_str_P(&r, PSTR(",V="));
+	resp_int(&r, vertical_axis.current_position);
+	uart_send_event(pos_msg);
+}
+
 void limit_switch_init(void) {
 	// Configurar pines como entradas con pull-up interno
 	// Pins 30-33 est�n en PORTC bits 7-4
@@ -36,21 +55,18 @@ void limit_switch_update(void) {
 	
 	// Actualizar estados con debounce simple
 	static uint8_t debounce_counter[4] = {0, 0, 0, 0};
-	const uint8_t DEBOUNCE_THRESHOLD = 6;
+	const uint8_t debounce_threshold = (uint8_t)param_get(PARAM_DEBOUNCE);
 	
 	// H Left (Pin 30 - PC7)
 	if (!(pinc_state & (1 << 7))) {
-		if (debounce_counter[0] < DEBOUNCE_THRESHOLD) {
+		if (debounce_counter[0] < debounce_threshold) {
 			debounce_counter[0]++;
-			if (debounce_counter[0] == DEBOUNCE_THRESHOLD) {
+			if (debounce_counter[0] == debounce_threshold) {
 				limits.h_left_triggered = true;
 				
 				// Reportar posici�n cuando toca l�mite
-				char pos_msg[64];
-				snprintf(pos_msg, sizeof(pos_msg), "POSITION_AT_LIMIT:H=%ld,V=%ld",
-				horizontal_axis.current_position, vertical_axis.current_position);
-				uart_send_response(pos_msg);
-				uart_send_response("LIMIT_H_LEFT_TRIGGERED");
+				report_position_at_limit();
+				event_log_send_event_msg(LOG_CAT_LIMIT, LOG_EVENT, MSG_LIMIT_H_LEFT_TRIGGERED);
 				
 				// Terminar calibraci�n autom�ticamente
 				stepper_stop_calibration();
@@ -58,15 +74,8 @@ void limit_switch_update(void) {
                 if (horizontal_axis.state == STEPPER_MOVING && horizontal_axis.direction) {  // true = izquierda (AJUSTADO)
                     // ENVIAR SNAPSHOTS ANTES DE PARAR (si los hay)
                     extern uint8_t snapshot_count;
-                    extern progress_snapshot_t snapshots[];
                     if (snapshot_count > 0) {
-                        char snapshot_msg[512];
-                        int offset = snprintf(snapshot_msg, sizeof(snapshot_msg), "MOVEMENT_SNAPSHOTS:");
-                        for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
-                            offset += snprintf(snapshot_msg + offset, sizeof(snapshot_msg) - offset,
-                                               "S%d=%ld,%ld;", i+1, snapshots[i].h_mm, snapshots[i].v_mm);
-                        }
-                        uart_send_response(snapshot_msg);
+                        stepper_send_snapshots();
                         // Resetear snapshots después de enviar
                         snapshot_count = 0;
                     }
@@ -81,17 +90,14 @@ void limit_switch_update(void) {
 	
 	// H Right (Pin 31 - PC6)
 	if (!(pinc_state & (1 << 6))) {
-		if (debounce_counter[1] < DEBOUNCE_THRESHOLD) {
+		if (debounce_counter[1] < debounce_threshold) {
 			debounce_counter[1]++;
-			if (debounce_counter[1] == DEBOUNCE_THRESHOLD) {
+			if (debounce_counter[1] == debounce_threshold) {
 				limits.h_right_triggered = true;
 				
 				// Reportar posici�n cuando toca l�mite
-				char pos_msg[64];
-				snprintf(pos_msg, sizeof(pos_msg), "POSITION_AT_LIMIT:H=%ld,V=%ld",
-				horizontal_axis.current_position, vertical_axis.current_position);
-				uart_send_response(pos_msg);
-				uart_send_response("LIMIT_H_RIGHT_TRIGGERED");
+				report_position_at_limit();
+				event_log_send_event_msg(LOG_CAT_LIMIT, LOG_EVENT, MSG_LIMIT_H_RIGHT_TRIGGERED);
 				
 				// Terminar calibraci�n autom�ticamente
 				stepper_stop_calibration();
@@ -99,15 +105,8 @@ void limit_switch_update(void) {
                 if (horizontal_axis.state == STEPPER_MOVING && !horizontal_axis.direction) {  // false = derecha (AJUSTADO)
                     // ENVIAR SNAPSHOTS ANTES DE PARAR (si los hay)
                     extern uint8_t snapshot_count;
-                    extern progress_snapshot_t snapshots[];
                     if (snapshot_count > 0) {
-                        char snapshot_msg[256];
-                        int offset = snprintf(snapshot_msg, sizeof(snapshot_msg), "MOVEMENT_SNAPSHOTS:");
-                        for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
-                            offset += snprintf(snapshot_msg + offset, sizeof(snapshot_msg) - offset,
-                                               "S%d=%ld,%ld;", i+1, snapshots[i].h_mm, snapshots[i].v_mm);
-                        }
-                        uart_send_response(snapshot_msg);
+                        stepper_send_snapshots();
                         // Resetear snapshots despu�s de enviar
                         snapshot_count = 0;
                     }
@@ -122,17 +121,14 @@ void limit_switch_update(void) {
 	
 	// V Down (Pin 32 - PC5)
 	if (!(pinc_state & (1 << 5))) {
-		if (debounce_counter[2] < DEBOUNCE_THRESHOLD) {
+		if (debounce_counter[2] < debounce_threshold) {
 			debounce_counter[2]++;
-			if (debounce_counter[2] == DEBOUNCE_THRESHOLD) {
+			if (debounce_counter[2] == debounce_threshold) {
 				limits.v_down_triggered = true;
 				
 				// Reportar posici�n cuando toca l�mite
-				char pos_msg[64];
-				snprintf(pos_msg, sizeof(pos_msg), "POSITION_AT_LIMIT:H=%ld,V=%ld",
-				horizontal_axis.current_position, vertical_axis.current_position);
-				uart_send_response(pos_msg);
-				uart_send_response("LIMIT_V_DOWN_TRIGGERED");
+				report_position_at_limit();
+				event_log_send_event_msg(LOG_CAT_LIMIT, LOG_EVENT, MSG_LIMIT_V_DOWN_TRIGGERED);
 				
 				// Terminar calibraci�n autom�ticamente
 				stepper_stop_calibration();
@@ -140,15 +136,8 @@ void limit_switch_update(void) {
                 if (vertical_axis.state == STEPPER_MOVING && vertical_axis.direction) {
                     // ENVIAR SNAPSHOTS ANTES DE PARAR (si los hay)
                     extern uint8_t snapshot_count;
-                    extern progress_snapshot_t snapshots[];
                     if (snapshot_count > 0) {
-                        char snapshot_msg[256];
-                        int offset = snprintf(snapshot_msg, sizeof(snapshot_msg), "MOVEMENT_SNAPSHOTS:");
-                        for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
-                            offset += snprintf(snapshot_msg + offset, sizeof(snapshot_msg) - offset,
-                                               "S%d=%ld,%ld;", i+1, snapshots[i].h_mm, snapshots[i].v_mm);
-                        }
-                        uart_send_response(snapshot_msg);
+                        stepper_send_snapshots();
                         // Resetear snapshots después de enviar
                         snapshot_count = 0;
                     }
@@ -163,17 +152,14 @@ void limit_switch_update(void) {
 	
 	// V Up (Pin 33 - PC4)
 	if (!(pinc_state & (1 << 4))) {
-		if (debounce_counter[3] < DEBOUNCE_THRESHOLD) {
+		if (debounce_counter[3] < debounce_threshold) {
 			debounce_counter[3]++;
-			if (debounce_counter[3] == DEBOUNCE_THRESHOLD) {
+			if (debounce_counter[3] == debounce_threshold) {
 				limits.v_up_triggered = true;
 				
 				// Reportar posici�n cuando toca l�mite
-				char pos_msg[64];
-				snprintf(pos_msg, sizeof(pos_msg), "POSITION_AT_LIMIT:H=%ld,V=%ld",
-				horizontal_axis.current_position, vertical_axis.current_position);
-				uart_send_response(pos_msg);
-				uart_send_response("LIMIT_V_UP_TRIGGERED");
+				report_position_at_limit();
+				event_log_send_event_msg(LOG_CAT_LIMIT, LOG_EVENT, MSG_LIMIT_V_UP_TRIGGERED);
 				
 				// Terminar calibraci�n autom�ticamente
 				stepper_stop_calibration();
@@ -181,15 +167,8 @@ void limit_switch_update(void) {
                 if (vertical_axis.state == STEPPER_MOVING && !vertical_axis.direction) {
                     // ENVIAR SNAPSHOTS ANTES DE PARAR (si los hay)
                     extern uint8_t snapshot_count;
-                    extern progress_snapshot_t snapshots[];
                     if (snapshot_count > 0) {
-                        char snapshot_msg[256];
-                        int offset = snprintf(snapshot_msg, sizeof(snapshot_msg), "MOVEMENT_SNAPSHOTS:");
-                        for (uint8_t i = 0; i < snapshot_count && i < MAX_SNAPSHOTS; i++) {
-                            offset += snprintf(snapshot_msg + offset, sizeof(snapshot_msg) - offset,
-                                               "S%d=%ld,%ld;", i+1, snapshots[i].h_mm, snapshots[i].v_mm);
-                        }
-                        uart_send_response(snapshot_msg);
+                        stepper_send_snapshots();
                         // Resetear snapshots despu�s de enviar
                         snapshot_count = 0;
                     }
@@ -206,18 +185,21 @@ void limit_switch_update(void) {
     // Esto asegura que el supervisor conozca el estado actual aunque se haya perdido el evento de borde
     // Solo enviar si el supervisor habilitó el heartbeat (para no saturar cuando no hay conexión)
     if (limit_status_heartbeat_enabled) {
-        limit_status_counter++;
-        if (limit_status_counter >= LIMIT_STATUS_PERIOD_TICKS) {
-            limit_status_counter = 0;
+        if (system_clock_elapsed(&limit_status_last_us, LIMIT_STATUS_PERIOD_US)) {
             if (limits.h_left_triggered || limits.h_right_triggered || limits.v_up_triggered || limits.v_down_triggered) {
                 char status_msg[64];
                 // Usar claves claras para el supervisor
-                snprintf(status_msg, sizeof(status_msg),
-                         "LIMIT_STATUS:H_LEFT=%d,H_RIGHT=%d,V_UP=%d,V_DOWN=%d",
-                         limits.h_left_triggered ? 1 : 0,
-                         limits.h_right_triggered ? 1 : 0,
-                         limits.v_up_triggered ? 1 : 0,
-                         limits.v_down_triggered ? 1 : 0);
+                response_t r;
+                resp_init(&r, status_msg, sizeof(status_msg));
+                resp_msg(&r, MSG_LIMIT_STATUS);
+                resp_str_P(&r, PSTR(":H_LEFT="));
+                resp_char(&r, limits.h_left_triggered ? '1' : '0');
+                resp_str_P(&r, PSTR(",H_RIGHT="));
+                resp_char(&r, limits.h_right_triggered ? '1' : '0');
+                resp_str_P(&r, PSTR(",V_UP="));
+                resp_char(&r, limits.v_up_triggered ? '1' : '0');
+                resp_str_P(&r, PSTR(",V_DOWN="));
+                resp_char(&r, limits.v_down_triggered ? '1' : '0');
                 uart_send_response(status_msg);
             }
         }
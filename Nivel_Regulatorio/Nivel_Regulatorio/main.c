@@ -2,23 +2,44 @@
 #include "command/command_parser.h"
 #include "config/system_config.h"
 #include "config/command_protocol.h"
+#include "config/parameters.h"
 #include "drivers/stepper_driver.h"
 #include "drivers/servo_driver.h"
 #include "drivers/gripper_driver.h"
+#include "drivers/system_clock.h"
+#include "drivers/step_queue.h"
+#include "moves/position_correction.h"
+#include "moves/macro_engine.h"
+#include "moves/motion_preset.h"
+#include "command/telemetry.h"
+#include "command/event_log.h"
+#include "command/format_benchmark.h"
+#include "command/gcode_interpreter.h"
 
 #include <avr/interrupt.h>
 
 static void on_uart_command_ready(void) {
-	char cmd[UART_BUFFER_SIZE];
-	if (uart_get_command(cmd, sizeof(cmd))) {
-		uart_parse_command(cmd);
+	// Se parsea directamente sobre el slot de recepcin (sin copia)
+	if (uart_command_is_line()) {
+		gcode_execute_line(uart_get_command());
+	} else {
+		uart_parse_command(uart_get_command());
 	}
 }
 
 int main(void) {
+	// Reloj del sistema (Timer4): base de tiempo de todos los mdulos
+	system_clock_init();
+	
+	// Niveles de verbosidad antes de que cualquier driver enve mensajes
+	event_log_init();
+	
 	// Inicializar UART
 	uart_init(UART_BAUD_RATE);
 	
+	// Parmetros guardados (EEPROM) antes de los drivers que los leen
+	param_init();
+	
 	// Inicializar steppers (incluye motion profile)
 	stepper_init();
 	
@@ -28,6 +49,12 @@ int main(void) {
 	// Inicializar gripper
 	gripper_init();
 	
+	// Preset de movimiento vaco (ajusta ejes, servos y gripper)
+	motion_preset_init();
+	
+	// Telemetra binaria (sin suscripciones al arrancar)
+	telemetry_init();
+	
 	// Configurar callback de comandos
 	uart_set_command_callback(on_uart_command_ready);
 	
@@ -35,17 +62,44 @@ int main(void) {
 	sei();
 	
 	// Notificar que el sistema est listo
-	uart_send_response("SYSTEM_READY");
+	event_log_send_msg(LOG_CAT_SYSTEM, LOG_EVENT, MSG_SYSTEM_READY);
 	
 	// Loop principal
 	while (1) {
+		// Comandos recibidos (la ISR sigue llenando el siguiente slot)
+		uart_process_commands();
+		
 		// Actualizar perfiles de velocidad
 		stepper_update_profiles();
+		
+		// Cola de pasos del host: arranque programado y underruns
+		step_queue_update();
+		
+		// Lazo de correccin guiado por visin (si est activo)
+		position_correction_update();
+		
+		// Programa de macro en curso (despus de los comandos: MX/S lo cortan antes)
+		macro_update();
+		
+		// Bloques G-code encolados
+		gcode_update();
 	
 		// Actualizar servos
 		servo_update();
 	
 		// Actualizar gripper
 		gripper_update();
+		
+		// Preset segn el gripper (modo AUTO)
+		motion_preset_update();
+		
+		// Tramas de telemetra suscritas
+		telemetry_update();
+		
+		// Mensajes agrupados por el limitador de tasa
+		event_log_flush();
+		
+		// Benchmark de formateo pedido con BM (si lo hay)
+		format_benchmark_update();
 	}
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include "macro_engine.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/servo_driver.h"
+#include "../drivers/gripper_driver.h"
+#include "../drivers/system_clock.h"
+#include "units.h"
+#include "../limits/limit_switch.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+
+// Longitud de cada instrucción (opcode incluido), indexada por macro_op_t
+static const uint8_t op_length[MACRO_OP_COUNT] PROGMEM = {
+	1,  // END
+	5,  // MOVE
+	5,  // ARM
+	3,  // SERVO
+	2,  // GRIPPER
+	2,  // WAIT
+	3,  // DELAY
+	2,  // JUMP
+	3,  // IF_LIMIT
+	3,  // SET
+	3,  // LOOP
+};
+
+static uint8_t ram_slots[MACRO_RAM_SLOTS][MACRO_SLOT_SIZE];
+
+// Programa en ejecución (copia del slot)
+static uint8_t program[MACRO_SLOT_SIZE];
+static uint8_t counters[MACRO_COUNTERS];
+static macro_state_t state = MACRO_IDLE;
+static uint8_t running_slot = 0;
+static uint8_t pc = 0;
+static uint8_t wait_mask = 0;
+static uint32_t wait_start_ms = 0;
+static uint16_t delay_ms = 0;
+
+static uint8_t* eeprom_slot(uint8_t slot) {
+	return (uint8_t*)MACRO_EEPROM_BASE + (uint16_t)(slot - MACRO_RAM_SLOTS) * MACRO_SLOT_SIZE;
+}
+
+static uint16_t read_u16(const uint8_t* p) {
+	return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+bool macro_write(uint8_t slot, uint8_t offset, const uint8_t* data, uint8_t len) {
+	if (slot >= MACRO_SLOT_COUNT || (uint16_t)offset + len > MACRO_SLOT_SIZE) return false;
+
+	if (slot < MACRO_RAM_SLOTS) {
+		memcpy(&ram_slots[slot][offset], data, len);
+		return true;
+	}
+	// eeprom_update_block solo escribe los bytes que cambian, pero cada uno
+	// bloquea el loop: no durante un movimiento
+	if (stepper_is_moving()) return false;
+	eeprom_update_block(data, eeprom_slot(slot) + offset, len);
+	return true;
+}
+
+// Recorre el programa hasta el primer END comprobando opcodes, operandos y
+// que cada salto caiga al inicio de una instrucción anterior al END
+static bool validate(uint8_t* error_pc) {
+	uint8_t boundaries[(MACRO_SLOT_SIZE + 7) / 8];
+	memset(boundaries, 0, sizeof(boundaries));
+
+	uint8_t end_pc = 0;
+	for (uint8_t p = 0; ; ) {
+		uint8_t op = program[p];
+		if (op >= MACRO_OP_COUNT) {
+			*error_pc = p;
+			return false;
+		}
+		uint8_t len = pgm_read_byte(&op_length[op]);
+		if ((uint16_t)p + len > MACRO_SLOT_SIZE) {
+			*error_pc = p;
+			return false;
+		}
+		boundaries[p >> 3] |= (uint8_t)(1 << (p & 7));
+		if (op == MACRO_OP_END) {
+			end_pc = p;
+			break;
+		}
+		p += len;
+		if (p >= MACRO_SLOT_SIZE) {
+			*error_pc = p - len;
+			return false;
+		}
+	}
+
+	for (uint8_t p = 0; p < end_pc; p += pgm_read_byte(&op_length[program[p]])) {
+		const uint8_t* arg = &program[p + 1];
+		uint8_t target = MACRO_NO_ERROR;
+		bool ok = true;
+		switch (program[p]) {
+			case MACRO_OP_SERVO:    ok = (arg[0] == 1 || arg[0] == 2); break;
+			case MACRO_OP_GRIPPER:  ok = (arg[0] <= MACRO_GRIPPER_CLOSE); break;
+			case MACRO_OP_JUMP:     target = arg[0]; break;
+			case MACRO_OP_IF_LIMIT: target = arg[1]; break;
+			case MACRO_OP_SET:      ok = (arg[0] < MACRO_COUNTERS); break;
+			case MACRO_OP_LOOP:     ok = (arg[0] < MACRO_COUNTERS); target = arg[1]; break;
+			default: break;
+		}
+		if (target != MACRO_NO_ERROR) {
+			ok = (target <= end_pc) && (boundaries[target >> 3] & (1 << (target & 7)));
+		}
+		if (!ok) {
+			*error_pc = p;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool macro_run(uint8_t slot, uint8_t* error_pc) {
+	*error_pc = MACRO_NO_ERROR;
+	if (slot >= MACRO_SLOT_COUNT) return false;
+
+	if (slot < MACRO_RAM_SLOTS) {
+		memcpy(program, ram_slots[slot], MACRO_SLOT_SIZE);
+	} else {
+		eeprom_read_block(program, eeprom_slot(slot), MACRO_SLOT_SIZE);
+	}
+	if (!validate(error_pc)) {
+		state = MACRO_IDLE;
+		return false;
+	}
+
+	memset(counters, 0, sizeof(counters));
+	running_slot = slot;
+	pc = 0;
+	state = MACRO_RUNNING;
+	return true;
+}
+
+// MACRO_COMPLETED:<slot> / MACRO_ABORTED:<slot>,PC=<pc>[,<motivo>]
+static void report_end(msg_id_t id, const char* reason_P) {
+	char msg[48];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, id);
+	resp_char(&r, ':');
+	resp_uint(&r, running_slot);
+	if (id == MSG_MACRO_ABORTED) {
+		resp_str_P(&r, PSTR(",PC="));
+		resp_uint(&r, pc);
+		if (reason_P) {
+			resp_char(&r, ',');
+			resp_str_P(&r, reason_P);
+		}
+	}
+	event_log_send_event(LOG_CAT_SYSTEM, LOG_EVENT, msg);
+	state = MACRO_IDLE;
+}
+
+void macro_abort(void) {
+	if (state == MACRO_IDLE) return;
+	report_end(MSG_MACRO_ABORTED, NULL);
+}
+
+bool macro_is_running(void) {
+	return state != MACRO_IDLE;
+}
+
+macro_state_t macro_get_state(void) {
+	return state;
+}
+
+const char* macro_state_name(macro_state_t st) {
+	switch (st) {
+		case MACRO_RUNNING: return PSTR("RUN");
+		case MACRO_WAITING: return PSTR("WAIT");
+		case MACRO_DELAYING: return PSTR("DELAY");
+		default: return PSTR("IDLE");
+	}
+}
+
+uint8_t macro_get_slot(void) {
+	return running_slot;
+}
+
+uint8_t macro_get_pc(void) {
+	return pc;
+}
+
+static bool actions_busy(uint8_t mask) {
+	return ((mask & MACRO_WAIT_MOTION) && stepper_is_moving()) ||
+		((mask & MACRO_WAIT_SERVO) && servo_is_busy()) ||
+		((mask & MACRO_WAIT_GRIPPER) && gripper_is_busy());
+}
+
+static bool limits_active(uint8_t mask) {
+	limit_status_t limits = limit_switch_get_status();
+	return ((mask & MACRO_LIMIT_H_LEFT) && limits.h_left_triggered) ||
+		((mask & MACRO_LIMIT_H_RIGHT) && limits.h_right_triggered) ||
+		((mask & MACRO_LIMIT_V_UP) && limits.v_up_triggered) ||
+		((mask & MACRO_LIMIT_V_DOWN) && limits.v_down_triggered);
+}
+
+// Ejecuta la instrucción en pc; false si hay que esperar o el programa terminó
+static bool step(void) {
+	const uint8_t* arg = &program[pc + 1];
+	uint8_t op = program[pc];
+	uint8_t next = pc + pgm_read_byte(&op_length[op]);
+
+	switch (op) {
+		case MACRO_OP_END:
+			report_end(MSG_MACRO_COMPLETED, NULL);
+			return false;
+
+		case MACRO_OP_MOVE: {
+			int16_t x = (int16_t)read_u16(&arg[0]);
+			int16_t y = (int16_t)read_u16(&arg[2]);
+			stepper_move_relative(units_relative_steps(UNITS_AXIS_H, (int32_t)x * UNITS_CENTI_PER_MM),
+			                      units_relative_steps(UNITS_AXIS_V, (int32_t)y * UNITS_CENTI_PER_MM));
+			break;
+		}
+
+		case MACRO_OP_ARM: {
+			uint16_t time_ms = read_u16(&arg[2]);
+			if (time_ms > SERVO_MAX_MOVE_TIME) time_ms = SERVO_MAX_MOVE_TIME;
+			servo_move_to(arg[0], arg[1], time_ms);
+			break;
+		}
+
+		case MACRO_OP_SERVO:
+			servo_set_position(arg[0], arg[1]);
+			break;
+
+		case MACRO_OP_GRIPPER:
+			if (arg[0] == MACRO_GRIPPER_OPEN) {
+				gripper_open();
+			} else {
+				gripper_close();
+			}
+			break;
+
+		case MACRO_OP_WAIT:
+			pc = next;
+			wait_mask = arg[0];
+			wait_start_ms = system_clock_millis();
+			state = MACRO_WAITING;
+			return false;
+
+		case MACRO_OP_DELAY:
+			pc = next;
+			delay_ms = read_u16(&arg[0]);
+			wait_start_ms = system_clock_millis();
+			state = MACRO_DELAYING;
+			return false;
+
+		case MACRO_OP_JUMP:
+			next = arg[0];
+			break;
+
+		case MACRO_OP_IF_LIMIT:
+			if (limits_active(arg[0])) next = arg[1];
+			break;
+
+		case MACRO_OP_SET:
+			counters[arg[0]] = arg[1];
+			break;
+
+		case MACRO_OP_LOOP:
+			if (counters[arg[0]] > 0 && --counters[arg[0]] > 0) next = arg[1];
+			break;
+	}
+
+	pc = next;
+	return true;
+}
+
+void macro_update(void) {
+	if (state == MACRO_IDLE) return;
+
+	uint32_t elapsed = system_clock_millis() - wait_start_ms;
+	if (state == MACRO_WAITING) {
+		if (actions_busy(wait_mask)) {
+			if (elapsed >= MACRO_WAIT_TIMEOUT_MS) {
+				report_end(MSG_MACRO_ABORTED, PSTR("TIMEOUT"));
+			}
+			return;
+		}
+		state = MACRO_RUNNING;
+	} else if (state == MACRO_DELAYING) {
+		if (elapsed < delay_ms) return;
+		state = MACRO_RUNNING;
+	}
+
+	// Un lazo sin esperas no puede acaparar el loop principal
+	for (uint8_t i = 0; i < MACRO_STEPS_PER_UPDATE; i++) {
+		if (!step()) break;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef MACRO_ENGINE_H
+#define MACRO_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../config/system_config.h"
+
+// Programas de bytecode que encadenan acciones sin el supervisor (p.ej. un
+// ciclo completo de cosecha). Se cargan por trozos con MU: en slots de RAM
+// (0..MACRO_RAM_SLOTS-1) o de EEPROM (los siguientes) y se lanzan con MR:.
+// Al arrancar se copian al buffer de ejecución y se validan completos, así
+// el slot puede reescribirse mientras el programa corre.
+//
+// Instrucción = opcode + operandos fijos (enteros de 16 bits little-endian).
+// Los destinos de salto son offsets en bytes dentro del programa.
+
+typedef enum {
+	MACRO_OP_END = 0,       // Fin del programa
+	MACRO_OP_MOVE,          // int16 x_mm, int16 y_mm: como M (relativo)
+	MACRO_OP_ARM,           // uint8 angle1, uint8 angle2, uint16 time_ms: como A
+	MACRO_OP_SERVO,         // uint8 servo, uint8 angle: como P
+	MACRO_OP_GRIPPER,       // uint8 acción (MACRO_GRIPPER_*)
+	MACRO_OP_WAIT,          // uint8 máscara MACRO_WAIT_*: esperar a que terminen
+	MACRO_OP_DELAY,         // uint16 ms
+	MACRO_OP_JUMP,          // uint8 destino
+	MACRO_OP_IF_LIMIT,      // uint8 máscara MACRO_LIMIT_*, uint8 destino: saltar si alguno activo
+	MACRO_OP_SET,           // uint8 contador, uint8 valor
+	MACRO_OP_LOOP,          // uint8 contador, uint8 destino: decrementar y saltar si != 0
+	MACRO_OP_COUNT
+} macro_op_t;
+
+#define MACRO_GRIPPER_OPEN      0
+#define MACRO_GRIPPER_CLOSE     1
+
+#define MACRO_WAIT_MOTION       0x01
+#define MACRO_WAIT_SERVO        0x02
+#define MACRO_WAIT_GRIPPER      0x04
+
+#define MACRO_LIMIT_H_LEFT      0x01
+#define MACRO_LIMIT_H_RIGHT     0x02
+#define MACRO_LIMIT_V_UP        0x04
+#define MACRO_LIMIT_V_DOWN      0x08
+
+#define MACRO_SLOT_COUNT        (MACRO_RAM_SLOTS + MACRO_EEPROM_SLOTS)
+#define MACRO_NO_ERROR          0xFF
+
+typedef enum {
+	MACRO_IDLE,
+	MACRO_RUNNING,
+	MACRO_WAITING,          // WAIT: acciones en curso
+	MACRO_DELAYING          // DELAY
+} macro_state_t;
+
+// Escribir bytes en un slot; false si el slot/rango no existe o si es de
+// EEPROM y hay movimiento (la escritura bloquea ~3.3ms por byte)
+bool macro_write(uint8_t slot, uint8_t offset, const uint8_t* data, uint8_t len);
+
+// Validar y arrancar; si el programa es inválido devuelve false con el
+// offset de la instrucción culpable en *error_pc
+bool macro_run(uint8_t slot, uint8_t* error_pc);
+
+// Cancelar el programa (las acciones ya iniciadas siguen; S para pararlas)
+void macro_abort(void);
+
+bool macro_is_running(void);
+macro_state_t macro_get_state(void);
+const char* macro_state_name(macro_state_t state);   // Texto en flash (PSTR)
+uint8_t macro_get_slot(void);
+uint8_t macro_get_pc(void);
+
+// Llamar desde el loop principal
+void macro_update(void);
+
+#endif // MACRO_ENGINE_H
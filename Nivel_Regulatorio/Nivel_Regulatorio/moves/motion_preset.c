@@ -0,0 +1,120 @@
+#include "motion_preset.h"
+#include "../config/parameters.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/servo_driver.h"
+#include "../drivers/gripper_driver.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../command/message_catalog.h"
+#include <avr/pgmspace.h>
+#include <string.h>
+
+static motion_preset_t presets[PRESET_COUNT];
+static preset_id_t active = PRESET_EMPTY;
+static bool auto_mode = false;
+static gripper_state_t last_gripper_state = GRIPPER_IDLE;
+
+// Valor del preset acotado al parámetro; 0 = el parámetro
+static uint16_t limited(uint16_t value, param_id_t param) {
+	uint16_t max = param_get(param);
+	return (value == 0 || value > max) ? max : value;
+}
+
+void motion_preset_apply(void) {
+	const motion_preset_t* p = &presets[active];
+	horizontal_axis.max_speed = limited(p->speed_h, PARAM_MAX_SPEED_H);
+	vertical_axis.max_speed = limited(p->speed_v, PARAM_MAX_SPEED_V);
+	horizontal_axis.acceleration = limited(p->accel_h, PARAM_ACCEL_H);
+	vertical_axis.acceleration = limited(p->accel_v, PARAM_ACCEL_V);
+	servo_set_speed_limit(p->servo_ms_per_deg);
+	gripper_set_speed(p->gripper_delay_ms);
+}
+
+static void change_to(preset_id_t id) {
+	active = id;
+	motion_preset_apply();
+
+	char msg[32];
+	response_t r;
+	resp_init(&r, msg, sizeof(msg));
+	resp_msg(&r, MSG_PRESET_CHANGED);
+	resp_char(&r, ':');
+	resp_str_P(&r, motion_preset_name(id));
+	if (auto_mode) resp_str_P(&r, PSTR(",AUTO"));
+	event_log_send_event(LOG_CAT_MOTION, LOG_EVENT, msg);
+}
+
+void motion_preset_init(void) {
+	memset(presets, 0, sizeof(presets));
+	presets[PRESET_EMPTY].gripper_delay_ms = PRESET_EMPTY_GRIPPER_MS;
+
+	presets[PRESET_LOADED].speed_h = PRESET_LOADED_SPEED_H;
+	presets[PRESET_LOADED].speed_v = PRESET_LOADED_SPEED_V;
+	presets[PRESET_LOADED].accel_h = PRESET_LOADED_ACCEL_H;
+	presets[PRESET_LOADED].accel_v = PRESET_LOADED_ACCEL_V;
+	presets[PRESET_LOADED].servo_ms_per_deg = PRESET_LOADED_SERVO_MS_DEG;
+	presets[PRESET_LOADED].gripper_delay_ms = PRESET_LOADED_GRIPPER_MS;
+
+	active = PRESET_EMPTY;
+	auto_mode = false;
+	motion_preset_apply();
+}
+
+void motion_preset_update(void) {
+	if (!auto_mode) return;
+
+	// Solo estados finales: durante OPENING/CLOSING sigue el preset anterior
+	gripper_state_t state = gripper_get_state();
+	if (state == last_gripper_state || (state != GRIPPER_OPEN && state != GRIPPER_CLOSED)) return;
+	last_gripper_state = state;
+
+	preset_id_t wanted = (state == GRIPPER_CLOSED) ? PRESET_LOADED : PRESET_EMPTY;
+	if (wanted != active) change_to(wanted);
+}
+
+void motion_preset_select(preset_id_t id) {
+	if (id >= PRESET_COUNT) return;
+	auto_mode = false;
+	change_to(id);
+}
+
+void motion_preset_set_auto(bool enabled) {
+	auto_mode = enabled;
+	// Forzar la evaluación del estado actual en la próxima pasada
+	last_gripper_state = GRIPPER_IDLE;
+}
+
+bool motion_preset_is_auto(void) {
+	return auto_mode;
+}
+
+preset_id_t motion_preset_active(void) {
+	return active;
+}
+
+void motion_preset_set(preset_id_t id, const motion_preset_t* preset) {
+	if (id >= PRESET_COUNT) return;
+	presets[id] = *preset;
+	if (id == active) motion_preset_apply();
+}
+
+const motion_preset_t* motion_preset_get(preset_id_t id) {
+	return &presets[id];
+}
+
+preset_id_t motion_preset_find(const char* name, uint8_t len) {
+	for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+		const char* entry = motion_preset_name((preset_id_t)i);
+		if (strncmp_P(name, entry, len) == 0 && pgm_read_byte(&entry[len]) == '\0') {
+			return (preset_id_t)i;
+		}
+	}
+	return PRESET_COUNT;
+}
+
+const char* motion_preset_name(preset_id_t id) {
+	switch (id) {
+		case PRESET_LOADED: return PSTR("LOADED");
+		default: return PSTR("EMPTY");
+	}
+}
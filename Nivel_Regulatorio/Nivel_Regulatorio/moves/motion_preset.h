@@ -0,0 +1,56 @@
+#ifndef MOTION_PRESET_H
+#define MOTION_PRESET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../config/system_config.h"
+
+// Juegos de velocidades con nombre según la carga: vacío (agresivo) y con
+// lechuga (suave). Cada preset fija la velocidad y aceleración de los ejes,
+// el límite de velocidad de los servos y el periodo del gripper. Se elige
+// con MP:<nombre> o, en modo AUTO, según el gripper: cerrar carga el preset
+// con carga y abrir vuelve al vacío.
+//
+// Velocidad y aceleración 0 = la del parámetro (PG/PS); distintas de 0 se
+// acotan a él. Los límites propios de un M/MA o un G1 F solo pueden bajar
+// del preset: el driver los acota a la velocidad y aceleración del eje.
+
+typedef enum {
+	PRESET_EMPTY = 0,
+	PRESET_LOADED,
+	PRESET_COUNT
+} preset_id_t;
+
+typedef struct {
+	uint16_t speed_h;           // pasos/s
+	uint16_t speed_v;
+	uint16_t accel_h;           // pasos/s²
+	uint16_t accel_v;
+	uint8_t servo_ms_per_deg;   // 0 = sin límite
+	uint8_t gripper_delay_ms;   // Entre medios pasos (2-10)
+} motion_preset_t;
+
+// Defaults y preset vacío aplicado (después de servo_init y gripper_init)
+void motion_preset_init(void);
+
+// Modo AUTO: seguir los cambios de estado del gripper
+void motion_preset_update(void);
+
+// Seleccionar a mano (desactiva AUTO)
+void motion_preset_select(preset_id_t id);
+void motion_preset_set_auto(bool enabled);
+bool motion_preset_is_auto(void);
+preset_id_t motion_preset_active(void);
+
+// Cambiar los valores de un preset (se aplican ya si es el activo)
+void motion_preset_set(preset_id_t id, const motion_preset_t* preset);
+const motion_preset_t* motion_preset_get(preset_id_t id);
+
+// Volver a aplicar el activo (p.ej. tras cambiar MAX_SPEED_* o ACCEL_*)
+void motion_preset_apply(void);
+
+// PRESET_COUNT si el nombre no existe
+preset_id_t motion_preset_find(const char* name, uint8_t len);
+const char* motion_preset_name(preset_id_t id);     // Texto en flash (PSTR)
+
+#endif // MOTION_PRESET_H
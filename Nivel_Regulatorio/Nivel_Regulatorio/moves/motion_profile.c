@@ -3,24 +3,33 @@
 #include <avr/interrupt.h>
 #include <stdlib.h>
 #include "../config/system_config.h"
+#include "../drivers/system_clock.h"
 
 // CAMBIO: Función para abs de int32_t
 static int32_t abs32(int32_t x) {
 	return (x < 0) ? -x : x;
 }
 
-static volatile uint32_t tick_counter = 0;
-
-void motion_profile_tick(void) {
-	tick_counter++;
+// Raíz cuadrada entera (mismo método bit a bit que el resto del perfil)
+static uint32_t sqrt32(uint64_t value) {
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 15;
+	while (bit > 0) {
+		uint32_t test = root + bit;
+		if ((uint64_t)test * test <= value) {
+			root = test;
+		}
+		bit >>= 1;
+	}
+	return root;
 }
 
 void motion_profile_init(void) {
-	tick_counter = 0;
+	// La base de tiempo es system_clock (Timer4); no hay estado propio que inicializar
 }
 
 uint32_t motion_profile_get_millis(void) {
-	return tick_counter * 5;  // 200Hz = 5ms por tick
+	return system_clock_millis();
 }
 
 void motion_profile_setup(motion_profile_t* profile,
@@ -97,6 +106,15 @@ uint16_t motion_profile_update(motion_profile_t* profile, int32_t current_pos) {
 	uint16_t target_speed;
 	int32_t steps_done = abs32(current_pos - profile->start_position);  // CAMBIO
 	
+	// Bajada máxima por tick con la deceleración del perfil. Tras bajar el
+	// override max_speed ya es el valor nuevo: el techo sigue la rampa hasta él
+	uint16_t max_drop = profile->acceleration / MOTION_PROFILE_UPDATE_HZ;
+	if (max_drop == 0) max_drop = 1;
+	uint16_t ceiling = profile->max_speed;
+	if (profile->current_speed > ceiling + max_drop) {
+		ceiling = profile->current_speed - max_drop;
+	}
+	
 	// Resto del código igual...
 	// Determinar fase del movimiento
 	if (steps_remaining <= profile->decel_steps) {
@@ -153,14 +171,19 @@ uint16_t motion_profile_update(motion_profile_t* profile, int32_t current_pos) {
 		// FASE CONSTANTE
 		profile->state = PROFILE_CONSTANT;
 		target_speed = profile->target_speed;
+		
+		// Tras bajar el override: rampa hacia la nueva velocidad con la deceleración del perfil
+		if (profile->current_speed > target_speed + max_drop) {
+			target_speed = profile->current_speed - max_drop;
+		}
 	}
 	
 	// CAMBIO SUAVE: Aplicar directamente el target_speed calculado por la fórmula cinemática
 	// La protección contra cambios bruscos está en stepper_update_profiles
 	profile->current_speed = target_speed;
 	
-	if (profile->current_speed > profile->max_speed) {
-		profile->current_speed = profile->max_speed;
+	if (profile->current_speed > ceiling) {
+		profile->current_speed = ceiling;
 	}
 	
     // Evitar imponer velocidad mínima cuando estamos al final del movimiento
@@ -171,6 +194,75 @@ uint16_t motion_profile_update(motion_profile_t* profile, int32_t current_pos) {
     return profile->current_speed;
 }
 
+void motion_profile_set_max_speed(motion_profile_t* profile, int32_t current_pos, uint16_t max_speed) {
+	if (!motion_profile_is_active(profile) || max_speed == 0) {
+		return;
+	}
+	
+	uint32_t accel = (profile->acceleration > 0) ? profile->acceleration : 1;
+	uint32_t v_now = profile->current_speed;
+	bool positive = (profile->target_position > profile->start_position);
+	
+	// Re-basar el inicio virtual para que la fórmula de aceleración continúe
+	// desde la velocidad actual: d = v² / (2 * a)
+	int32_t virtual_done = (int32_t)((v_now * v_now) / (2 * accel));
+	profile->start_position = positive ? current_pos - virtual_done : current_pos + virtual_done;
+	profile->total_steps = abs32(profile->target_position - profile->start_position);
+	profile->max_speed = max_speed;
+	
+	// Recalcular punto de deceleración (si venimos más rápido, frenar desde la velocidad actual)
+	uint32_t v_new = max_speed;
+	uint32_t v_decel = (v_now > v_new) ? v_now : v_new;
+	profile->accel_steps = (int32_t)((v_new * v_new) / (2 * accel));
+	profile->decel_steps = (int32_t)((v_decel * v_decel) / (2 * accel));
+	
+	if (profile->accel_steps + profile->decel_steps > profile->total_steps) {
+		// Perfil triangular: la nueva velocidad no se alcanza antes de frenar
+		profile->accel_steps = profile->total_steps / 2;
+		if (profile->accel_steps < virtual_done) profile->accel_steps = virtual_done;
+		profile->decel_steps = profile->total_steps - profile->accel_steps;
+		if (profile->decel_steps < 1) profile->decel_steps = 1;
+		profile->constant_steps = 0;
+		
+		uint32_t v_peak = sqrt32((uint64_t)2 * accel * profile->accel_steps);
+		profile->target_speed = (v_peak < max_speed) ? v_peak : max_speed;
+	} else {
+		profile->constant_steps = profile->total_steps - profile->accel_steps - profile->decel_steps;
+		profile->target_speed = max_speed;
+	}
+}
+
+void motion_profile_retarget(motion_profile_t* profile, int32_t current_pos, int32_t target_pos, uint16_t max_speed) {
+	// Mismo sentido de marcha: solo se mueve el destino y se recalculan las fases
+	profile->target_position = target_pos;
+	motion_profile_set_max_speed(profile, current_pos, max_speed);
+}
+
+int32_t motion_profile_decel_target(motion_profile_t* profile, int32_t current_pos) {
+	if (!motion_profile_is_active(profile)) {
+		return current_pos;
+	}
+	
+	// Distancia de frenado con la deceleración del perfil: d = v² / (2 * a)
+	uint32_t v = (uint32_t)profile->current_speed;
+	uint32_t accel = (profile->acceleration > 0) ? profile->acceleration : 1;
+	int32_t stop_steps = (int32_t)((v * v) / (2 * accel)) + 2;  // Margen para el último paso
+	
+	int32_t steps_remaining = abs32(profile->target_position - current_pos);
+	if (steps_remaining <= stop_steps) {
+		// Ya está frenando o no alcanza a frenar antes del destino original
+		return profile->target_position;
+	}
+	
+	bool positive = (profile->target_position > profile->start_position);
+	profile->target_position = positive ? current_pos + stop_steps : current_pos - stop_steps;
+	profile->total_steps = abs32(profile->target_position - profile->start_position);
+	profile->decel_steps = stop_steps;
+	profile->state = PROFILE_DECELERATING;
+	
+	return profile->target_position;
+}
+
 bool motion_profile_is_active(motion_profile_t* profile) {
 	return (profile->state != PROFILE_IDLE && profile->state != PROFILE_COMPLETED);
 }
@@ -4,6 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Frecuencia de llamada a motion_profile_update (Timer4)
+#define MOTION_PROFILE_UPDATE_HZ    200
+
 // Estados del perfil de movimiento
 typedef enum {
 	PROFILE_IDLE,
@@ -55,6 +58,17 @@ uint16_t acceleration);
 // Actualizar el perfil y obtener la velocidad actual
 uint16_t motion_profile_update(motion_profile_t* profile, int32_t current_pos);
 
+// Cambiar la velocidad mxima de un perfil en curso (override de avance).
+// Recalcula la fase de aceleracin y el punto de deceleracin desde la posicin actual
+void motion_profile_set_max_speed(motion_profile_t* profile, int32_t current_pos, uint16_t max_speed);
+
+// Cambiar el destino de un perfil en curso (mismo sentido), conservando la velocidad actual
+void motion_profile_retarget(motion_profile_t* profile, int32_t current_pos, int32_t target_pos, uint16_t max_speed);
+
+// Acortar el perfil para detenerse con la deceleracin configurada.
+// Devuelve la nueva posicin destino (o la original si ya no alcanza a frenar antes)
+int32_t motion_profile_decel_target(motion_profile_t* profile, int32_t current_pos);
+
 // Verificar si el perfil est activo
 bool motion_profile_is_active(motion_profile_t* profile);
 
@@ -64,6 +78,4 @@ void motion_profile_reset(motion_profile_t* profile);
 // Obtener el tiempo actual en ms (para sincronizacin)
 uint32_t motion_profile_get_millis(void);
 
-void motion_profile_tick(void);
-
 #endif // MOTION_PROFILE_H
\ No newline at end of file
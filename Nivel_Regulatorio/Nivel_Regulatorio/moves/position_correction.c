@@ -0,0 +1,176 @@
+#include "position_correction.h"
+#include "motion_profile.h"
+#include "../drivers/stepper_driver.h"
+#include "../drivers/uart_driver.h"
+#include "../drivers/system_clock.h"
+#include "../command/event_log.h"
+#include "../command/response_builder.h"
+#include "../config/system_config.h"
+#include <avr/pgmspace.h>
+
+// Estado de un eje dentro del lazo de corrección
+typedef struct {
+	int32_t setpoint;         // Posición absoluta deseada (pasos)
+	int32_t integral;         // Suma del error por tick (pasos * tick)
+	int16_t velocity;         // Última velocidad enviada al jog (pasos/s)
+} correction_axis_t;
+
+static correction_axis_t h_corr = {0};
+static correction_axis_t v_corr = {0};
+
+static bool correction_active = false;
+static uint16_t kp = CORRECTION_DEFAULT_KP;
+static uint16_t ki = CORRECTION_DEFAULT_KI;
+static uint16_t max_speed = CORRECTION_DEFAULT_MAX_SPEED;
+
+static uint32_t last_update_us = 0;
+static uint32_t last_error_ms = 0;
+
+static int32_t abs32(int32_t x) {
+	return (x < 0) ? -x : x;
+}
+
+void position_correction_set_error(int32_t h_error, int32_t v_error) {
+	int32_t h_pos, v_pos;
+	stepper_get_position(&h_pos, &v_pos);
+	
+	// La cámara mide el error completo: la consigna sustituye a la anterior
+	h_corr.setpoint = h_pos + h_error;
+	v_corr.setpoint = v_pos + v_error;
+	
+	if (!correction_active) {
+		h_corr.integral = 0;
+		v_corr.integral = 0;
+		h_corr.velocity = 0;
+		v_corr.velocity = 0;
+		correction_active = true;
+		last_update_us = system_clock_micros();
+	}
+	last_error_ms = motion_profile_get_millis();
+}
+
+void position_correction_set_gains(uint16_t kp_centi, uint16_t ki_centi, uint16_t speed) {
+	kp = kp_centi;
+	ki = ki_centi;
+	if (speed < CORRECTION_MIN_SPEED) speed = CORRECTION_MIN_SPEED;
+	if (speed > MAX_STEP_RATE) speed = MAX_STEP_RATE;
+	max_speed = speed;
+}
+
+void position_correction_get_gains(uint16_t* kp_centi, uint16_t* ki_centi, uint16_t* speed) {
+	*kp_centi = kp;
+	*ki_centi = ki;
+	*speed = max_speed;
+}
+
+void position_correction_stop(void) {
+	if (!correction_active) return;
+	correction_active = false;
+	stepper_jog(0, 0);
+}
+
+bool position_correction_is_active(void) {
+	return correction_active;
+}
+
+// Ley PI acotada para un eje. Devuelve la velocidad con signo (0 = dentro de la banda muerta)
+static int16_t compute_velocity(correction_axis_t* axis, int32_t position) {
+	int32_t error = axis->setpoint - position;
+	
+	if (abs32(error) <= CORRECTION_DEADBAND_STEPS) {
+		axis->integral = 0;
+		return 0;
+	}
+	
+	// Integral con anti-windup: limitar a lo que produciría la velocidad máxima
+	axis->integral += error;
+	if (ki > 0) {
+		int32_t i_limit = ((int32_t)max_speed * 100L * MOTION_PROFILE_UPDATE_HZ) / ki;
+		if (axis->integral > i_limit) axis->integral = i_limit;
+		if (axis->integral < -i_limit) axis->integral = -i_limit;
+	}
+	
+	// v = Kp*e + Ki*sum(e*dt), ganancias en centésimas y dt = 1/MOTION_PROFILE_UPDATE_HZ
+	int32_t velocity = ((int32_t)kp * error) / 100 +
+		((int32_t)ki * axis->integral) / (100L * MOTION_PROFILE_UPDATE_HZ);
+	
+	if (velocity > (int32_t)max_speed) velocity = max_speed;
+	if (velocity < -(int32_t)max_speed) velocity = -(int32_t)max_speed;
+	
+	// Velocidad mínima útil fuera de la banda muerta
+	if (velocity > 0 && velocity < CORRECTION_MIN_SPEED) velocity = CORRECTION_MIN_SPEED;
+	if (velocity < 0 && velocity > -CORRECTION_MIN_SPEED) velocity = -CORRECTION_MIN_SPEED;
+	
+	return (int16_t)velocity;
+}
+
+// ¿Cambió la velocidad lo suficiente como para reprogramar el jog?
+static bool velocity_changed(int16_t previous, int16_t next) {
+	if (previous == next) return false;
+	if (previous == 0 || next == 0 || (previous > 0) != (next > 0)) return true;
+	
+	int16_t diff = next - previous;
+	if (diff < 0) diff = -diff;
+	int16_t threshold = (previous < 0 ? -previous : previous) / 20;  // 5%
+	if (threshold < 50) threshold = 50;
+	return diff > threshold;
+}
+
+void position_correction_update(void) {
+	if (!correction_active) return;
+	
+	// Ejecutar a la frecuencia del perfil (dt fijo de las ganancias)
+	if (!system_clock_elapsed(&last_update_us, 1000000UL / MOTION_PROFILE_UPDATE_HZ)) return;
+	uint32_t now = motion_profile_get_millis();
+	
+	// Sin mediciones nuevas de la cámara: frenar por seguridad
+	if (now - last_error_ms > CORRECTION_TIMEOUT_MS) {
+		correction_active = false;
+		stepper_jog(0, 0);
+		event_log_send_event_msg(LOG_CAT_CORRECTION, LOG_EVENT, MSG_CORRECTION_TIMEOUT);
+		return;
+	}
+	
+	// Otro comando (S, M:, J:...) tomó el control de los ejes: abandonar la corrección
+	if ((h_corr.velocity != 0 || v_corr.velocity != 0) && !stepper_is_jogging()) {
+		correction_active = false;
+		event_log_send_event_msg(LOG_CAT_CORRECTION, LOG_EVENT, MSG_CORRECTION_ABORTED);
+		return;
+	}
+	
+	int32_t h_pos, v_pos;
+	stepper_get_position(&h_pos, &v_pos);
+	
+	int16_t h_vel = compute_velocity(&h_corr, h_pos);
+	int16_t v_vel = compute_velocity(&v_corr, v_pos);
+	
+	if (h_vel == 0 && v_vel == 0) {
+		if (!stepper_is_moving()) {
+			// Convergencia: ambos ejes dentro de la banda muerta y detenidos
+			correction_active = false;
+			h_corr.velocity = 0;
+			v_corr.velocity = 0;
+			
+			char msg[64];
+			response_t r;
+			resp_init(&r, msg, sizeof(msg));
+			resp_msg(&r, MSG_CORRECTION_CONVERGED);
+			resp_char(&r, ':');
+			resp_int_pair(&r, h_pos, v_pos);
+			resp_str_P(&r, PSTR(",ERR:"));
+			resp_int_pair(&r, h_corr.setpoint - h_pos, v_corr.setpoint - v_pos);
+			event_log_send_event(LOG_CAT_CORRECTION, LOG_EVENT, msg);
+			return;
+		}
+	}
+	
+	if (velocity_changed(h_corr.velocity, h_vel) || velocity_changed(v_corr.velocity, v_vel)) {
+		h_corr.velocity = h_vel;
+		v_corr.velocity = v_vel;
+		if (h_vel == 0 && v_vel == 0) {
+			stepper_jog(0, 0);
+			} else {
+			stepper_jog(h_vel, v_vel);
+		}
+	}
+}
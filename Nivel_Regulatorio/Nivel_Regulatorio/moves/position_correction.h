@@ -0,0 +1,27 @@
+#ifndef POSITION_CORRECTION_H
+#define POSITION_CORRECTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Lazo de corrección de posición guiado por visión (PI en firmware).
+// El supervisor envía el error medido por la cámara (en pasos) a la tasa de captura;
+// el firmware lo convierte en un punto de consigna absoluto y mueve los ejes en modo
+// jog con una velocidad acotada proporcional al error restante.
+
+// Recibir una nueva medición de error (pasos, mismo signo que M:)
+void position_correction_set_error(int32_t h_error, int32_t v_error);
+
+// Configurar ganancias: kp y ki en centésimas (1/s y 1/s²), velocidad máxima en pasos/s
+void position_correction_set_gains(uint16_t kp_centi, uint16_t ki_centi, uint16_t max_speed);
+void position_correction_get_gains(uint16_t* kp_centi, uint16_t* ki_centi, uint16_t* max_speed);
+
+// Cancelar la corrección (frena con la deceleración configurada)
+void position_correction_stop(void);
+
+bool position_correction_is_active(void);
+
+// Llamar desde el loop principal
+void position_correction_update(void);
+
+#endif // POSITION_CORRECTION_H
@@ -0,0 +1,176 @@
+#include "position_history.h"
+#include "../drivers/system_clock.h"
+#include "../drivers/uart_driver.h"
+#include "../command/message_catalog.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static position_sample_t samples[POSITION_HISTORY_SIZE];
+static volatile uint8_t head = 0;       // Próxima posición a escribir
+static volatile uint8_t count = 0;
+static volatile uint8_t period_ticks = POSITION_HISTORY_DEFAULT_PERIOD;
+static uint8_t tick_counter = 0;
+static bool was_moving = false;
+
+// Lectura en curso (volcado o búsqueda): la ISR no toca el anillo y guarda
+// aparte solo la última muestra, que se agrega al terminar
+static volatile bool frozen = false;
+static position_sample_t deferred;
+static volatile bool deferred_valid = false;
+
+void position_history_init(void) {
+	head = 0;
+	count = 0;
+	tick_counter = 0;
+	was_moving = false;
+	frozen = false;
+	deferred_valid = false;
+}
+
+void position_history_set_period(uint8_t ticks) {
+	period_ticks = ticks;
+	tick_counter = 0;
+}
+
+uint8_t position_history_get_period(void) {
+	return period_ticks;
+}
+
+static void store_sample(const position_sample_t* sample) {
+	samples[head] = *sample;
+	head = (head + 1) % POSITION_HISTORY_SIZE;
+	if (count < POSITION_HISTORY_SIZE) count++;
+}
+
+void position_history_tick(bool moving, int32_t h_pos, int32_t v_pos) {
+	if (period_ticks == 0) return;
+	
+	bool record = false;
+	if (moving) {
+		if (!was_moving || ++tick_counter >= period_ticks) {
+			record = true;  // Primera muestra al arrancar y luego cada periodo
+		}
+		} else if (was_moving) {
+		record = true;      // Muestra final: posición de reposo exacta
+	}
+	was_moving = moving;
+	
+	if (!record) return;
+	tick_counter = 0;
+	
+	position_sample_t sample;
+	sample.timestamp_us = system_clock_micros();
+	sample.h_steps = h_pos;
+	sample.v_steps = v_pos;
+	
+	if (frozen) {
+		deferred = sample;
+		deferred_valid = true;
+		return;
+	}
+	store_sample(&sample);
+}
+
+// Un volcado por UART tarda decenas de ms: sin congelar, la ISR pisaría los
+// registros más viejos mientras se envían. Las muestras intermedias de ese
+// lapso se pierden; la última (p.ej. la de reposo) se conserva
+static void freeze(void) {
+	frozen = true;  // Un byte: escritura atómica
+}
+
+static void unfreeze(void) {
+	uint8_t sreg = SREG;
+	cli();
+	frozen = false;
+	if (deferred_valid) {
+		store_sample(&deferred);
+		deferred_valid = false;
+	}
+	SREG = sreg;
+}
+
+// Registro i-ésimo (0 = más antiguo); solo con el anillo congelado
+static void read_sample(uint8_t i, position_sample_t* out) {
+	*out = samples[(head + POSITION_HISTORY_SIZE - count + i) % POSITION_HISTORY_SIZE];
+}
+
+static int32_t interpolate(int32_t p0, int32_t p1, uint32_t dt_total, uint32_t dt) {
+	if (dt_total == 0) return p1;
+	return p0 + (int32_t)(((int64_t)(p1 - p0) * dt) / dt_total);
+}
+
+static bool lookup_frozen(uint32_t timestamp_us, int32_t* h_pos, int32_t* v_pos) {
+	uint8_t n = count;
+	if (n == 0) return false;
+	
+	position_sample_t prev, next;
+	read_sample(0, &prev);
+	if ((int32_t)(timestamp_us - prev.timestamp_us) < 0) return false;  // Anterior al historial
+	
+	for (uint8_t i = 1; i < n; i++) {
+		read_sample(i, &next);
+		if ((int32_t)(timestamp_us - next.timestamp_us) <= 0) {
+			uint32_t dt_total = next.timestamp_us - prev.timestamp_us;
+			uint32_t dt = timestamp_us - prev.timestamp_us;
+			*h_pos = interpolate(prev.h_steps, next.h_steps, dt_total, dt);
+			*v_pos = interpolate(prev.v_steps, next.v_steps, dt_total, dt);
+			return true;
+		}
+		prev = next;
+	}
+	
+	// Posterior a la última muestra: solo es exacto si los ejes ya están en reposo
+	// (una muestra de reposo diferida todavía no está en el anillo)
+	if (!was_moving && !deferred_valid && (int32_t)(system_clock_micros() - timestamp_us) >= 0) {
+		*h_pos = prev.h_steps;
+		*v_pos = prev.v_steps;
+		return true;
+	}
+	return false;
+}
+
+bool position_history_lookup(uint32_t timestamp_us, int32_t* h_pos, int32_t* v_pos) {
+	freeze();
+	bool found = lookup_frozen(timestamp_us, h_pos, v_pos);
+	unfreeze();
+	return found;
+}
+
+static void send_bytes(const void* data, uint8_t length) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (uint8_t i = 0; i < length; i++) {
+		uart_send_char((char)bytes[i]);
+	}
+}
+
+uint8_t position_history_dump(uint32_t from_us, uint32_t to_us) {
+	freeze();
+	uint8_t n = count;
+	uint8_t first = n;
+	uint8_t matched = 0;
+	position_sample_t sample;
+	
+	// Contar primero para que la cabecera indique el largo exacto
+	for (uint8_t i = 0; i < n; i++) {
+		read_sample(i, &sample);
+		if ((int32_t)(sample.timestamp_us - from_us) >= 0 && (int32_t)(to_us - sample.timestamp_us) >= 0) {
+			if (first == n) first = i;
+			matched++;
+		}
+	}
+	
+	char header[24];
+	response_t r;
+	resp_init(&r, header, sizeof(header));
+	resp_msg(&r, MSG_HISTORY_BIN);
+	resp_char(&r, ':');
+	resp_uint(&r, matched);
+	uart_send_response(header);
+	
+	for (uint8_t i = 0; i < matched; i++) {
+		read_sample(first + i, &sample);
+		send_bytes(&sample, sizeof(sample));
+	}
+	unfreeze();
+	return matched;
+}
@@ -0,0 +1,38 @@
+#ifndef POSITION_HISTORY_H
+#define POSITION_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Historial de posición con timestamp para georreferenciar capturas de cámara.
+// Se muestrea desde la ISR de Timer4 mientras hay movimiento (más una muestra
+// final al detenerse), con el mismo reloj en microsegundos que system_clock_micros.
+
+#define POSITION_HISTORY_SIZE           48      // 48 * 12 bytes = 576 bytes de SRAM
+#define POSITION_HISTORY_DEFAULT_PERIOD 2       // Cada 2 ticks de 5ms = 10ms
+
+// Registro tal como se envía en el volcado binario (little-endian, 12 bytes)
+typedef struct {
+	uint32_t timestamp_us;
+	int32_t h_steps;
+	int32_t v_steps;
+} position_sample_t;
+
+void position_history_init(void);
+
+// Periodo de muestreo en ticks de Timer4 (0 = deshabilitado)
+void position_history_set_period(uint8_t ticks);
+uint8_t position_history_get_period(void);
+
+// Llamar desde la ISR de Timer4
+void position_history_tick(bool moving, int32_t h_pos, int32_t v_pos);
+
+// Posición interpolada en timestamp_us. false si está fuera del rango registrado
+bool position_history_lookup(uint32_t timestamp_us, int32_t* h_pos, int32_t* v_pos);
+
+// Enviar por UART los registros entre from_us y to_us: cabecera de texto
+// "HISTORY_BIN:<n>" seguida de n registros binarios de 12 bytes. Mientras se
+// envía el anillo queda congelado (solo se guarda la última muestra nueva)
+uint8_t position_history_dump(uint32_t from_us, uint32_t to_us);
+
+#endif // POSITION_HISTORY_H
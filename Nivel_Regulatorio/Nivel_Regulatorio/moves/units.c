@@ -0,0 +1,76 @@
+#include "units.h"
+#include "../config/parameters.h"
+
+typedef struct {
+	int32_t steps;          // Pasos por `centi` centésimas (razón reducida)
+	int32_t centi;
+	int32_t residue;        // Resto de la última conversión relativa, en 1/centi de paso
+} axis_ratio_t;
+
+static axis_ratio_t ratios[2];
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+	while (b) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// División redondeada al más cercano (d > 0), simétrica para negativos
+static int32_t div_round(int32_t n, int32_t d) {
+	return (n >= 0) ? (n + d / 2) / d : (n - d / 2) / d;
+}
+
+void units_init(void) {
+	uint32_t steps_per_rev = (uint32_t)STEPS_PER_REV_NEMA * param_get(PARAM_MICROSTEPS);
+	units_set_ratio(UNITS_AXIS_H, steps_per_rev, param_get(PARAM_MM_REV_H));
+	units_set_ratio(UNITS_AXIS_V, steps_per_rev, param_get(PARAM_MM_REV_V));
+}
+
+void units_set_ratio(units_axis_t axis, uint32_t steps_per_rev, uint32_t centi_per_rev) {
+	uint32_t g = gcd(steps_per_rev, centi_per_rev);
+	if (g == 0) return;
+	ratios[axis].steps = (int32_t)(steps_per_rev / g);
+	ratios[axis].centi = (int32_t)(centi_per_rev / g);
+	ratios[axis].residue = 0;
+}
+
+int32_t units_centi_to_steps(units_axis_t axis, int32_t centi) {
+	return div_round(centi * ratios[axis].steps, ratios[axis].centi);
+}
+
+int32_t units_steps_to_centi(units_axis_t axis, int32_t steps) {
+	return div_round(steps * ratios[axis].centi, ratios[axis].steps);
+}
+
+int32_t units_relative_steps(units_axis_t axis, int32_t centi) {
+	axis_ratio_t* q = &ratios[axis];
+	int32_t total = centi * q->steps + q->residue;
+	int32_t steps = div_round(total, q->centi);
+	q->residue = total - steps * q->centi;
+	return steps;
+}
+
+int32_t units_absolute_steps(units_axis_t axis, int32_t centi) {
+	axis_ratio_t* q = &ratios[axis];
+	int32_t total = centi * q->steps;
+	int32_t steps = div_round(total, q->centi);
+	q->residue = total - steps * q->centi;
+	return steps;
+}
+
+uint32_t units_feed_to_rate(units_axis_t axis, uint32_t centi_per_min) {
+	// Producto en 64 bits: un F alto por una razón poco reducible (p.ej. 6400
+	// pasos/rev) no cabe en 32 y daría una velocidad pequeña y errónea
+	uint64_t rate = ((uint64_t)centi_per_min * (uint32_t)ratios[axis].steps) /
+		((uint32_t)ratios[axis].centi * 60);
+	return (rate > UINT32_MAX) ? UINT32_MAX : (uint32_t)rate;
+}
+
+void units_resp_mm_pair(response_t* r, int32_t h_centi, int32_t v_centi) {
+	resp_fixed(r, h_centi, 2);
+	resp_char(r, ',');
+	resp_fixed(r, v_centi, 2);
+}
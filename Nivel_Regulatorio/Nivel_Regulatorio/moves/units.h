@@ -0,0 +1,44 @@
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <stdint.h>
+#include "../command/response_builder.h"
+
+// Milímetros en punto fijo: centésimas (0.01 mm). La conversión a pasos usa
+// la razón entera pasos/rev : centésimas/rev reducida (H 2:5, V 2:1), así no
+// hay float ni error acumulado por redondear 40 o 200 pasos/mm.
+//
+// Los movimientos relativos arrastran el resto de cada conversión: diez
+// M:0.01 seguidos avanzan exactamente lo mismo que un M:0.10. Un destino
+// absoluto fija ese resto a la fracción de paso de su propia posición.
+
+#define UNITS_CENTI_PER_MM  100
+
+typedef enum {
+	UNITS_AXIS_H = 0,
+	UNITS_AXIS_V = 1
+} units_axis_t;
+
+void units_init(void);
+
+// Pasos por vuelta y centésimas por vuelta de un eje (reduce la razón)
+void units_set_ratio(units_axis_t axis, uint32_t steps_per_rev, uint32_t centi_per_rev);
+
+// Conversiones redondeadas al más cercano (sin estado)
+int32_t units_centi_to_steps(units_axis_t axis, int32_t centi);
+int32_t units_steps_to_centi(units_axis_t axis, int32_t steps);
+
+// Desplazamiento relativo en pasos arrastrando el resto del anterior
+int32_t units_relative_steps(units_axis_t axis, int32_t centi);
+
+// Destino absoluto en pasos; el resto queda alineado con esa posición
+int32_t units_absolute_steps(units_axis_t axis, int32_t centi);
+
+// Avance en centésimas/min a pasos/s (sin acotar a la velocidad del eje;
+// satura en UINT32_MAX)
+uint32_t units_feed_to_rate(units_axis_t axis, uint32_t centi_per_min);
+
+// "h,v" en mm con dos decimales
+void units_resp_mm_pair(response_t* r, int32_t h_centi, int32_t v_centi);
+
+#endif // UNITS_H
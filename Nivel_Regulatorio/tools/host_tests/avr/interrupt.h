@@ -0,0 +1,9 @@
+#ifndef INTERRUPT_HOST_SHIM_H
+#define INTERRUPT_HOST_SHIM_H
+
+// Sustituto de <avr/interrupt.h>: en el host no hay ISR que bloquear
+
+static inline void cli(void) {}
+static inline void sei(void) {}
+
+#endif
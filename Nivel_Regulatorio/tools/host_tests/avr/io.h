@@ -0,0 +1,8 @@
+#ifndef IO_HOST_SHIM_H
+#define IO_HOST_SHIM_H
+
+// Sustituto de <avr/io.h> para compilar módulos sin registros en el host
+
+#include <stdint.h>
+
+#endif
@@ -0,0 +1,92 @@
+// Prueba en el host del perfil de movimiento (moves/motion_profile.c): al
+// bajar el override en pleno movimiento la velocidad baja con la deceleración
+// del perfil, nunca más de acceleration / MOTION_PROFILE_UPDATE_HZ por tick.
+//
+// Compilar y ejecutar desde esta carpeta:
+//
+//   gcc -O2 -Wall -I. -I../../Nivel_Regulatorio -o motion_profile_test motion_profile_test.c ../../Nivel_Regulatorio/moves/motion_profile.c
+//   ./motion_profile_test
+//
+// Devuelve 0 si todos los casos pasan.
+
+#include "moves/motion_profile.h"
+#include <stdio.h>
+
+uint32_t system_clock_millis(void) {
+	return 0;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FALLO %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+// Un tick del loop: la posición avanza lo que recorre la velocidad en 1/HZ s
+typedef struct {
+	motion_profile_t profile;
+	double position;
+	uint16_t speed;
+} sim_t;
+
+static void sim_tick(sim_t* sim) {
+	sim->speed = motion_profile_update(&sim->profile, (int32_t)sim->position);
+	sim->position += (double)sim->speed / MOTION_PROFILE_UPDATE_HZ;
+}
+
+// Baja el override en pleno movimiento y verifica la rampa hasta new_speed
+static void check_override_drop(const char* name, int32_t distance, uint16_t max_speed,
+uint16_t accel, int32_t drop_at, uint16_t new_speed) {
+	sim_t sim = { 0 };
+	motion_profile_setup(&sim.profile, 0, distance, max_speed, accel);
+
+	while (sim.position < drop_at) {
+		sim_tick(&sim);
+	}
+	uint16_t before = sim.speed;
+	CHECK(before > new_speed, "%s: velocidad antes de bajar %u", name, before);
+
+	motion_profile_set_max_speed(&sim.profile, (int32_t)sim.position, new_speed);
+
+	// Con menos de un paso/s por tick el perfil baja de a 1
+	uint16_t max_drop = accel / MOTION_PROFILE_UPDATE_HZ;
+	if (max_drop == 0) max_drop = 1;
+	uint16_t previous = before;
+	int ticks = 0;
+	while (previous > new_speed && motion_profile_is_active(&sim.profile)) {
+		sim_tick(&sim);
+		ticks++;
+		CHECK(sim.speed + max_drop >= previous,
+			"%s: tick %d bajó de %u a %u (máximo %u por tick)", name, ticks, previous, sim.speed, max_drop);
+		previous = sim.speed;
+	}
+	CHECK(ticks > 1, "%s: la bajada se hizo en %d tick(s)", name, ticks);
+
+	// Después de la rampa no vuelve a superar la nueva velocidad
+	while (motion_profile_is_active(&sim.profile)) {
+		sim_tick(&sim);
+		CHECK(sim.speed <= new_speed, "%s: %u supera la nueva velocidad %u", name, sim.speed, new_speed);
+	}
+	CHECK((int32_t)sim.position >= distance - 1, "%s: terminó en %d de %d", name, (int)sim.position, (int)distance);
+}
+
+int main(void) {
+	// Override 100% -> 20% en la fase constante
+	check_override_drop("constante", 200000, 10000, 7500, 100000, 2000);
+
+	// Con poco recorrido: el frenado desde la velocidad actual cae en la fase de deceleración
+	check_override_drop("deceleracion", 40000, 10000, 7500, 30000, 2000);
+
+	// Aceleración baja (menos de un paso/s por tick)
+	check_override_drop("aceleracion_baja", 20000, 1000, 150, 8000, 500);
+
+	if (failures == 0) {
+		printf("motion_profile_test: OK\n");
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+// Prueba en el host de las conversiones en punto fijo (moves/units.c), en
+// particular el avance F -> pasos/s en el borde del desborde de 32 bits.
+//
+// Compilar y ejecutar desde esta carpeta:
+//
+//   gcc -O2 -Wall -I. -I../../Nivel_Regulatorio -o units_test units_test.c ../../Nivel_Regulatorio/moves/units.c
+//   ./units_test
+//
+// Devuelve 0 si todos los casos pasan.
+
+#include "moves/units.h"
+#include "config/parameters.h"
+#include <stdio.h>
+
+// units.c solo usa param_values en units_init y el builder en units_resp_mm_pair
+uint16_t param_values[PARAM_COUNT];
+void resp_char(response_t* r, char c) { (void)r; (void)c; }
+void resp_fixed(response_t* r, int32_t value, uint8_t decimals) { (void)r; (void)value; (void)decimals; }
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected, what) do { \
+	unsigned long long a_ = (actual), e_ = (expected); \
+	if (a_ != e_) { \
+		printf("FALLO %s:%d: %s = %llu, esperado %llu\n", __FILE__, __LINE__, what, a_, e_); \
+		failures++; \
+	} \
+} while (0)
+
+// Referencia exacta con la misma truncación que el firmware
+static unsigned long long expected_rate(unsigned long long feed, unsigned long long steps, unsigned long long centi) {
+	unsigned long long rate = feed * steps / (centi * 60);
+	return (rate > UINT32_MAX) ? UINT32_MAX : rate;
+}
+
+static void check_feed(uint32_t steps_per_rev, uint32_t centi_per_rev, uint32_t feed) {
+	units_set_ratio(UNITS_AXIS_H, steps_per_rev, centi_per_rev);
+	char what[64];
+	snprintf(what, sizeof(what), "feed %lu (%lu:%lu)", (unsigned long)feed,
+		(unsigned long)steps_per_rev, (unsigned long)centi_per_rev);
+	CHECK_EQ(units_feed_to_rate(UNITS_AXIS_H, feed), expected_rate(feed, steps_per_rev, centi_per_rev), what);
+}
+
+int main(void) {
+	// Razones de la máquina: correa 200:500 -> 2:5, varilla 200:100 -> 2:1
+	units_set_ratio(UNITS_AXIS_H, 200, 500);
+	units_set_ratio(UNITS_AXIS_V, 200, 100);
+	CHECK_EQ(units_centi_to_steps(UNITS_AXIS_H, 10), 4, "H 0.10 mm");
+	CHECK_EQ(units_centi_to_steps(UNITS_AXIS_V, 1234), 2468, "V 12.34 mm");
+	CHECK_EQ(units_feed_to_rate(UNITS_AXIS_V, 60000), 2000, "V F600");
+
+	int32_t total = 0;
+	for (int i = 0; i < 10; i++) {
+		total += units_relative_steps(UNITS_AXIS_H, 1);
+	}
+	CHECK_EQ(total, 4, "10 x 0.01 mm en H");
+
+	// 6400 pasos/rev (32 micropasos) con 9.99 mm/rev: razón irreducible.
+	// feed * 6400 desborda 32 bits a partir de 671089 centésimas/min
+	uint32_t boundary = (uint32_t)(((uint64_t)UINT32_MAX + 1) / 6400);
+	check_feed(6400, 999, boundary);
+	check_feed(6400, 999, boundary + 1);
+	check_feed(6400, 999, 10000000);
+	check_feed(6400, 999, UINT32_MAX);
+
+	// Resultado mayor que 32 bits: satura
+	check_feed(6400, 1, UINT32_MAX);
+	CHECK_EQ(units_feed_to_rate(UNITS_AXIS_H, UINT32_MAX), UINT32_MAX, "saturación");
+
+	if (failures == 0) {
+		printf("units_test: OK\n");
+	}
+	return failures ? 1 : 0;
+}
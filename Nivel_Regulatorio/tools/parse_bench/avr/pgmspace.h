@@ -0,0 +1,14 @@
+#ifndef PGMSPACE_HOST_SHIM_H
+#define PGMSPACE_HOST_SHIM_H
+
+// Sustituto de <avr/pgmspace.h> para compilar command_args.c en el host:
+// en un PC la flash y la RAM comparten espacio de direcciones.
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+#endif
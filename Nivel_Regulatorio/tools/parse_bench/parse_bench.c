@@ -0,0 +1,107 @@
+// Benchmark en el host del tokenizador de parámetros (command/command_args.c)
+// frente al parser anterior (copia a temp_str + strchr + atoi). Mide solo la
+// lectura de parámetros; el despacho por tabla es una bisección de ~6
+// comparaciones y no depende del largo del comando.
+//
+// Compilar y ejecutar desde esta carpeta:
+//
+//   gcc -O2 -I. -I../../Nivel_Regulatorio -o parse_bench parse_bench.c ../../Nivel_Regulatorio/command/command_args.c
+//   ./parse_bench [iteraciones]
+//
+// Los tiempos absolutos son del PC; lo que interesa es la relación entre
+// ambos parsers y que los resultados coincidan.
+
+#include "command/command_args.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+	const char* cmd;        // Comando completo (sin '<' '>')
+	uint8_t param_offset;   // Inicio de los parámetros
+	uint8_t count;          // Cantidad de enteros
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+	{ "M:100,50",                 2, 2 },
+	{ "M:-1234,567",              2, 2 },
+	{ "J:-3200,1600",             2, 2 },
+	{ "A:45,90,2000",             2, 3 },
+	{ "SL:-10,450,0,380",         3, 4 },
+	{ "KG:120,15,4000",           3, 3 },
+	{ "TA:H,100,2500,5000,7500",  5, 4 },
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+// Parser anterior (parse_two_integers / parse_int_list de command_parser.c)
+static uint8_t legacy_parse(const char* str, int32_t* values, uint8_t max_count) {
+	char temp_str[128];
+	strncpy(temp_str, str, sizeof(temp_str) - 1);
+	temp_str[sizeof(temp_str) - 1] = '\0';
+	
+	uint8_t count = 0;
+	char* ptr = temp_str;
+	while (*ptr && count < max_count) {
+		char* comma = strchr(ptr, ',');
+		if (comma) *comma = '\0';
+		values[count++] = atoi(ptr);
+		if (!comma) break;
+		ptr = comma + 1;
+	}
+	return count;
+}
+
+static uint8_t args_parse(const char* cmd, const char* params, int32_t* values, uint8_t max_count) {
+	cmd_args_t a;
+	uint8_t count = 0;
+	args_init(&a, cmd, params);
+	while (count < max_count && *args_rest(&a) != '\0' && args_int(&a, &values[count])) count++;
+	return args_end(&a) ? count : 0;
+}
+
+static double elapsed_ns(struct timespec start, struct timespec end) {
+	return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+int main(int argc, char** argv) {
+	long iterations = (argc > 1) ? atol(argv[1]) : 1000000;
+	volatile int32_t sink = 0;
+	
+	// Ambos parsers deben dar los mismos valores (TA: salta el eje)
+	for (uint8_t i = 0; i < CASE_COUNT; i++) {
+		int32_t old_values[8], new_values[8];
+		const char* params = cases[i].cmd + cases[i].param_offset;
+		uint8_t n_old = legacy_parse(params, old_values, 8);
+		uint8_t n_new = args_parse(cases[i].cmd, params, new_values, 8);
+		if (n_old != cases[i].count || n_new != cases[i].count ||
+			memcmp(old_values, new_values, n_new * sizeof(int32_t)) != 0) {
+			printf("MISMATCH: %s\n", cases[i].cmd);
+			return 1;
+		}
+	}
+	
+	printf("%-26s %12s %12s\n", "comando", "legacy ns", "args ns");
+	for (uint8_t i = 0; i < CASE_COUNT; i++) {
+		const char* params = cases[i].cmd + cases[i].param_offset;
+		int32_t values[8];
+		struct timespec t0, t1, t2;
+		
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (long k = 0; k < iterations; k++) {
+			legacy_parse(params, values, 8);
+			sink += values[0];
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (long k = 0; k < iterations; k++) {
+			args_parse(cases[i].cmd, params, values, 8);
+			sink += values[0];
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		
+		printf("%-26s %12.1f %12.1f\n", cases[i].cmd,
+			elapsed_ns(t0, t1) / iterations, elapsed_ns(t1, t2) / iterations);
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+import time
+import logging
+from typing import Optional, List, Tuple
+
+# Reloj del firmware: uint32 en microsegundos (da la vuelta cada ~71.6 min)
+FW_CLOCK_WRAP = 1 << 32
+# Con pocos segundos de historia el jitter del listener domina la pendiente
+MIN_DRIFT_SPAN_S = 60.0
+
+
+def parse_event_timestamp(message: str) -> Optional[int]:
+    # Los eventos asíncronos terminan en ",T=<us>" (o ":T=<us>" si no tienen payload)
+    idx = message.rfind("T=")
+    if idx <= 0 or message[idx - 1] not in (',', ':'):
+        return None
+    try:
+        return int(message[idx + 2:].strip())
+    except ValueError:
+        return None
+
+
+class ClockSync:
+    """Estimación de offset y deriva host<->firmware al estilo NTP sobre TP:/PONG.
+
+    offset(t_host) = a + b * t_host, con offset = t_fw - t_host en segundos.
+    """
+
+    def __init__(self, uart_manager, history_size: int = 32):
+        self.uart = uart_manager
+        self.logger = logging.getLogger(__name__)
+        self.history_size = history_size
+        self._history: List[Tuple[float, float]] = []  # (t_host, offset) de cada sincronización
+        self._offset_a = 0.0
+        self._drift_b = 0.0
+        self._last_fw_us: Optional[int] = None  # Último tiempo de firmware visto (desenrollado)
+        self._token = 0
+        self.last_rtt = None
+        self.synced = False
+
+    def _unwrap(self, fw_us: int) -> int:
+        if self._last_fw_us is None:
+            return fw_us
+        delta = (fw_us - self._last_fw_us) % FW_CLOCK_WRAP
+        if delta >= FW_CLOCK_WRAP // 2:
+            delta -= FW_CLOCK_WRAP
+        return self._last_fw_us + delta
+
+    def _byte_time(self, n_bytes: int) -> float:
+        # 10 bits por byte (8N1)
+        return n_bytes * 10.0 / self.uart.baud_rate
+
+    def sync(self, samples: int = 16) -> bool:
+        """Intercambia `samples` pings y conserva los de menor ida y vuelta."""
+        results = []
+        for _ in range(samples):
+            self._token = (self._token + 1) % 10000
+            exchange = self.uart.ping_firmware(self._token)
+            if exchange is None:
+                continue
+            t0, t1_us, t2_us, t3, request_len, response_len = exchange
+            t1_us = self._unwrap(t1_us)
+            t2_us = self._unwrap(t2_us)
+            self._last_fw_us = t2_us
+            # t1 se toma al recibir '>' y t2 antes de transmitir: descontar la serialización
+            t0 += self._byte_time(request_len)
+            t3 -= self._byte_time(response_len)
+            t1 = t1_us / 1e6
+            t2 = t2_us / 1e6
+            rtt = (t3 - t0) - (t2 - t1)
+            offset = ((t1 - t0) + (t2 - t3)) / 2.0
+            results.append((rtt, offset, (t0 + t3) / 2.0))
+            time.sleep(0.02)
+
+        if not results:
+            self.logger.warning("Sincronización de reloj sin respuestas")
+            return False
+
+        # Filtro de mínimo RTT: el cuarto de muestras con menos latencia del listener
+        results.sort(key=lambda r: r[0])
+        best = results[:max(1, len(results) // 4)]
+        offsets = sorted(r[1] for r in best)
+        offset = offsets[len(offsets) // 2]
+        t_host = sum(r[2] for r in best) / len(best)
+        self.last_rtt = best[0][0]
+
+        self._history.append((t_host, offset))
+        if len(self._history) > self.history_size:
+            self._history.pop(0)
+        self._fit()
+        self.synced = True
+        self.logger.debug(f"Reloj sincronizado: offset={offset:.6f}s rtt={self.last_rtt * 1e3:.2f}ms "
+                          f"deriva={self.drift_ppm:.1f}ppm")
+        return True
+
+    def _fit(self):
+        # Regresión lineal del offset en el tiempo del host (deriva del cristal)
+        n = len(self._history)
+        if n < 2 or self._history[-1][0] - self._history[0][0] < MIN_DRIFT_SPAN_S:
+            self._offset_a = self._history[-1][1]
+            self._drift_b = 0.0
+            return
+        t_ref = self._history[0][0]
+        xs = [t - t_ref for t, _ in self._history]
+        ys = [o for _, o in self._history]
+        mean_x = sum(xs) / n
+        mean_y = sum(ys) / n
+        sxx = sum((x - mean_x) ** 2 for x in xs)
+        if sxx <= 0.0:
+            self._offset_a = mean_y
+            self._drift_b = 0.0
+            return
+        b = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys)) / sxx
+        self._drift_b = b
+        self._offset_a = mean_y - b * (mean_x + t_ref)
+
+    @property
+    def drift_ppm(self) -> float:
+        return self._drift_b * 1e6
+
+    def offset_at(self, t_host: float) -> float:
+        return self._offset_a + self._drift_b * t_host
+
+    def fw_to_host(self, fw_us: int) -> Optional[float]:
+        """Convierte un T=<us> del firmware a tiempo del host (time.time())."""
+        if not self.synced:
+            return None
+        t_fw = self._unwrap(int(fw_us)) / 1e6
+        # t_fw = t_host + a + b * t_host
+        return (t_fw - self._offset_a) / (1.0 + self._drift_b)
+
+    def host_to_fw(self, t_host: float) -> Optional[int]:
+        if not self.synced:
+            return None
+        return int(round((t_host + self.offset_at(t_host)) * 1e6)) % FW_CLOCK_WRAP
@@ -1,18 +1,216 @@
 from typing import Dict, Optional
 from .uart_manager import UARTManager
+from .clock_sync import ClockSync
+from .macro_program import MacroProgram, upload_frames
+from .step_compress import segment_frames
+from config.robot_config import RobotConfig
 import time
 import logging
 
 class CommandManager:
     def __init__(self, uart_manager: UARTManager):
         self.uart = uart_manager
+        self.clock = ClockSync(uart_manager)
         self.logger = logging.getLogger(__name__)
     
-    def move_xy(self, x_mm: float, y_mm: float) -> Dict:
-        command = f"M:{x_mm},{y_mm}"
+    @staticmethod
+    def _move_args(x_mm: float, y_mm: float, speed: Optional[int], accel: Optional[int]) -> str:
+        # El firmware trabaja en centésimas de mm: más decimales se truncan.
+        # speed (pasos/s) y accel (pasos/s²) rigen solo este movimiento
+        args = f"{x_mm:.2f},{y_mm:.2f}"
+        if speed or accel:
+            args += f",{int(speed or 0)}"
+        if accel:
+            args += f",{int(accel)}"
+        return args
+
+    def move_xy(self, x_mm: float, y_mm: float, speed: Optional[int] = None, accel: Optional[int] = None) -> Dict:
+        command = f"M:{self._move_args(x_mm, y_mm, speed, accel)}"
         self.logger.debug(f"Movimiento: X={x_mm}mm, Y={y_mm}mm")
         return self.uart.send_command(command)
 
+    def move_xy_async(self, x_mm: float, y_mm: float, speed: Optional[int] = None,
+                      accel: Optional[int] = None) -> Optional[int]:
+        # Sin esperar el ACK: varios comandos en vuelo (ver wait_for_sequence)
+        return self.uart.send_command_async(f"M:{self._move_args(x_mm, y_mm, speed, accel)}")
+
+    def move_to(self, x_mm: float, y_mm: float, speed: Optional[int] = None, accel: Optional[int] = None) -> Dict:
+        # Destino absoluto desde el origen (home); sin error acumulado
+        command = f"MA:{self._move_args(x_mm, y_mm, speed, accel)}"
+        self.logger.debug(f"Movimiento absoluto: X={x_mm}mm, Y={y_mm}mm")
+        return self.uart.send_command(command)
+
+    def send_async(self, command: str) -> Optional[int]:
+        return self.uart.send_command_async(command)
+
+    def send_batch(self, *commands: str) -> Optional[int]:
+        # Un solo frame: el firmware valida todo y arranca los subcomandos en
+        # la misma pasada (solo M, MA, A, P, RA y GT). ACK: OK:BATCH:<n>
+        return self.uart.send_command_async(';'.join(commands))
+
+    def wait_for_sequence(self, seq: int, timeout: float = 30.0) -> Optional[str]:
+        # ERR en el ACK o sin fin de acción dentro del timeout -> None
+        ack = self.uart.wait_for_ack(seq)
+        if ack is None or ack.startswith("ERR:"):
+            return None
+        return self.uart.wait_for_sequence(seq, timeout)
+
+
+    def upload_macro(self, slot: int, program: MacroProgram) -> Dict:
+        # Slots 0-1 en RAM, 2-5 en EEPROM (no se puede escribir con los ejes en movimiento)
+        result = {"success": False, "error": "Programa vacío"}
+        for frame in upload_frames(slot, program.assemble()):
+            result = self.uart.send_command(frame)
+            if not result.get("success") or "ERR:" in result.get("response", ""):
+                result["success"] = False
+                return result
+        return result
+
+    def run_macro(self, slot: int) -> Dict:
+        return self.uart.send_command(f"MR:{int(slot)}")
+
+    def run_macro_and_wait(self, slot: int, timeout: float = 120.0) -> bool:
+        # True con MACRO_COMPLETED; False si se rechazó, abortó o no terminó a tiempo
+        result = self.run_macro(slot)
+        if not result.get("success") or "OK:MACRO_RUN" not in result.get("response", ""):
+            return False
+        line = self.uart.wait_for_line(("MACRO_COMPLETED", "MACRO_ABORTED"), timeout)
+        return line is not None and line.startswith("MACRO_COMPLETED")
+
+    def abort_macro(self) -> Dict:
+        return self.uart.send_command("MX")
+
+    def get_params(self) -> Dict[str, int]:
+        # PL?: "PARAM:<nombre>=<valor>,<min>,<max>,<default>" por parámetro
+        result = self.uart.send_command("PL?")
+        params = {}
+        for line in result.get("response", "").splitlines():
+            if not line.startswith("PARAM:") or '=' not in line:
+                continue
+            name, values = line[6:].split('=', 1)
+            try:
+                params[name] = int(values.split(',')[0])
+            except ValueError:
+                continue
+        return params
+
+    def set_param(self, name: str, value: int) -> Dict:
+        # Solo en RAM hasta save_params(); los de escala (MICROSTEPS, MM_REV_*) con los ejes quietos
+        result = self.uart.send_command(f"PS:{name},{int(value)}")
+        if result.get("success") and "OK:PARAM" not in result.get("response", ""):
+            result["success"] = False
+        return result
+
+    def save_params(self) -> Dict:
+        return self.uart.send_command("PW")
+
+    def set_motion_preset(self, name: str) -> Dict:
+        # EMPTY (vacío, agresivo) o LOADED (con lechuga, suave); desactiva el modo AUTO
+        return self.uart.send_command(f"MP:{name}")
+
+    def set_motion_preset_auto(self) -> Dict:
+        # El firmware elige según el gripper: cerrado -> LOADED, abierto -> EMPTY
+        return self.uart.send_command("MP:AUTO")
+
+    def get_motion_presets(self) -> Dict:
+        return self.uart.send_command("MP?")
+
+    def load_params(self, defaults: bool = False) -> Dict:
+        return self.uart.send_command("PR:DEF" if defaults else "PR")
+
+    def get_macro_status(self) -> Dict:
+        return self.uart.send_command("MS?")
+
+
+    def stream_gcode(self, lines, timeout: float = 60.0) -> Dict:
+        # Una línea por "ok" (la cola del firmware mantiene los ejes ocupados);
+        # se corta en el primer error o timeout
+        sent = 0
+        for raw in lines:
+            line = raw.split(';', 1)[0].strip()
+            if not line:
+                continue
+            reply = self.uart.send_gcode_line(line, timeout)
+            if reply is None or reply.startswith("error:"):
+                return {"success": False, "sent": sent, "line": line, "error": reply or "timeout"}
+            sent += 1
+        return {"success": True, "sent": sent}
+
+    def queue_steps(self, axis: str, segments, timeout: float = 5.0) -> Dict:
+        # Segmentos (interval, count, add) de step_compress; con la cola llena
+        # se reintenta hasta que la ISR libere sitio
+        for frame in segment_frames(axis, segments):
+            deadline = time.time() + timeout
+            while True:
+                result = self.uart.send_command(frame)
+                response = result.get("response", "")
+                if not result.get("success") or "ERR:STEP_QUEUE_FULL" not in response:
+                    break
+                if time.time() > deadline:
+                    return {"success": False, "error": "timeout", "response": response}
+                time.sleep(0.005)
+            if not result.get("success") or "OK:STEP_QUEUE" not in response:
+                result["success"] = False
+                return result
+        return {"success": True}
+
+    def start_step_queue(self, delay_s: float = 0.05) -> Dict:
+        # Instante de arranque en el reloj del firmware; sin sincronizar, en el acto
+        start_us = self.clock.host_to_fw(time.time() + delay_s) if self.clock.synced else None
+        if start_us is None:
+            return self.uart.send_command("QG")
+        return self.uart.send_command(f"QG:{start_us % (1 << 32)}")
+
+    def end_step_queue(self) -> Dict:
+        return self.uart.send_command("QE")
+
+    def clear_step_queue(self) -> Dict:
+        return self.uart.send_command("QX")
+
+    def get_step_queue_status(self) -> Dict:
+        return self.uart.send_command("QS?")
+
+    def run_step_stream(self, h_segments=(), v_segments=(), prefill: int = 12,
+                        delay_s: float = 0.05, timeout: float = 60.0) -> Dict:
+        # Precarga, QG y el resto alternando ejes (un eje lleno no frena al
+        # otro). Termina con STEP_QUEUE_DONE, _UNDERRUN (el host no llegó a
+        # tiempo) o _ABORTED (límite / S)
+        h_segments, v_segments = list(h_segments), list(v_segments)
+        for axis, segments in (("H", h_segments[:prefill]), ("V", v_segments[:prefill])):
+            if segments:
+                result = self.queue_steps(axis, segments)
+                if not result.get("success"):
+                    return result
+        result = self.start_step_queue(delay_s)
+        if not result.get("success") or "OK:STEP_QUEUE_START" not in result.get("response", ""):
+            result["success"] = False
+            return result
+
+        pending = {"H": segment_frames("H", h_segments[prefill:]),
+                   "V": segment_frames("V", v_segments[prefill:])}
+        deadline = time.time() + timeout
+        while pending["H"] or pending["V"]:
+            sent = False
+            for axis in ("H", "V"):
+                if not pending[axis]:
+                    continue
+                result = self.uart.send_command(pending[axis][0])
+                response = result.get("response", "")
+                if result.get("success") and "OK:STEP_QUEUE" in response:
+                    pending[axis].pop(0)
+                    sent = True
+                elif not result.get("success") or "ERR:STEP_QUEUE_FULL" not in response:
+                    # Underrun o parada ya ocurridos: la cola no acepta más
+                    return {"success": False, "response": response or result.get("error")}
+            if not sent:
+                if time.time() > deadline:
+                    self.clear_step_queue()
+                    return {"success": False, "response": "timeout"}
+                time.sleep(0.005)
+        self.end_step_queue()
+        line = self.uart.wait_for_line(("STEP_QUEUE_DONE", "STEP_QUEUE_UNDERRUN", "STEP_QUEUE_ABORTED"),
+                                       max(0.0, deadline - time.time()))
+        return {"success": line is not None and line.startswith("STEP_QUEUE_DONE"), "response": line or "timeout"}
 
     def get_system_status(self) -> Dict:
         return self.uart.send_command("S?")
@@ -23,6 +221,102 @@ class CommandManager:
         return self.uart.send_command(command)
 
 
+    def set_feed_override(self, percent: int) -> Dict:
+        pct = max(10, min(200, int(percent)))
+        return self.uart.send_command(f"FO:{pct}")
+
+
+    def jog(self, h_steps_per_s: int, v_steps_per_s: int) -> Dict:
+        return self.uart.send_command(f"J:{int(h_steps_per_s)},{int(v_steps_per_s)}")
+
+    def jog_stop(self) -> Dict:
+        return self.uart.send_command("J:0,0")
+
+    def set_soft_limits(self, h_min_mm: int, h_max_mm: int, v_min_mm: int, v_max_mm: int) -> Dict:
+        return self.uart.send_command(f"SL:{int(h_min_mm)},{int(h_max_mm)},{int(v_min_mm)},{int(v_max_mm)}")
+
+    def disable_soft_limits(self) -> Dict:
+        return self.uart.send_command("SL:OFF")
+
+
+    def send_position_error(self, h_error_mm: float, v_error_mm: float) -> Dict:
+        h_steps = int(round(h_error_mm * RobotConfig.STEPS_PER_MM_H))
+        v_steps = int(round(v_error_mm * RobotConfig.STEPS_PER_MM_V))
+        return self.uart.send_command(f"E:{h_steps},{v_steps}")
+
+    def stop_position_correction(self) -> Dict:
+        return self.uart.send_command("EX")
+
+    def set_correction_gains(self, kp_centi: int, ki_centi: int, max_speed: int) -> Dict:
+        return self.uart.send_command(f"KG:{int(kp_centi)},{int(ki_centi)},{int(max_speed)}")
+
+
+    def set_position_triggers(self, axis: str, positions_steps) -> Dict:
+        axis = 'H' if axis.upper() == 'H' else 'V'
+        result = {"success": True, "response": ""}
+        chunk = []
+        for pos in positions_steps:
+            chunk.append(str(int(pos)))
+            if len(','.join(chunk)) > 100:
+                result = self.uart.send_command(f"TA:{axis},{','.join(chunk)}")
+                chunk = []
+                if not result.get("success") or "ERR:" in result.get("response", ""):
+                    return result
+        if chunk:
+            result = self.uart.send_command(f"TA:{axis},{','.join(chunk)}")
+        return result
+
+    def clear_position_triggers(self) -> Dict:
+        return self.uart.send_command("TC")
+
+    def set_trigger_mode(self, pin: bool = True, event: bool = True) -> Dict:
+        mode = (1 if pin else 0) | (2 if event else 0)
+        return self.uart.send_command(f"TM:{mode}")
+
+
+    def set_history_period(self, ticks_5ms: int) -> Dict:
+        return self.uart.send_command(f"PH:{max(0, min(255, int(ticks_5ms)))}")
+
+    def get_position_at(self, timestamp_us: int) -> Dict:
+        return self.uart.send_command(f"PT:{int(timestamp_us)}")
+
+    def get_firmware_clock(self) -> Dict:
+        return self.uart.send_command("CK?")
+
+    def get_rx_stats(self) -> Dict:
+        # Frames recibidos/descartados por el firmware (DROPPED y OVERFLOW deberían quedar en 0)
+        return self.uart.send_command("RX?")
+
+    def subscribe_telemetry(self, topic: str, period_ms: int) -> Dict:
+        # Tramas binarias periódicas; se leen con uart.get_telemetry(topic)
+        return self.uart.send_command(f"TS:{topic},{max(0, int(period_ms))}")
+
+    def telemetry_off(self) -> Dict:
+        return self.uart.send_command("TS:OFF")
+
+    def set_log_level(self, category: str, level: int) -> Dict:
+        # Categorías MOT, LIM, SRV, GRP, TRG, COR, SYS o ALL; 0=error 1=evento 2=debug 3=trace
+        return self.uart.send_command(f"VL:{category},{max(0, min(3, int(level)))}")
+
+    def set_log_rate(self, category: str, min_interval_ms: int) -> Dict:
+        return self.uart.send_command(f"VR:{category},{max(0, int(min_interval_ms))}")
+
+    def set_message_ids(self, enabled: bool) -> bool:
+        # Cabeceras numéricas (#id) para reducir bytes por línea; se expanden en el listener
+        return self.uart.enable_message_ids(enabled)
+
+    def sync_clock(self, samples: int = 16) -> bool:
+        # Repetir periódicamente para que el ajuste lineal capture la deriva
+        return self.clock.sync(samples)
+
+    def get_last_event_time(self, action_type: str) -> Optional[float]:
+        # Instante (tiempo del host) en que el firmware completó la acción
+        fw_us = self.uart.get_last_event_timestamp(action_type)
+        if fw_us is None:
+            return None
+        return self.clock.fw_to_host(fw_us)
+
+
     def move_arm(self, servo1_angle: int, servo2_angle: int, time_ms: int = 0) -> Dict:
         a1 = max(10, min(160, int(servo1_angle)))
         a2 = max(10, min(160, int(servo2_angle)))
@@ -55,8 +349,22 @@ class CommandManager:
         return self.gripper_toggle()
 
 
-    def emergency_stop(self) -> Dict:
-        return self.uart.send_command("S")
+    def emergency_stop(self, timeout: float = 1.0) -> Dict:
+        # Byte de parada rápida; el firmware confirma con OK:STOP desde el loop
+        if not self.uart.send_fast_stop():
+            return self.uart.send_command("S")
+        if self.uart.wait_for_message("OK:STOP", timeout):
+            return {"success": True, "response": "OK:STOP"}
+        return {"success": False, "error": "Sin confirmación de parada"}
+
+    def decel_stop(self) -> Dict:
+        return self.uart.send_command("SD")
+
+    def feed_hold(self) -> Dict:
+        return self.uart.send_command("FH")
+
+    def feed_resume(self) -> Dict:
+        return self.uart.send_command("FR")
 
     def wait_for_completion(self, timeout: float = 30.0) -> bool:
         time.sleep(0.5)
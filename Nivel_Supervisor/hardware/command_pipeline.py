@@ -0,0 +1,146 @@
+import threading
+from typing import Dict, List, Optional, Set, Tuple
+
+# Comandos en vuelo con número de secuencia (command/command_seq.h del
+# firmware). Un frame "<17|M:100,50>" recibe un ACK "17|OK:..." y la acción
+# que inicia termina con "17|STEPPER_MOVE_COMPLETED:..." (o la parada que la
+# corte). Cada ACK devuelve un crédito; hay tantos créditos como slots de
+# recepción del firmware (RX?: SLOTS=). Un batch "<17|M:..;A:..;GT>" liga
+# la misma secuencia a cada actuador y termina cuando terminaron todos.
+
+SEQ_MODULO = 1 << 16
+
+# Actuador que pone en marcha cada opcode
+OPCODE_ACTUATOR = {
+    'M': 'MOTION',
+    'J': 'MOTION',
+    'A': 'SERVO',
+    'P': 'SERVO',
+    'RA': 'SERVO',
+    'GT': 'GRIPPER',
+}
+
+# Cabeceras que cierran la acción de cada actuador
+COMPLETION_ACTUATOR = {
+    'STEPPER_MOVE_COMPLETED': 'MOTION',
+    'STEPPER_DECEL_STOP': 'MOTION',
+    'STEPPER_EMERGENCY_STOP': 'MOTION',
+    'STEPPER_JOG_STOPPED': 'MOTION',
+    'SERVO_MOVE_COMPLETED': 'SERVO',
+    'GRIPPER_ACTION_COMPLETED': 'GRIPPER',
+}
+
+# Pendientes sin consumir que se conservan (los más viejos se descartan)
+MAX_PENDING = 64
+
+
+def split_seq(line: str) -> Tuple[Optional[int], str]:
+    """'17|OK:MOVE_XY:1,2' -> (17, 'OK:MOVE_XY:1,2'). Sin prefijo -> (None, line)."""
+    bar = line.find('|')
+    if bar <= 0 or not line[:bar].isdigit():
+        return None, line
+    return int(line[:bar]), line[bar + 1:]
+
+
+def _not_newer(seq: int, reference: int) -> bool:
+    # Comparación con vuelta de los 16 bits
+    return ((reference - seq) % SEQ_MODULO) < SEQ_MODULO // 2
+
+
+def command_actuators(command: str) -> Set[str]:
+    actuators = set()
+    for sub in command.split(';'):
+        actuator = OPCODE_ACTUATOR.get(sub.split(':', 1)[0])
+        if actuator:
+            actuators.add(actuator)
+    return actuators
+
+
+class _Pending:
+    def __init__(self, actuators: Set[str]):
+        self.actuators = actuators
+        self.remaining = set(actuators)
+        self.ack: Optional[str] = None
+        self.ack_event = threading.Event()
+        self.completions: List[str] = []
+        self.done_event = threading.Event()
+
+
+class CommandPipeline:
+    def __init__(self, credits: int = 1):
+        self._lock = threading.Lock()
+        self._credits = threading.BoundedSemaphore(credits)
+        self._next_seq = 1
+        self._pending: Dict[int, _Pending] = {}
+
+    def set_credits(self, credits: int):
+        # Solo al conectar, sin comandos en vuelo
+        self._credits = threading.BoundedSemaphore(max(1, int(credits)))
+
+    def acquire_credit(self, timeout: float) -> bool:
+        return self._credits.acquire(timeout=timeout)
+
+    def release_credit(self):
+        try:
+            self._credits.release()
+        except ValueError:
+            pass
+
+    def register(self, command: str) -> int:
+        with self._lock:
+            seq = self._next_seq
+            self._next_seq = seq % (SEQ_MODULO - 1) + 1
+            self._pending[seq] = _Pending(command_actuators(command))
+            while len(self._pending) > MAX_PENDING:
+                del self._pending[next(iter(self._pending))]
+        return seq
+
+    def on_line(self, seq: int, line: str) -> bool:
+        """Procesa una línea con prefijo de secuencia. True si cierra una acción."""
+        header = line.split(':', 1)[0]
+        actuator = COMPLETION_ACTUATOR.get(header)
+        with self._lock:
+            if actuator is None:
+                pending = self._pending.get(seq)
+                if pending is None or pending.ack_event.is_set():
+                    return False
+                pending.ack = line
+                pending.ack_event.set()
+                self.release_credit()
+                return False
+
+            # Un comando nuevo reemplaza al anterior del mismo actuador:
+            # el fin informado cierra también las secuencias previas
+            for pending_seq, pending in self._pending.items():
+                if actuator in pending.remaining and _not_newer(pending_seq, seq):
+                    pending.remaining.discard(actuator)
+                    pending.completions.append(line)
+                    if not pending.remaining:
+                        pending.done_event.set()
+        return True
+
+    def wait_ack(self, seq: int, timeout: float) -> Optional[str]:
+        pending = self._pending.get(seq)
+        if pending is None:
+            return None
+        if not pending.ack_event.wait(timeout):
+            # Sin ACK el frame no ocupa un slot: recuperar el crédito
+            with self._lock:
+                if not pending.ack_event.is_set():
+                    pending.ack_event.set()
+                    self.release_credit()
+            return None
+        if not pending.actuators or pending.ack.startswith("ERR:"):
+            with self._lock:
+                self._pending.pop(seq, None)
+        return pending.ack
+
+    def wait_completion(self, seq: int, timeout: float) -> Optional[str]:
+        pending = self._pending.get(seq)
+        if pending is None or not pending.actuators:
+            return None
+        completed = pending.done_event.wait(timeout)
+        with self._lock:
+            self._pending.pop(seq, None)
+        # Una línea por actuador (varias en un batch)
+        return '\n'.join(pending.completions) if completed else None
@@ -0,0 +1,140 @@
+import struct
+from typing import Dict, List, Optional, Tuple
+
+# Ensamblador de los programas de moves/macro_engine.h del firmware. Los
+# opcodes y operandos deben coincidir con macro_op_t; los saltos se escriben
+# con etiquetas y se resuelven a offsets en bytes al ensamblar.
+
+SLOT_SIZE = 96          # MACRO_SLOT_SIZE
+RAM_SLOTS = 2           # Slots 0-1 en RAM, 2-5 en EEPROM
+SLOT_COUNT = 6
+
+OP_END = 0
+OP_MOVE = 1
+OP_ARM = 2
+OP_SERVO = 3
+OP_GRIPPER = 4
+OP_WAIT = 5
+OP_DELAY = 6
+OP_JUMP = 7
+OP_IF_LIMIT = 8
+OP_SET = 9
+OP_LOOP = 10
+
+GRIPPER_OPEN = 0
+GRIPPER_CLOSE = 1
+
+WAIT_MOTION = 0x01
+WAIT_SERVO = 0x02
+WAIT_GRIPPER = 0x04
+WAIT_ALL = WAIT_MOTION | WAIT_SERVO | WAIT_GRIPPER
+
+LIMIT_H_LEFT = 0x01
+LIMIT_H_RIGHT = 0x02
+LIMIT_V_UP = 0x04
+LIMIT_V_DOWN = 0x08
+
+# Bytes de datos por frame MU (hex: 2 caracteres por byte dentro de 128)
+UPLOAD_CHUNK = 48
+
+
+class MacroProgram:
+    def __init__(self):
+        self._code = bytearray()
+        self._labels: Dict[str, int] = {}
+        self._fixups: List[tuple] = []     # (offset del operando, etiqueta)
+
+    def label(self, name: str) -> 'MacroProgram':
+        self._labels[name] = len(self._code)
+        return self
+
+    def move(self, x_mm: int, y_mm: int) -> 'MacroProgram':
+        self._code += struct.pack('<Bhh', OP_MOVE, int(x_mm), int(y_mm))
+        return self
+
+    def arm(self, angle1: int, angle2: int, time_ms: int = 0) -> 'MacroProgram':
+        self._code += struct.pack('<BBBH', OP_ARM, int(angle1), int(angle2), int(time_ms))
+        return self
+
+    def servo(self, servo_num: int, angle: int) -> 'MacroProgram':
+        self._code += struct.pack('<BBB', OP_SERVO, int(servo_num), int(angle))
+        return self
+
+    def gripper_open(self) -> 'MacroProgram':
+        self._code += bytes((OP_GRIPPER, GRIPPER_OPEN))
+        return self
+
+    def gripper_close(self) -> 'MacroProgram':
+        self._code += bytes((OP_GRIPPER, GRIPPER_CLOSE))
+        return self
+
+    def wait(self, mask: int = WAIT_ALL) -> 'MacroProgram':
+        self._code += bytes((OP_WAIT, mask))
+        return self
+
+    def delay(self, ms: int) -> 'MacroProgram':
+        self._code += struct.pack('<BH', OP_DELAY, int(ms))
+        return self
+
+    def jump(self, label: str) -> 'MacroProgram':
+        self._code.append(OP_JUMP)
+        self._target(label)
+        return self
+
+    def if_limit(self, mask: int, label: str) -> 'MacroProgram':
+        self._code += bytes((OP_IF_LIMIT, mask))
+        self._target(label)
+        return self
+
+    def set_counter(self, counter: int, value: int) -> 'MacroProgram':
+        self._code += bytes((OP_SET, counter, value))
+        return self
+
+    def loop(self, counter: int, label: str) -> 'MacroProgram':
+        # Decrementa el contador y vuelve a la etiqueta mientras no llegue a 0
+        self._code += bytes((OP_LOOP, counter))
+        self._target(label)
+        return self
+
+    def _target(self, label: str):
+        self._fixups.append((len(self._code), label))
+        self._code.append(0)
+
+    def assemble(self) -> bytes:
+        code = bytearray(self._code)
+        code.append(OP_END)
+        for offset, label in self._fixups:
+            if label not in self._labels:
+                raise ValueError(f"Etiqueta sin definir: {label}")
+            code[offset] = self._labels[label]
+        if len(code) > SLOT_SIZE:
+            raise ValueError(f"Programa de {len(code)} bytes (máximo {SLOT_SIZE})")
+        return bytes(code)
+
+
+def upload_frames(slot: int, code: bytes) -> List[str]:
+    """Comandos MU:<slot>,<offset>,<hex> que cargan el programa completo."""
+    return [f"MU:{slot},{offset},{code[offset:offset + UPLOAD_CHUNK].hex().upper()}"
+            for offset in range(0, len(code), UPLOAD_CHUNK)]
+
+
+def pick_and_place(plant_mm: Tuple[int, int], deposit_mm: Tuple[int, int],
+                   lower: Tuple[int, int], raise_: Tuple[int, int], arm_time_ms: int = 1000,
+                   return_mm: Optional[Tuple[int, int]] = None) -> MacroProgram:
+    """Ciclo de cosecha con desplazamientos relativos (mm): ir a la planta,
+    bajar, cerrar, subir, ir al depósito, abrir y opcionalmente volver.
+    lower/raise_ son los ángulos (servo1, servo2) del brazo. Si un final de
+    carrera cortó el movimiento a la planta el programa termina ahí."""
+    p = MacroProgram()
+    p.arm(*raise_, arm_time_ms).wait(WAIT_SERVO)
+    p.move(*plant_mm).wait(WAIT_MOTION)
+    p.if_limit(LIMIT_H_LEFT | LIMIT_H_RIGHT | LIMIT_V_UP | LIMIT_V_DOWN, 'end')
+    p.gripper_open().arm(*lower, arm_time_ms).wait(WAIT_SERVO | WAIT_GRIPPER)
+    p.gripper_close().wait(WAIT_GRIPPER)
+    p.arm(*raise_, arm_time_ms).wait(WAIT_SERVO)
+    p.move(*deposit_mm).wait(WAIT_MOTION)
+    p.gripper_open().wait(WAIT_GRIPPER)
+    if return_mm is not None:
+        p.move(*return_mm).wait(WAIT_MOTION)
+    p.label('end')
+    return p
@@ -0,0 +1,41 @@
+from typing import Dict
+
+# Catálogo de mensajes del firmware (command/message_catalog.h). En modo ID
+# (MI:1) las líneas llegan como "#<id>[:params]" y se expanden con la tabla
+# que devuelve MC?: "MSG:<id>,<texto>" por entrada y "OK:CATALOG:<n>".
+
+
+class MessageCatalog:
+    def __init__(self):
+        self._texts: Dict[int, str] = {}
+
+    @property
+    def loaded(self) -> bool:
+        return bool(self._texts)
+
+    def load_from_response(self, response: str) -> int:
+        texts = {}
+        for line in response.splitlines():
+            if not line.startswith("MSG:"):
+                continue
+            try:
+                msg_id, text = line[4:].split(',', 1)
+                texts[int(msg_id)] = text
+            except ValueError:
+                continue
+        self._texts = texts
+        return len(texts)
+
+    def expand(self, line: str) -> str:
+        """'#5:1,2' -> 'STEPPER_MOVE_COMPLETED:1,2'. Las líneas de texto pasan sin cambios."""
+        if not line.startswith('#'):
+            return line
+        end = 1
+        while end < len(line) and line[end].isdigit():
+            end += 1
+        if end == 1:
+            return line
+        text = self._texts.get(int(line[1:end]))
+        if text is None:
+            return line
+        return text + line[end:]
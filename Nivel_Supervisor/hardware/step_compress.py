@@ -0,0 +1,103 @@
+from typing import Iterable, List, Sequence, Tuple
+
+# Compresión de pasos para la cola QA/QG del firmware (drivers/step_queue.h).
+# Un segmento (interval, count, add) genera count pasos: el primero
+# `interval` us después del paso anterior y cada siguiente `add` us más
+# tarde que el anterior. count negativo = sentido negativo; count 0 = pausa
+# de `interval` us sin pulso.
+
+MIN_INTERVAL_US = 50        # STEP_QUEUE_MIN_INTERVAL_US (MAX_STEP_RATE 20000)
+MAX_INTERVAL_US = 32767     # STEP_QUEUE_MAX_INTERVAL_US
+FIT_MAX_COUNT = 1000        # Tope de la búsqueda (cuadrática) por segmento
+SEGMENTS_PER_FRAME = 8      # STEP_QUEUE_MAX_PER_FRAME
+FRAME_MAX_LEN = 120         # Margen dentro de UART_BUFFER_SIZE (128)
+
+Segment = Tuple[int, int, int]
+
+
+def _pauses(gap_us: int) -> List[Segment]:
+    # Hueco más largo que un intervalo: pausas hasta dejar el último paso a tiro
+    segments = []
+    while gap_us > MAX_INTERVAL_US:
+        pause = min(MAX_INTERVAL_US, gap_us - MIN_INTERVAL_US)
+        segments.append((pause, 0, 0))
+        gap_us -= pause
+    return segments
+
+
+def _fit(times: Sequence[int], start: int, last: int, max_error: int) -> Tuple[int, int, int]:
+    """Segmento más largo desde times[start] (misma dirección) con error <= max_error."""
+    interval = times[start] - last
+    best = (interval, 1, 0)
+    n = 2
+    while start + n <= len(times) and n <= FIT_MAX_COUNT:
+        # add que hace coincidir el último paso del tramo, luego verificar todos
+        span = times[start + n - 1] - last
+        add = round((span - n * interval) / (n * (n - 1) / 2))
+        t = last
+        ok = True
+        for k in range(n):
+            step_interval = interval + k * add
+            if not MIN_INTERVAL_US <= step_interval <= MAX_INTERVAL_US:
+                ok = False
+                break
+            t += step_interval
+            if abs(t - times[start + k]) > max_error:
+                ok = False
+                break
+        if not ok:
+            break
+        best = (interval, n, add)
+        n += 1
+    return best
+
+
+def compress_steps(steps: Iterable[Tuple[float, int]], max_error_us: int = 2) -> List[Segment]:
+    """steps: (tiempo_us desde el arranque, +1|-1) ordenados. Devuelve los segmentos.
+
+    Cada paso queda a menos de max_error_us de su tiempo ideal (sin contar
+    el redondeo a us). Los pasos más juntos que MIN_INTERVAL_US se rechazan."""
+    events = [(int(round(t)), 1 if d > 0 else -1) for t, d in steps]
+    segments: List[Segment] = []
+    last = 0
+    i = 0
+    while i < len(events):
+        direction = events[i][1]
+        j = i
+        while j < len(events) and events[j][1] == direction:
+            j += 1
+        times = [t for t, _ in events[i:j]]
+
+        k = 0
+        while k < len(times):
+            gap = times[k] - last
+            if gap < MIN_INTERVAL_US:
+                raise ValueError(f"Pasos a {gap}us: más rápido que {MIN_INTERVAL_US}us")
+            pauses = _pauses(gap)
+            segments.extend(pauses)
+            last += sum(p[0] for p in pauses)
+
+            interval, count, add = _fit(times, k, last, max_error_us)
+            segments.append((interval, count * direction, add))
+            last += count * interval + add * count * (count - 1) // 2
+            k += count
+        i = j
+    return segments
+
+
+def segment_frames(axis: str, segments: Sequence[Segment]) -> List[str]:
+    """Comandos QA:<eje>,i,c,a,... con hasta SEGMENTS_PER_FRAME segmentos."""
+    frames = []
+    current = f"QA:{axis}"
+    n = 0
+    for interval, count, add in segments:
+        token = f",{interval},{count},{add}"
+        if n == SEGMENTS_PER_FRAME or len(current) + len(token) > FRAME_MAX_LEN:
+            frames.append(current)
+            current = f"QA:{axis}"
+            n = 0
+        current += token
+        n += 1
+    if n:
+        frames.append(current)
+    return frames
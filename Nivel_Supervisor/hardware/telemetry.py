@@ -0,0 +1,49 @@
+import struct
+from typing import Optional, Dict
+
+# Tramas binarias del firmware (command/telemetry.h):
+#   [0xA5][topic][seq][len][t_us:4][payload:len][checksum]
+TELEMETRY_SYNC = 0xA5
+HEADER_SIZE = 8
+
+TOPIC_IDS = {'POS': 0, 'LIM': 1, 'SRV': 2, 'GRP': 3, 'QUE': 4, 'TIM': 5}
+
+_LAYOUTS = {
+    0: ('<iiHHB', ('h_steps', 'v_steps', 'h_speed', 'v_speed', 'flags')),
+    1: ('<B', ('bitmap',)),
+    2: ('<BBBBB', ('servo1', 'servo2', 'target1', 'target2', 'moving')),
+    3: ('<hB', ('steps', 'state')),
+    4: ('<BH', ('trigger_pending', 'trigger_dropped')),
+    5: ('<HHH', ('loop_max_us', 'loop_avg_us', 'loops')),
+}
+
+_TOPIC_NAMES = {v: k for k, v in TOPIC_IDS.items()}
+
+
+def read_frame(ser) -> Optional[Dict]:
+    """Lee una trama tras el byte de sincronía ya consumido. None si es inválida."""
+    header = ser.read(HEADER_SIZE - 1)
+    if len(header) != HEADER_SIZE - 1:
+        return None
+    topic, seq, length = header[0], header[1], header[2]
+    body = ser.read(length + 1)
+    if len(body) != length + 1:
+        return None
+    checksum = 0
+    for b in header + body[:-1]:
+        checksum ^= b
+    if checksum != body[-1]:
+        return None
+    layout = _LAYOUTS.get(topic)
+    if layout is None or struct.calcsize(layout[0]) != length:
+        return None
+    values = struct.unpack(layout[0], body[:-1])
+    frame = dict(zip(layout[1], values))
+    frame['topic'] = _TOPIC_NAMES[topic]
+    frame['seq'] = seq
+    frame['timestamp_us'] = struct.unpack('<I', header[3:7])[0]
+    if topic == 1:
+        bits = frame['bitmap']
+        frame.update({'H_LEFT': bool(bits & 1), 'H_RIGHT': bool(bits & 2),
+                      'V_UP': bool(bits & 4), 'V_DOWN': bool(bits & 8)})
+    return frame
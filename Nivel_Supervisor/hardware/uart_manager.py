@@ -4,8 +4,16 @@ import logging
 from typing import Optional, Dict, Callable
 from threading import Lock, Thread, Event
 import queue
+import struct
 import threading
 from config.robot_config import RobotConfig
+from .clock_sync import parse_event_timestamp
+from . import telemetry
+from .message_catalog import MessageCatalog
+from .command_pipeline import CommandPipeline, split_seq
+
+# Parada rápida (UART_ESTOP_BYTE del firmware): byte suelto, atendido en la ISR
+FAST_STOP_BYTE = b'\x18'
 
 class UARTManager:
     def __init__(self, port: str, baud_rate: int = 115200, timeout: float = 2.0):
@@ -25,10 +33,21 @@ class UARTManager:
         self.waiting_for_completion = {}
         self.completed_actions_recent = {}
         self._action_last_started = {}
+        self._action_fw_timestamps = {}
         self._last_movement_snapshots = []
         self._snap_header_printed = False
         self._movement_snapshots_by_id = {}
         self._movement_seen_ids = set()
+        self._trigger_events = []
+        self._history_records = []
+        self._history_ready = Event()
+        self._pong_ready = Event()
+        self._pong = None
+        self._telemetry_latest = {}
+        self._telemetry_errors = 0
+        self.catalog = MessageCatalog()
+        self._message_ids = False  # Modo de cabeceras que espera el host (MI)
+        self.pipeline = CommandPipeline()
         self._limit_status = {
             'H_LEFT': False,
             'H_RIGHT': False,
@@ -54,7 +73,11 @@ class UARTManager:
 
             self.logger.info(f"Conectado a {self.port}")
             try:
+                # Tras una caída del host el firmware puede seguir en modo ID:
+                # fijar el modo esperado antes de cualquier otro comando
+                self.enable_message_ids(self._message_ids)
                 self.send_command("HB:0")
+                self._init_pipeline()
             except Exception:
                 pass
             return True
@@ -65,6 +88,8 @@ class UARTManager:
     def disconnect(self):
         try:
             self.send_command("HB:0")
+            self.send_command("TS:OFF")
+            self.send_command("MI:0")
         except Exception:
             pass
         self.stop_listening.set()
@@ -84,7 +109,27 @@ class UARTManager:
         while not self.stop_listening.is_set():
             try:
                 if self.ser and self.ser.in_waiting:
-                    line = self.ser.readline().decode('ascii', errors='ignore').strip()
+                    first = self.ser.read(1)
+                    if first and first[0] == telemetry.TELEMETRY_SYNC:
+                        self._read_telemetry_frame()
+                        continue
+                    line = (first + self.ser.readline()).decode('ascii', errors='ignore').strip()
+                    seq, line = split_seq(line)
+                    line = self.catalog.expand(line)
+                    if seq is not None:
+                        # ACK o fin de un comando en vuelo: no es respuesta de send_command
+                        self.logger.debug(f"RX[{seq}]: {line}")
+                        if self.pipeline.on_line(seq, line):
+                            self._process_automatic_message(line)
+                        continue
+                    if line.startswith("HISTORY_BIN:"):
+                        self._read_history_records(line)
+                        continue
+                    if line.startswith("PONG:"):
+                        # Marca de recepción lo antes posible para la sincronización de reloj
+                        self._pong = (line, time.time())
+                        self._pong_ready.set()
+                        continue
                     if line:
                         self.logger.debug(f"RX: {line}")
                         self.message_queue.put(line)
@@ -101,6 +146,7 @@ class UARTManager:
             action_type = message.split("_COMPLETED:")[0]
             try:
                 self.completed_actions_recent[action_type] = time.time()
+                self._action_fw_timestamps[action_type] = parse_event_timestamp(message)
             except Exception:
                 pass
 
@@ -202,6 +248,9 @@ class UARTManager:
                 
         elif "MOVEMENT_SNAPSHOTS:" in message:
             self._process_movement_snapshots(message)
+
+        elif message.startswith("TRIGGER_EVENT:"):
+            self._process_trigger_event(message)
             
     
     def wait_for_action_completion(self, action_type: str, timeout: float = 30.0) -> bool:
@@ -236,8 +285,8 @@ class UARTManager:
             if len(parts) >= 6:
                 rel_h_steps = int(parts[2].split(':')[1])
                 rel_v_steps = int(parts[3])
-                rel_h_mm = int(parts[4].split(':')[1])
-                rel_v_mm = int(parts[5])
+                rel_h_mm = float(parts[4].split(':')[1])
+                rel_v_mm = float(parts[5])
                 
                 if RobotConfig.SHOW_MOVEMENT_COMPLETE:
                     display_x_mm = RobotConfig.display_x_distance(rel_h_mm)
@@ -257,8 +306,8 @@ class UARTManager:
             if len(parts) >= 6:
                 rel_h_steps = int(parts[2].split(':')[1])
                 rel_v_steps = int(parts[3])
-                rel_h_mm = int(parts[4].split(':')[1])
-                rel_v_mm = int(parts[5])
+                rel_h_mm = float(parts[4].split(':')[1])
+                rel_v_mm = float(parts[5])
                 
                 print(f"Parada de emergencia: X={rel_h_mm}mm, Y={rel_v_mm}mm")
         except Exception as e:
@@ -283,8 +332,8 @@ class UARTManager:
                         flag = snapshot.split('=')[0].strip()
                         coords = snapshot.split('=')[1].split(',')
                         if len(coords) >= 2:
-                            x_mm = int(coords[0])
-                            y_mm = int(coords[1])
+                            x_mm = float(coords[0])
+                            y_mm = float(coords[1])
                             snap_id = None
                             if flag and (flag[0] in ('S', 's')):
                                 try:
@@ -312,6 +361,96 @@ class UARTManager:
             if RobotConfig.VERBOSE_LOGGING:
                 self.logger.warning(f"Error procesando snapshots: {e}")
 
+    def _process_trigger_event(self, message: str):
+        try:
+            payload = message.split("TRIGGER_EVENT:")[1]
+            axis, index, position, ts = payload.split(',')
+            self._trigger_events.append({
+                'axis': axis,
+                'index': int(index),
+                'position_steps': int(position),
+                'timestamp_us': int(ts.split('=')[1]),
+            })
+        except Exception as e:
+            if RobotConfig.VERBOSE_LOGGING:
+                self.logger.warning(f"Error procesando evento de disparo: {e}")
+
+    def _read_history_records(self, header: str):
+        # Cabecera de texto seguida de n registros binarios <uint32 t_us, int32 h, int32 v>
+        try:
+            count = int(header.split(':')[1])
+            data = self.ser.read(count * 12)
+            self._history_records = [struct.unpack_from('<Iii', data, i * 12)
+                                     for i in range(len(data) // 12)]
+        except Exception as e:
+            self._history_records = []
+            if RobotConfig.VERBOSE_LOGGING:
+                self.logger.warning(f"Error leyendo historial binario: {e}")
+        self._history_ready.set()
+
+    def _read_telemetry_frame(self):
+        frame = telemetry.read_frame(self.ser)
+        if frame is None:
+            self._telemetry_errors += 1
+            return
+        self._telemetry_latest[frame['topic']] = frame
+        if "telemetry_callback" in self.message_callbacks:
+            self.message_callbacks["telemetry_callback"](frame)
+
+    def get_telemetry(self, topic: str):
+        # Última trama recibida del tópico (POS, LIM, SRV, GRP, QUE, TIM)
+        return self._telemetry_latest.get(topic)
+
+    def request_position_history(self, from_us: int, to_us: int, timeout: float = 2.0):
+        if not self.ser or not self.ser.is_open:
+            return None
+        self._history_ready.clear()
+        with self.lock:
+            self.ser.write(f"<PD:{int(from_us)},{int(to_us)}>".encode('utf-8'))
+        if not self._history_ready.wait(timeout):
+            return None
+        return list(self._history_records)
+
+    def ping_firmware(self, token: int, timeout: float = 0.5):
+        # Devuelve (t0_host, t1_fw_us, t2_fw_us, t3_host, bytes_enviados, bytes_recibidos)
+        if not self.ser or not self.ser.is_open:
+            return None
+        frame = f"<TP:{int(token)}>".encode('utf-8')
+        self._pong_ready.clear()
+        with self.lock:
+            t0 = time.time()
+            self.ser.write(frame)
+        if not self._pong_ready.wait(timeout):
+            return None
+        line, t3 = self._pong
+        try:
+            echoed, t1_us, t2_us = line.split("PONG:")[1].split(',')
+            if int(echoed) != int(token):
+                return None
+            return t0, int(t1_us), int(t2_us), t3, len(frame), len(line) + 2
+        except Exception:
+            return None
+
+    def enable_message_ids(self, enabled: bool = True) -> bool:
+        self._message_ids = enabled
+        # Descargar la tabla antes de activar el modo ID para poder expandir las cabeceras
+        if enabled and not self.catalog.loaded:
+            result = self.send_command("MC?")
+            if not result.get("success") or not self.catalog.load_from_response(result.get("response", "")):
+                self.logger.warning("No se pudo cargar el catálogo de mensajes")
+                return False
+        result = self.send_command(f"MI:{1 if enabled else 0}")
+        return bool(result.get("success")) and "OK:MSG_IDS" in result.get("response", "")
+
+    def get_last_event_timestamp(self, action_type: str) -> Optional[int]:
+        return self._action_fw_timestamps.get(action_type)
+
+    def get_trigger_events(self, clear: bool = True):
+        events = list(self._trigger_events)
+        if clear:
+            self._trigger_events.clear()
+        return events
+
     def get_last_snapshots(self):
         try:
             return list(self._last_movement_snapshots)
@@ -332,6 +471,8 @@ class UARTManager:
         if not self.ser or not self.ser.is_open:
             return {"success": False, "error": "Puerto no conectado"}
         
+        if not self.pipeline.acquire_credit(self.timeout):
+            return {"success": False, "error": "Sin créditos (firmware sin slots libres)"}
         with self.lock:
             try:
                 self._clear_message_queue()
@@ -340,7 +481,7 @@ class UARTManager:
                 self.ser.write(cmd_formatted.encode('utf-8'))
                 self.logger.debug(f"TX: {command}")
 
-                time.sleep(0.1)
+                # El firmware encola los frames (UART_FRAME_SLOTS): no hace falta pausar
                 response = self._read_command_response()
                 
                 return {"success": True, "response": response}
@@ -348,6 +489,58 @@ class UARTManager:
             except Exception as e:
                 self.logger.error(f"Error enviando comando: {e}")
                 return {"success": False, "error": str(e)}
+            finally:
+                self.pipeline.release_credit()
+
+    def send_command_async(self, command: str) -> Optional[int]:
+        """Envía <seq|command> sin esperar respuesta; devuelve seq (None si no hay crédito).
+
+        La respuesta se obtiene con wait_for_ack(seq) y el fin de la acción
+        iniciada con wait_for_sequence(seq)."""
+        if not self.ser or not self.ser.is_open:
+            return None
+        if not self.pipeline.acquire_credit(self.timeout):
+            return None
+        seq = self.pipeline.register(command)
+        try:
+            with self.lock:
+                self.ser.write(f"<{seq}|{command}>".encode('utf-8'))
+            self.logger.debug(f"TX[{seq}]: {command}")
+        except Exception as e:
+            self.pipeline.release_credit()
+            self.logger.error(f"Error enviando comando: {e}")
+            return None
+        return seq
+
+    def send_fast_stop(self) -> bool:
+        # Sin el lock: no espera a que termine otro envío ni su respuesta. Si
+        # cae dentro de un frame, el firmware lo abandona y para igual
+        if not self.ser or not self.ser.is_open:
+            return False
+        try:
+            self.ser.write(FAST_STOP_BYTE)
+            self.ser.flush()
+            return True
+        except Exception as e:
+            self.logger.error(f"Error enviando parada rápida: {e}")
+            return False
+
+    def wait_for_ack(self, seq: int, timeout: Optional[float] = None) -> Optional[str]:
+        return self.pipeline.wait_ack(seq, self.timeout if timeout is None else timeout)
+
+    def wait_for_sequence(self, seq: int, timeout: float = 30.0) -> Optional[str]:
+        # Línea que cerró la acción (MOVE_COMPLETED, parada, etc.) o None
+        return self.pipeline.wait_completion(seq, timeout)
+
+    def _init_pipeline(self):
+        # Tantos comandos en vuelo como slots de recepción del firmware. Con
+        # secuencia la respuesta llega como ACK (sin esperar OK:/ERR:)
+        seq = self.send_command_async("RX?")
+        line = self.wait_for_ack(seq) if seq is not None else None
+        if line and "SLOTS=" in line:
+            slots = int(line.split("SLOTS=")[1].split(',')[0])
+            self.pipeline.set_credits(slots)
+            self.logger.debug(f"Créditos de comandos: {slots}")
     
     def _clear_message_queue(self):
         while not self.message_queue.empty():
@@ -517,6 +710,27 @@ class UARTManager:
 
         print("Reset del UART manager completado")
 
+    def send_gcode_line(self, line: str, timeout: float = 10.0) -> Optional[str]:
+        # Línea G-code sin '<' '>': el firmware responde "ok" al encolarla (o
+        # cuando hay sitio) y "error:..." si la descarta
+        if not self.ser or not self.ser.is_open:
+            return None
+        with self.lock:
+            self.ser.write((line.strip() + '\n').encode('ascii'))
+        return self.wait_for_line(("ok", "error:"), timeout)
+
+    def wait_for_line(self, prefixes, timeout: float = 10.0) -> Optional[str]:
+        # Primera línea asíncrona que empiece con alguno de los prefijos
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            try:
+                message = self.message_queue.get(timeout=0.5)
+            except queue.Empty:
+                continue
+            if message.startswith(tuple(prefixes)):
+                return message
+        return None
+
     def wait_for_message(self, expected_message: str, timeout: float = 10.0) -> bool:
         start_time = time.time()
 
@@ -407,6 +407,8 @@ class ArmController:
         self.lettuce_on = has_lettuce
         estado = "CON lechuga" if has_lettuce else "SIN lechuga"
         self.logger.info(f"Estado de lechuga actualizado: {estado}")
+        # Velocidades del firmware acordes a la carga (suaves con lechuga)
+        self.cmd.set_motion_preset("LOADED" if has_lettuce else "EMPTY")
 
     def get_lettuce_state(self) -> bool:
         return self.lettuce_on
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Pruebas de la sincronización de reloj host<->firmware (hardware/clock_sync.py)
+"""
+
+import os
+import sys
+import unittest
+from unittest import mock
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+from hardware.clock_sync import ClockSync, parse_event_timestamp, FW_CLOCK_WRAP
+
+
+class FakeFirmware:
+    """Simula TP:/PONG con un reloj de firmware de offset y deriva conocidos.
+
+    t_fw = t_host + offset + drift * t_host (segundos). Los retardos del
+    listener se agregan a la vuelta, que es lo que filtra el mínimo RTT.
+    """
+
+    LATENCY = 0.0005      # s, ida y vuelta simétricas
+    PROCESSING = 0.0002   # s entre t1 y t2
+    REQUEST_LEN = 12
+    RESPONSE_LEN = 24
+
+    def __init__(self, offset, drift=0.0, slow_every=0):
+        self.baud_rate = 115200
+        self.offset = offset
+        self.drift = drift
+        self.slow_every = slow_every
+        self.now = 1000.0
+        self.pings = 0
+
+    def fw_us(self, t_host):
+        t_fw = t_host + self.offset + self.drift * t_host
+        return int(round(t_fw * 1e6)) % FW_CLOCK_WRAP
+
+    def byte_time(self, n):
+        return n * 10.0 / self.baud_rate
+
+    def ping_firmware(self, token):
+        self.pings += 1
+        t0 = self.now
+        t_rx = t0 + self.byte_time(self.REQUEST_LEN) + self.LATENCY
+        t_tx = t_rx + self.PROCESSING
+        extra = 0.005 if self.slow_every and self.pings % self.slow_every else 0.0
+        t3 = t_tx + self.byte_time(self.RESPONSE_LEN) + self.LATENCY + extra
+        self.now = t3 + 0.001
+        return t0, self.fw_us(t_rx), self.fw_us(t_tx), t3, self.REQUEST_LEN, self.RESPONSE_LEN
+
+
+@mock.patch('hardware.clock_sync.time.sleep', lambda s: None)
+class ClockSyncTest(unittest.TestCase):
+
+    def test_not_synced(self):
+        sync = ClockSync(FakeFirmware(offset=5.0))
+        self.assertIsNone(sync.fw_to_host(123))
+        self.assertIsNone(sync.host_to_fw(1000.0))
+
+    def test_no_answers(self):
+        uart = mock.Mock(baud_rate=115200)
+        uart.ping_firmware.return_value = None
+        sync = ClockSync(uart)
+        self.assertFalse(sync.sync(samples=4))
+        self.assertFalse(sync.synced)
+
+    def test_offset_estimate(self):
+        fw = FakeFirmware(offset=-950.25)
+        sync = ClockSync(fw)
+        self.assertTrue(sync.sync())
+        self.assertAlmostEqual(sync.offset_at(fw.now), -950.25, delta=2e-6)
+        self.assertAlmostEqual(sync.drift_ppm, 0.0)
+
+    def test_min_rtt_filter_rejects_slow_replies(self):
+        # 3 de cada 4 respuestas llegan 5 ms tarde: solo cuentan las rápidas
+        fw = FakeFirmware(offset=12.0, slow_every=4)
+        sync = ClockSync(fw)
+        self.assertTrue(sync.sync(samples=16))
+        self.assertAlmostEqual(sync.offset_at(fw.now), 12.0, delta=2e-6)
+        self.assertAlmostEqual(sync.last_rtt, 2 * FakeFirmware.LATENCY, delta=2e-6)
+
+    def test_round_trip_conversion(self):
+        fw = FakeFirmware(offset=3.5)
+        sync = ClockSync(fw)
+        sync.sync()
+        t_host = fw.now + 0.25
+        fw_us = sync.host_to_fw(t_host)
+        self.assertAlmostEqual(sync.fw_to_host(fw_us), t_host, delta=2e-6)
+        self.assertAlmostEqual(sync.fw_to_host(fw.fw_us(t_host)), t_host, delta=2e-6)
+
+    def test_drift_fit(self):
+        fw = FakeFirmware(offset=1.0, drift=50e-6)
+        sync = ClockSync(fw)
+        for _ in range(5):
+            sync.sync()
+            fw.now += 30.0
+        self.assertAlmostEqual(sync.drift_ppm, 50.0, delta=1.0)
+        t_host = fw.now + 10.0
+        self.assertAlmostEqual(sync.fw_to_host(fw.fw_us(t_host)), t_host, delta=5e-6)
+
+    def test_short_history_has_no_drift(self):
+        # Menos de MIN_DRIFT_SPAN_S de historia: solo offset
+        fw = FakeFirmware(offset=1.0, drift=50e-6)
+        sync = ClockSync(fw)
+        sync.sync()
+        fw.now += 10.0
+        sync.sync()
+        self.assertEqual(sync.drift_ppm, 0.0)
+
+    def test_wrap_of_firmware_clock(self):
+        # El reloj de 32 bits da la vuelta entre dos sincronizaciones
+        wrap_s = FW_CLOCK_WRAP / 1e6
+        fw = FakeFirmware(offset=wrap_s - 1000.0 - 1.0)
+        sync = ClockSync(fw)
+        sync.sync()
+        fw.now += 2.0
+        sync.sync()
+        t_host = fw.now + 0.1
+        raw = fw.fw_us(t_host)
+        self.assertLess(raw, 10 * 10**6)
+        self.assertAlmostEqual(sync.fw_to_host(raw), t_host, delta=2e-6)
+
+
+class ParseEventTimestampTest(unittest.TestCase):
+
+    def test_with_payload(self):
+        self.assertEqual(parse_event_timestamp("STEPPER_MOVE_COMPLETED:10,20,T=123456"), 123456)
+
+    def test_without_payload(self):
+        self.assertEqual(parse_event_timestamp("GRIPPER_ACTION_COMPLETED:T=42"), 42)
+
+    def test_missing_or_invalid(self):
+        self.assertIsNone(parse_event_timestamp("STEPPER_MOVE_COMPLETED:10,20"))
+        self.assertIsNone(parse_event_timestamp("PARAM:AT=5"))
+        self.assertIsNone(parse_event_timestamp("EVENT:T=abc"))
+
+
+if __name__ == '__main__':
+    unittest.main()
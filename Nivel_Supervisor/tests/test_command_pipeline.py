@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Pruebas de los comandos en vuelo con secuencia y créditos (hardware/command_pipeline.py)
+"""
+
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+from hardware.command_pipeline import (
+    CommandPipeline, split_seq, command_actuators, MAX_PENDING, SEQ_MODULO,
+)
+
+
+class SplitSeqTest(unittest.TestCase):
+
+    def test_with_prefix(self):
+        self.assertEqual(split_seq("17|OK:MOVE_XY:1,2"), (17, "OK:MOVE_XY:1,2"))
+
+    def test_without_prefix(self):
+        self.assertEqual(split_seq("SYSTEM_READY"), (None, "SYSTEM_READY"))
+        self.assertEqual(split_seq("|OK"), (None, "|OK"))
+        self.assertEqual(split_seq("A1|OK"), (None, "A1|OK"))
+
+
+class CommandActuatorsTest(unittest.TestCase):
+
+    def test_single(self):
+        self.assertEqual(command_actuators("M:100,50"), {'MOTION'})
+        self.assertEqual(command_actuators("RA"), {'SERVO'})
+        self.assertEqual(command_actuators("PG:MICROSTEPS"), set())
+
+    def test_batch(self):
+        self.assertEqual(command_actuators("M:10,0;A:45,90,500;GT"), {'MOTION', 'SERVO', 'GRIPPER'})
+
+
+class CommandPipelineTest(unittest.TestCase):
+
+    def test_sequence_wraps_and_skips_zero(self):
+        pipeline = CommandPipeline()
+        pipeline._next_seq = SEQ_MODULO - 1
+        self.assertEqual(pipeline.register("I?"), SEQ_MODULO - 1)
+        self.assertEqual(pipeline.register("I?"), 1)
+
+    def test_ack_returns_credit(self):
+        pipeline = CommandPipeline(credits=1)
+        self.assertTrue(pipeline.acquire_credit(timeout=0))
+        self.assertFalse(pipeline.acquire_credit(timeout=0))
+        seq = pipeline.register("I?")
+        self.assertFalse(pipeline.on_line(seq, "OK:INFO"))
+        self.assertTrue(pipeline.acquire_credit(timeout=0))
+        self.assertEqual(pipeline.wait_ack(seq, timeout=0), "OK:INFO")
+
+    def test_duplicate_ack_returns_one_credit(self):
+        pipeline = CommandPipeline(credits=1)
+        pipeline.acquire_credit(timeout=0)
+        seq = pipeline.register("M:1,1")
+        pipeline.on_line(seq, "OK:MOVE_XY")
+        pipeline.on_line(seq, "OK:MOVE_XY")
+        self.assertTrue(pipeline.acquire_credit(timeout=0))
+        self.assertFalse(pipeline.acquire_credit(timeout=0))
+
+    def test_ack_timeout_recovers_credit(self):
+        pipeline = CommandPipeline(credits=1)
+        pipeline.acquire_credit(timeout=0)
+        seq = pipeline.register("M:1,1")
+        self.assertIsNone(pipeline.wait_ack(seq, timeout=0.01))
+        self.assertTrue(pipeline.acquire_credit(timeout=0))
+
+    def test_unknown_sequence_is_ignored(self):
+        pipeline = CommandPipeline()
+        self.assertFalse(pipeline.on_line(99, "OK:MOVE_XY"))
+        self.assertIsNone(pipeline.wait_ack(99, timeout=0))
+
+    def test_completion(self):
+        pipeline = CommandPipeline()
+        seq = pipeline.register("M:100,50")
+        pipeline.on_line(seq, "OK:MOVE_XY:100,50")
+        self.assertEqual(pipeline.wait_ack(seq, timeout=0), "OK:MOVE_XY:100,50")
+        self.assertTrue(pipeline.on_line(seq, "STEPPER_MOVE_COMPLETED:100,50"))
+        self.assertEqual(pipeline.wait_completion(seq, timeout=0), "STEPPER_MOVE_COMPLETED:100,50")
+        # Consumido: no queda pendiente
+        self.assertIsNone(pipeline.wait_completion(seq, timeout=0))
+
+    def test_batch_waits_for_every_actuator(self):
+        pipeline = CommandPipeline()
+        seq = pipeline.register("M:10,0;A:45,90,500")
+        pipeline.on_line(seq, "OK:BATCH")
+        pipeline.on_line(seq, "SERVO_MOVE_COMPLETED:45,90")
+        pipeline.on_line(seq, "STEPPER_MOVE_COMPLETED:10,0")
+        lines = pipeline.wait_completion(seq, timeout=0).split('\n')
+        self.assertEqual(sorted(lines), ["SERVO_MOVE_COMPLETED:45,90", "STEPPER_MOVE_COMPLETED:10,0"])
+
+    def test_batch_partial_completion_times_out(self):
+        pipeline = CommandPipeline()
+        seq = pipeline.register("M:10,0;GT")
+        pipeline.on_line(seq, "OK:BATCH")
+        pipeline.on_line(seq, "STEPPER_MOVE_COMPLETED:10,0")
+        self.assertIsNone(pipeline.wait_completion(seq, timeout=0.01))
+
+    def test_newer_completion_closes_older(self):
+        # Un M nuevo reemplaza al anterior: su fin cierra ambas secuencias
+        pipeline = CommandPipeline()
+        first = pipeline.register("M:100,0")
+        second = pipeline.register("M:200,0")
+        pipeline.on_line(second, "STEPPER_MOVE_COMPLETED:200,0")
+        self.assertEqual(pipeline.wait_completion(first, timeout=0), "STEPPER_MOVE_COMPLETED:200,0")
+        self.assertEqual(pipeline.wait_completion(second, timeout=0), "STEPPER_MOVE_COMPLETED:200,0")
+
+    def test_older_completion_keeps_newer_open(self):
+        pipeline = CommandPipeline()
+        first = pipeline.register("M:100,0")
+        second = pipeline.register("M:200,0")
+        pipeline.on_line(first, "STEPPER_DECEL_STOP:50,0")
+        self.assertEqual(pipeline.wait_completion(first, timeout=0), "STEPPER_DECEL_STOP:50,0")
+        self.assertIsNone(pipeline.wait_completion(second, timeout=0.01))
+
+    def test_completion_across_sequence_wrap(self):
+        pipeline = CommandPipeline()
+        pipeline._next_seq = SEQ_MODULO - 1
+        old = pipeline.register("A:10,10,100")
+        new = pipeline.register("A:20,20,100")
+        self.assertEqual(new, 1)
+        pipeline.on_line(new, "SERVO_MOVE_COMPLETED:20,20")
+        self.assertIsNotNone(pipeline.wait_completion(old, timeout=0))
+
+    def test_other_actuator_does_not_close(self):
+        pipeline = CommandPipeline()
+        seq = pipeline.register("GT")
+        pipeline.on_line(seq + 1, "STEPPER_MOVE_COMPLETED:0,0")
+        self.assertIsNone(pipeline.wait_completion(seq, timeout=0.01))
+
+    def test_error_ack_drops_pending(self):
+        pipeline = CommandPipeline()
+        seq = pipeline.register("M:1,2")
+        pipeline.on_line(seq, "ERR:INVALID_PARAMS_MOVE")
+        self.assertEqual(pipeline.wait_ack(seq, timeout=0), "ERR:INVALID_PARAMS_MOVE")
+        self.assertIsNone(pipeline.wait_completion(seq, timeout=0))
+
+    def test_pending_is_bounded(self):
+        pipeline = CommandPipeline()
+        seqs = [pipeline.register("M:1,1") for _ in range(MAX_PENDING + 5)]
+        self.assertEqual(len(pipeline._pending), MAX_PENDING)
+        # Se descartan los más viejos
+        self.assertNotIn(seqs[0], pipeline._pending)
+        self.assertIn(seqs[-1], pipeline._pending)
+
+
+if __name__ == '__main__':
+    unittest.main()
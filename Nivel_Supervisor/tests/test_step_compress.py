@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Pruebas de la compresión de pasos para la cola QA/QG (hardware/step_compress.py)
+"""
+
+import os
+import sys
+import math
+import random
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+from hardware.step_compress import (
+    compress_steps, segment_frames,
+    MIN_INTERVAL_US, MAX_INTERVAL_US, SEGMENTS_PER_FRAME, FRAME_MAX_LEN,
+)
+
+
+def expand(segments):
+    """Pasos (tiempo_us, sentido) que genera el firmware al reproducir los segmentos."""
+    steps = []
+    t = 0
+    for interval, count, add in segments:
+        if count == 0:
+            t += interval
+            continue
+        direction = 1 if count > 0 else -1
+        for k in range(abs(count)):
+            step_interval = interval + k * add
+            assert MIN_INTERVAL_US <= step_interval <= MAX_INTERVAL_US, step_interval
+            t += step_interval
+            steps.append((t, direction))
+    return steps
+
+
+class StepCompressTest(unittest.TestCase):
+
+    def assert_within(self, steps, segments, max_error):
+        replayed = expand(segments)
+        self.assertEqual(len(replayed), len(steps))
+        for (t_ideal, d_ideal), (t, d) in zip(steps, replayed):
+            self.assertEqual(d, d_ideal)
+            self.assertLessEqual(abs(t - round(t_ideal)), max_error)
+
+    def test_constant_rate_is_one_segment(self):
+        steps = [(1000 * (k + 1), 1) for k in range(200)]
+        segments = compress_steps(steps)
+        self.assertEqual(segments, [(1000, 200, 0)])
+        self.assert_within(steps, segments, 0)
+
+    def test_constant_rate_negative(self):
+        steps = [(500 * (k + 1), -1) for k in range(10)]
+        self.assertEqual(compress_steps(steps), [(500, -10, 0)])
+
+    def test_accelerating_ramp(self):
+        # Aceleración constante desde reposo: t_k = sqrt(2k / a)
+        accel = 20000.0  # pasos/s²
+        steps = [(math.sqrt(2.0 * (k + 1) / accel) * 1e6 + 1000, 1) for k in range(400)]
+        segments = compress_steps(steps, max_error_us=2)
+        self.assert_within(steps, segments, 2)
+        self.assertLess(len(segments), len(steps) // 4)
+        # La rampa empieza con intervalos largos y termina con cortos
+        self.assertGreater(segments[0][0], 4 * segments[-1][0])
+
+    def test_single_step(self):
+        self.assertEqual(compress_steps([(750, 1)]), [(750, 1, 0)])
+        self.assertEqual(compress_steps([(750, -1)]), [(750, -1, 0)])
+
+    def test_empty(self):
+        self.assertEqual(compress_steps([]), [])
+
+    def test_direction_change_splits_segments(self):
+        steps = [(1000, 1), (2000, 1), (3000, -1), (4000, -1)]
+        segments = compress_steps(steps)
+        self.assertEqual(segments, [(1000, 2, 0), (1000, -2, 0)])
+        self.assert_within(steps, segments, 0)
+
+    def test_long_gap_uses_pauses(self):
+        steps = [(1000, 1), (1000 + 3 * MAX_INTERVAL_US, 1)]
+        segments = compress_steps(steps)
+        pauses = [s for s in segments if s[1] == 0]
+        self.assertTrue(pauses)
+        self.assertTrue(all(s[0] <= MAX_INTERVAL_US for s in pauses))
+        self.assert_within(steps, segments, 0)
+
+    def test_too_fast_is_rejected(self):
+        with self.assertRaises(ValueError):
+            compress_steps([(1000, 1), (1000 + MIN_INTERVAL_US - 1, 1)])
+
+    def test_max_interval_error(self):
+        # Tiempos con ruido: cada paso reproducido queda dentro del error pedido
+        rng = random.Random(1234)
+        t = 0.0
+        steps = []
+        for _ in range(500):
+            t += rng.uniform(200, 400)
+            steps.append((t, 1))
+        for max_error in (0, 1, 2, 5, 20):
+            segments = compress_steps(steps, max_error_us=max_error)
+            self.assert_within(steps, segments, max_error)
+
+    def test_larger_error_gives_fewer_segments(self):
+        rng = random.Random(99)
+        steps = [(1000 * (k + 1) + rng.uniform(-3, 3), 1) for k in range(300)]
+        tight = compress_steps(steps, max_error_us=0)
+        loose = compress_steps(steps, max_error_us=5)
+        self.assertLessEqual(len(loose), len(tight))
+        self.assert_within(steps, loose, 5)
+
+
+class SegmentFramesTest(unittest.TestCase):
+
+    def test_frame_limits(self):
+        segments = [(32767, -1000, -1000)] * 30
+        frames = segment_frames('H', segments)
+        tokens = 0
+        for frame in frames:
+            self.assertTrue(frame.startswith("QA:H,"))
+            self.assertLessEqual(len(frame), FRAME_MAX_LEN)
+            values = frame[len("QA:H,"):].split(',')
+            self.assertEqual(len(values) % 3, 0)
+            self.assertLessEqual(len(values) // 3, SEGMENTS_PER_FRAME)
+            tokens += len(values) // 3
+        self.assertEqual(tokens, len(segments))
+
+    def test_no_segments(self):
+        self.assertEqual(segment_frames('V', []), [])
+
+
+if __name__ == '__main__':
+    unittest.main()